@@ -35,6 +35,18 @@ int main() {
                     cout << "[RC INTERNAL] Got group: " << msg.groupid() << endl;
                     break;
                 }
+                case INTERNAL_GET_ALL_GROUPS_BATCH: {
+                    InternalGetAllGroupsBatch msg = cluon::extractMessage<InternalGetAllGroupsBatch>(std::move(envelope));
+
+                    cout << "[RC INTERNAL] Got groups, page " << msg.page() + 1 << " of " << msg.pageCount()
+                         << ", " << msg.total() << " cars in total" << endl;
+                    std::istringstream groups(msg.groups());
+                    std::string group;
+                    while (std::getline(groups, group)) {
+                        cout << "[RC INTERNAL]     " << group << endl;
+                    }
+                    break;
+                }
                 case INTERNAL_EMERGENCY_BRAKE: {
                     InternalEmergencyBrake msg = cluon::extractMessage<InternalEmergencyBrake>(std::move(envelope));
                     
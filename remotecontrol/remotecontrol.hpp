@@ -40,6 +40,10 @@ static const int INTERNAL_GET_ALL_GROUPS_REQUEST = 4004;
    announced car in the network. */
 static const int INTERNAL_GET_ALL_GROUPS_RESPONSE = 4005;
 
+/* The batched get all groups response lists all announced cars in one message, or a few pages of one if there are
+   many. Each line of groups is "<groupid>,<ip>,<ms since last announced>,<capabilities>". */
+static const int INTERNAL_GET_ALL_GROUPS_BATCH = 4008;
+
 // Emergency brake should tell all services to stop sending commands to the motor and steering.
 static const int INTERNAL_EMERGENCY_BRAKE = 4006;
 
@@ -0,0 +1,45 @@
+#include <chrono>
+
+#include "catch.hpp"
+
+#include "v2v/actuation_coalescer.hpp"
+
+using namespace std::chrono;
+
+TEST_CASE("ActuationCoalescer holds back repeated commands until the keep-alive is due.") {
+    ActuationCoalescer speed(0.01f, milliseconds(500));
+    TimeSource::time_point now;
+    REQUIRE(speed.shouldSend(0.0f, now));
+    for (int i = 1; i < 10; i++) {
+        REQUIRE_FALSE(speed.shouldSend(0.0f, now + milliseconds(50 * i)));
+    }
+    REQUIRE(speed.shouldSend(0.0f, now + milliseconds(500)));
+    REQUIRE(speed.sent() == 2);
+    REQUIRE(speed.suppressed() == 9);
+}
+
+TEST_CASE("ActuationCoalescer sends a change beyond the deadband, also when it adds up slowly.") {
+    ActuationCoalescer steering(0.01f, milliseconds(500));
+    TimeSource::time_point now;
+    REQUIRE(steering.shouldSend(0.2f, now));
+    REQUIRE_FALSE(steering.shouldSend(0.205f, now));
+    REQUIRE(steering.shouldSend(0.25f, now));
+    REQUIRE_FALSE(steering.shouldSend(0.254f, now));
+    REQUIRE_FALSE(steering.shouldSend(0.258f, now));
+    REQUIRE(steering.shouldSend(0.262f, now));
+    REQUIRE(steering.shouldSend(0.25f, now));
+}
+
+TEST_CASE("ActuationCoalescer always sends a stop or a start, and the first command after a reset.") {
+    ActuationCoalescer speed(0.05f, milliseconds(500));
+    TimeSource::time_point now;
+    REQUIRE(speed.shouldSend(0.02f, now));
+    REQUIRE(speed.shouldSend(0.0f, now));
+    REQUIRE(speed.shouldSend(0.02f, now));
+    REQUIRE_FALSE(speed.shouldSend(0.03f, now));
+
+    speed.reset();
+    REQUIRE(speed.shouldSend(0.03f, now));
+    REQUIRE(speed.sent() == 4);
+    REQUIRE(speed.suppressed() == 1);
+}
@@ -0,0 +1,108 @@
+#include <chrono>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "v2v/announce_scheduler.hpp"
+#include "v2v/time_source.hpp"
+
+using namespace std::chrono;
+
+/*
+ * Runs the scheduler in steps of 10 ms, announcing whenever it is due, and returns the announcement times.
+ */
+static std::vector<TimeSource::time_point> run(AnnounceScheduler &scheduler, ManualTimeSource &time,
+                                               milliseconds duration) {
+    std::vector<TimeSource::time_point> sent;
+    TimeSource::time_point end = time.now() + duration;
+    while (time.now() < end) {
+        time.advance(milliseconds(10));
+        if (scheduler.due(time.now())) {
+            scheduler.sent(time.now());
+            sent.push_back(time.now());
+        }
+    }
+    return sent;
+}
+
+TEST_CASE("AnnounceScheduler announces shortly after starting and backs off while nothing changes.") {
+    ManualTimeSource time;
+    AnnounceScheduler scheduler(milliseconds(1000), milliseconds(8000), 0.0, milliseconds(250), 1);
+    REQUIRE_FALSE(scheduler.due(time.now()));
+
+    TimeSource::time_point start = time.now();
+    scheduler.start(start);
+    std::vector<TimeSource::time_point> sent = run(scheduler, time, milliseconds(40000));
+
+    REQUIRE(sent.size() >= 6);
+    REQUIRE(sent[0] - start <= milliseconds(260));
+    // Without jitter the gaps are 1, 2, 4 and then 8 seconds, give or take the 10 ms steps.
+    milliseconds expected[] = {milliseconds(1000), milliseconds(2000), milliseconds(4000), milliseconds(8000),
+                               milliseconds(8000)};
+    for (size_t i = 0; i < 5; i++) {
+        REQUIRE(sent[i + 1] - sent[i] >= expected[i]);
+        REQUIRE(sent[i + 1] - sent[i] <= expected[i] + milliseconds(10));
+    }
+    REQUIRE(scheduler.interval() == milliseconds(8000));
+}
+
+TEST_CASE("AnnounceScheduler answers a new car quickly and starts over at the base period.") {
+    ManualTimeSource time;
+    AnnounceScheduler scheduler(milliseconds(1000), milliseconds(16000), 0.25, milliseconds(250), 2);
+    scheduler.start(time.now());
+    run(scheduler, time, milliseconds(60000));
+    REQUIRE(scheduler.interval() == milliseconds(16000));
+
+    TimeSource::time_point changed = time.now();
+    scheduler.peersChanged(changed);
+    REQUIRE(scheduler.interval() == milliseconds(1000));
+    REQUIRE(scheduler.nextAnnouncement() <= changed + milliseconds(250));
+
+    std::vector<TimeSource::time_point> sent = run(scheduler, time, milliseconds(2000));
+    REQUIRE(sent.size() >= 2);
+    REQUIRE(sent[0] - changed <= milliseconds(260));
+    REQUIRE(sent[1] - sent[0] >= milliseconds(750));
+    REQUIRE(sent[1] - sent[0] <= milliseconds(1260));
+}
+
+TEST_CASE("AnnounceScheduler jitters the intervals of cars started together.") {
+    ManualTimeSource time;
+    AnnounceScheduler first(milliseconds(2000), milliseconds(2000), 0.25, milliseconds(250), 11);
+    AnnounceScheduler second(milliseconds(2000), milliseconds(2000), 0.25, milliseconds(250), 12);
+    first.start(time.now());
+    second.start(time.now());
+
+    int together = 0;
+    int announcements = 0;
+    for (int step = 0; step < 6000; step++) {
+        time.advance(milliseconds(10));
+        bool firstDue = first.due(time.now());
+        bool secondDue = second.due(time.now());
+        if (firstDue) {
+            first.sent(time.now());
+            announcements++;
+        }
+        if (secondDue) {
+            second.sent(time.now());
+        }
+        together += firstDue && secondDue;
+    }
+    REQUIRE(announcements >= 25);
+    REQUIRE(announcements <= 40);
+    REQUIRE(together < announcements / 4);
+}
+
+TEST_CASE("AnnounceScheduler stays quiet while stopped.") {
+    ManualTimeSource time;
+    AnnounceScheduler scheduler(milliseconds(1000), milliseconds(8000), 0.25, milliseconds(250), 3);
+    scheduler.start(time.now());
+    scheduler.stop();
+
+    // Announcements on request and new cars do not start it again.
+    scheduler.sent(time.now());
+    scheduler.peersChanged(time.now());
+    REQUIRE(run(scheduler, time, milliseconds(10000)).empty());
+
+    scheduler.start(time.now());
+    REQUIRE(run(scheduler, time, milliseconds(300)).size() == 1);
+}
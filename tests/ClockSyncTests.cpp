@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+#include "catch.hpp"
+
+#include "v2v/clock_sync.hpp"
+#include "v2v/replay_scheduler.hpp"
+#include "v2v/time_source.hpp"
+
+using namespace std::chrono;
+
+/*
+ * Two simulated cars. The follower clock is the true time, the leader clock is off by an offset and drifts.
+ */
+struct SimulatedClocks {
+    int64_t offsetMicros;
+    double driftPpm;
+
+    int64_t leader(int64_t trueMicros) const {
+        return trueMicros + offsetMicros + (int64_t) (driftPpm * 1e-6 * (double) trueMicros);
+    }
+
+    int64_t offsetAt(int64_t trueMicros) const {
+        return leader(trueMicros) - trueMicros;
+    }
+
+    // An exchange starting at the given true time, with the given uplink, holding and downlink times.
+    bool exchange(ClockSync &sync, int64_t at, int64_t up, int64_t hold, int64_t down) const {
+        return sync.addSample(at, leader(at + up), leader(at + up + hold), at + up + hold + down);
+    }
+};
+
+TEST_CASE("ClockSync computes the offset of a symmetric exchange exactly.") {
+    SimulatedClocks clocks = {2500000, 0.0};
+    ClockSync sync;
+    REQUIRE_FALSE(sync.synced());
+
+    ClockSample sample;
+    REQUIRE(sync.addSample(1000000, clocks.leader(1003000), clocks.leader(1050000), 1053000, &sample));
+    REQUIRE(sample.offsetMicros == 2500000);
+    REQUIRE(sample.delayMicros == 6000);
+
+    REQUIRE(sync.synced());
+    REQUIRE(sync.offsetMicros(1053000) == 2500000);
+    // A leader update sent at 1060 ms of true time and received 4 ms later.
+    REQUIRE(sync.oneWayLatencyMicros(clocks.leader(1060000), 1064000) == 4000);
+}
+
+TEST_CASE("ClockSync rejects impossible exchanges.") {
+    ClockSync sync;
+    REQUIRE_FALSE(sync.addSample(0, 10, 20, 30));
+    REQUIRE_FALSE(sync.addSample(1000, 5000, 4000, 2000));
+    // The leader held the exchange longer than the whole round trip took.
+    REQUIRE_FALSE(sync.addSample(1000, 5000, 9000, 2000));
+    REQUIRE_FALSE(sync.synced());
+}
+
+TEST_CASE("ClockSync filters out asymmetric delays by picking the shortest round trip.") {
+    SimulatedClocks clocks = {-800000, 0.0};
+    ClockSync sync;
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int64_t> queueing(0, 30000);
+
+    int64_t worst = 0;
+    int exchanges = 0;
+    for (int64_t at = 1000000; at < 11000000; at += 500000) {
+        // Most exchanges are held up in one direction, which throws them off by half the hold up. Every fourth one
+        // gets through without queueing.
+        int64_t up = 1000 + (exchanges % 4 == 3 ? 0 : queueing(random));
+        int64_t down = 1000;
+        ClockSample sample;
+        REQUIRE(sync.addSample(at, clocks.leader(at + up), clocks.leader(at + up + 2000), at + up + 2000 + down,
+                               &sample));
+        worst = std::max(worst, std::abs(sample.offsetMicros - clocks.offsetAt(at)));
+        exchanges++;
+    }
+
+    int64_t now = 11000000;
+    REQUIRE(worst > 5000);
+    REQUIRE(std::abs(sync.offsetMicros(now) - clocks.offsetAt(now)) <= 100);
+}
+
+TEST_CASE("ClockSync estimates the drift once enough time is covered.") {
+    SimulatedClocks clocks = {150000, 50.0};
+    ClockSync sync;
+
+    // FollowerStatus messages go out at 2 Hz.
+    int64_t at = 1000000;
+    for (; at < 6000000; at += 500000) {
+        REQUIRE(clocks.exchange(sync, at, 1500, 1000, 1500));
+    }
+    REQUIRE(sync.driftPpm() == 0.0);
+
+    for (; at < 61000000; at += 500000) {
+        REQUIRE(clocks.exchange(sync, at, 1500, 1000, 1500));
+    }
+    REQUIRE(std::abs(sync.driftPpm() - 50.0) < 2.0);
+
+    // Extrapolated ten seconds past the last exchange.
+    int64_t later = at + 10000000;
+    REQUIRE(std::abs(sync.offsetMicros(later) - clocks.offsetAt(later)) <= 100);
+}
+
+TEST_CASE("ClockSync piggybacks on the status messages.") {
+    SimulatedClocks clocks = {-3000000, 0.0};
+    ClockSync leaderSide;
+    ClockSync followerSide;
+
+    // A leader that never got a FollowerStatus, or a car of another group, gives nothing to estimate from.
+    LeaderStatus legacy;
+    legacy.timestamp(12345);
+    REQUIRE_FALSE(followerSide.processLeaderStatus(legacy, 5000000));
+
+    FollowerStatus followerStatus;
+    followerSide.stampFollowerStatus(followerStatus, 5000000);
+    leaderSide.processFollowerStatus(followerStatus, clocks.leader(5002000));
+
+    LeaderStatus leaderStatus;
+    leaderSide.stampLeaderStatus(leaderStatus, clocks.leader(5100000));
+    REQUIRE(leaderStatus.echoSentMicros() == 5000000);
+
+    ClockSample sample;
+    REQUIRE(followerSide.processLeaderStatus(leaderStatus, 5102000, &sample));
+    REQUIRE(sample.offsetMicros == -3000000);
+    REQUIRE(sample.delayMicros == 4000);
+    REQUIRE(followerSide.latency().count() == 1);
+    REQUIRE(followerSide.latency().maxMicros() == 2000);
+
+    followerSide.reset();
+    REQUIRE_FALSE(followerSide.synced());
+}
+
+TEST_CASE("ClockSync recognises echoes of its own FollowerStatus messages.") {
+    ClockSync followerSide;
+    LeaderStatus leaderStatus;
+    REQUIRE_FALSE(followerSide.echoesOurs(leaderStatus));
+
+    for (int64_t sent = 1000000; sent <= 3000000; sent += 500000) {
+        FollowerStatus followerStatus;
+        followerSide.stampFollowerStatus(followerStatus, sent);
+    }
+    leaderStatus.echoSentMicros(3000000);
+    REQUIRE(followerSide.echoesOurs(leaderStatus));
+    leaderStatus.echoSentMicros(1500000);
+    REQUIRE(followerSide.echoesOurs(leaderStatus));
+
+    // Forgotten once CLOCK_STAMP_HISTORY newer ones were sent, and never ours if another follower stamped it.
+    leaderStatus.echoSentMicros(1000000);
+    REQUIRE_FALSE(followerSide.echoesOurs(leaderStatus));
+    leaderStatus.echoSentMicros(2700000);
+    REQUIRE_FALSE(followerSide.echoesOurs(leaderStatus));
+
+    followerSide.reset();
+    leaderStatus.echoSentMicros(3000000);
+    REQUIRE_FALSE(followerSide.echoesOurs(leaderStatus));
+}
+
+TEST_CASE("ReplayScheduler corrects the leader spacing for the clock drift.") {
+    ManualTimeSource time;
+    ReplayScheduler scheduler(time);
+
+    // The leader clock gains 200 us per second, so its 500 ms gaps are 100 us shorter on our clock.
+    scheduler.setLeaderClockDrift(200.0);
+    ReplayScheduler::Clock::time_point first = scheduler.schedule(1000);
+    ReplayScheduler::Clock::time_point second = scheduler.schedule(1500);
+    REQUIRE(second - first == milliseconds(500) - microseconds(100));
+
+    // The standard spacing for updates without timestamps is our own, it is not corrected.
+    REQUIRE(scheduler.schedule(0) - second == NOMINAL_UPDATE_SPACING);
+}
@@ -0,0 +1,189 @@
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "cluon/Envelope.hpp"
+#include "cluon/ToProtoVisitor.hpp"
+#include "messages.hpp"
+
+#include "v2v/time_source.hpp"
+#include "visualisation/decimator.hpp"
+
+using namespace std::chrono;
+using namespace opendlv::proxy;
+
+template <class T>
+static cluon::data::Envelope envelopeOf(T &msg) {
+    cluon::ToProtoVisitor visitor;
+    msg.accept(visitor);
+    cluon::data::Envelope envelope;
+    envelope.dataType(T::ID());
+    envelope.serializedData(visitor.encodedData());
+    return envelope;
+}
+
+static cluon::data::Envelope pedal(float percent) {
+    PedalPositionReading msg;
+    msg.percent(percent);
+    return envelopeOf(msg);
+}
+
+static cluon::data::Envelope distance(float value) {
+    DistanceReading msg;
+    msg.distance(value);
+    return envelopeOf(msg);
+}
+
+/*
+ * Keeps what a decimator relays.
+ */
+struct Relayed {
+    std::vector<cluon::data::Envelope> envelopes;
+
+    Decimator::Sink sink() {
+        return [this](cluon::data::Envelope &&envelope) { envelopes.push_back(std::move(envelope)); };
+    }
+
+    float percent(size_t i) const {
+        return cluon::extractMessage<PedalPositionReading>(cluon::data::Envelope(envelopes.at(i))).percent();
+    }
+};
+
+TEST_CASE("Decimator LATEST relays the newest value held back once per interval.") {
+    ManualTimeSource time;
+    Relayed relayed;
+    Decimator decimator({{PedalPositionReading::ID(), Decimation::LATEST, milliseconds(100)}}, relayed.sink());
+    REQUIRE(decimator.needsFlushing());
+
+    // The first value goes straight through, the ones after it are held back and replace each other.
+    decimator.offer(pedal(0.1f), time.now());
+    REQUIRE(relayed.envelopes.size() == 1);
+    time.advance(milliseconds(10));
+    decimator.offer(pedal(0.2f), time.now());
+    time.advance(milliseconds(40));
+    decimator.offer(pedal(0.3f), time.now());
+    time.advance(milliseconds(40));
+    decimator.flush(time.now());
+    REQUIRE(relayed.envelopes.size() == 1);
+
+    time.advance(milliseconds(10));
+    decimator.flush(time.now());
+    REQUIRE(relayed.envelopes.size() == 2);
+    REQUIRE(relayed.percent(0) == 0.1f);
+    REQUIRE(relayed.percent(1) == 0.3f);
+    REQUIRE(decimator.decimated() == 1);
+
+    // Nothing held, nothing to relay.
+    time.advance(milliseconds(500));
+    decimator.flush(time.now());
+    REQUIRE(relayed.envelopes.size() == 2);
+    // A value after a quiet interval is due right away.
+    decimator.offer(pedal(0.4f), time.now());
+    REQUIRE(relayed.envelopes.size() == 3);
+    REQUIRE(relayed.percent(2) == 0.4f);
+}
+
+TEST_CASE("Decimator MIN_INTERVAL drops the values inside the interval.") {
+    ManualTimeSource time;
+    Relayed relayed;
+    Decimator decimator({{PedalPositionReading::ID(), Decimation::MIN_INTERVAL, milliseconds(100)}}, relayed.sink());
+    REQUIRE_FALSE(decimator.needsFlushing());
+
+    decimator.offer(pedal(0.1f), time.now());
+    time.advance(milliseconds(50));
+    decimator.offer(pedal(0.2f), time.now());
+    time.advance(milliseconds(49));
+    decimator.offer(pedal(0.3f), time.now());
+    // Dropped, not held, so a flush has nothing to relay.
+    time.advance(milliseconds(1));
+    decimator.flush(time.now());
+    REQUIRE(relayed.envelopes.size() == 1);
+
+    decimator.offer(pedal(0.4f), time.now());
+    REQUIRE(relayed.envelopes.size() == 2);
+    REQUIRE(relayed.percent(0) == 0.1f);
+    REQUIRE(relayed.percent(1) == 0.4f);
+    REQUIRE(decimator.decimated() == 2);
+}
+
+TEST_CASE("Decimator AGGREGATE relays the latest distance and the aggregate of its window.") {
+    ManualTimeSource time;
+    Relayed relayed;
+    Decimator decimator({{DistanceReading::ID(), Decimation::AGGREGATE, milliseconds(250)}}, relayed.sink());
+
+    for (float value : {1.0f, 2.0f, 3.0f, 6.0f}) {
+        decimator.offer(distance(value), time.now());
+        time.advance(milliseconds(50));
+    }
+    REQUIRE(relayed.envelopes.empty());
+    time.advance(milliseconds(50));
+    decimator.flush(time.now());
+
+    REQUIRE(relayed.envelopes.size() == 2);
+    REQUIRE(relayed.envelopes[0].dataType() == DistanceReading::ID());
+    REQUIRE(cluon::extractMessage<DistanceReading>(std::move(relayed.envelopes[0])).distance() == 6.0f);
+    REQUIRE(relayed.envelopes[1].dataType() == VisualisationAggregate::ID());
+    VisualisationAggregate aggregate = cluon::extractMessage<VisualisationAggregate>(std::move(relayed.envelopes[1]));
+    REQUIRE(aggregate.dataType() == DistanceReading::ID());
+    REQUIRE(aggregate.count() == 4);
+    REQUIRE(aggregate.minimum() == 1.0f);
+    REQUIRE(aggregate.maximum() == 6.0f);
+    REQUIRE(aggregate.mean() == 3.0f);
+    REQUIRE(aggregate.windowMillis() == 250);
+    REQUIRE(decimator.decimated() == 3);
+
+    // The next window starts with the next reading and aggregates only what came in since.
+    decimator.offer(distance(10.0f), time.now());
+    time.advance(milliseconds(250));
+    decimator.offer(distance(20.0f), time.now());
+    REQUIRE(relayed.envelopes.size() == 4);
+    aggregate = cluon::extractMessage<VisualisationAggregate>(std::move(relayed.envelopes[3]));
+    REQUIRE(aggregate.count() == 2);
+    REQUIRE(aggregate.mean() == 15.0f);
+}
+
+TEST_CASE("Decimator keeps the output rate bounded under a flood.") {
+    ManualTimeSource time;
+    TimeSource::time_point start = time.now();
+    Relayed relayed;
+    Decimator decimator({{PedalPositionReading::ID(), Decimation::LATEST, milliseconds(100)},
+                         {DistanceReading::ID(), Decimation::AGGREGATE, milliseconds(250)}}, relayed.sink());
+
+    // A reading of each every 100 us for a second, flushed every tick as the service does.
+    TimeSource::time_point nextFlush = start + DECIMATION_TICK;
+    for (int i = 0; i < 10000; i++) {
+        decimator.offer(pedal(i * 0.0001f), time.now());
+        decimator.offer(distance(static_cast<float>(i % 100)), time.now());
+        time.advance(microseconds(100));
+        if (time.now() >= nextFlush) {
+            decimator.flush(time.now());
+            nextFlush += DECIMATION_TICK;
+        }
+    }
+    time.advance(milliseconds(250));
+    decimator.flush(time.now());
+
+    size_t pedals = 0;
+    size_t aggregates = 0;
+    for (const cluon::data::Envelope &envelope : relayed.envelopes) {
+        pedals += envelope.dataType() == PedalPositionReading::ID();
+        aggregates += envelope.dataType() == VisualisationAggregate::ID();
+    }
+    // Once per interval over the second, plus the first value and the last one flushed.
+    REQUIRE(pedals >= 10);
+    REQUIRE(pedals <= 12);
+    REQUIRE(aggregates >= 4);
+    REQUIRE(aggregates <= 5);
+    REQUIRE(relayed.envelopes.size() == pedals + 2 * aggregates);
+    REQUIRE(decimator.decimated() == 20000 - pedals - aggregates);
+    // The last value always gets through.
+    float last = 0.0f;
+    for (size_t i = 0; i < relayed.envelopes.size(); i++) {
+        if (relayed.envelopes[i].dataType() == PedalPositionReading::ID()) {
+            last = relayed.percent(i);
+        }
+    }
+    REQUIRE(last == 9999 * 0.0001f);
+}
@@ -0,0 +1,170 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "v2v/distance_trail.hpp"
+#include "v2v/odometry.hpp"
+
+/*
+ * Deterministic simulation of a leader and a follower car driving the same input as fl_sim. The follower is a slower
+ * car (it covers less ground at the same pedal position, which its odometry is calibrated for) so replaying the leader
+ * by time makes it turn too early, while replaying by distance should make it turn at the same spot.
+ */
+
+using namespace std::chrono;
+
+static const double WHEELBASE_CM = 25.0;
+static const microseconds SIMULATION_STEP(5000);
+static const int STEPS_PER_STATUS = 25;  // 125 ms
+static const int STEPS_PER_TRAIL_STEP = 5; // 25 ms
+static const float FOLLOWER_SPEED_FACTOR = 0.8f;
+
+struct Position {
+    double x;
+    double y;
+};
+
+struct SimulatedCar {
+    double x;
+    double y;
+    double heading;
+    float speedFactor;
+    double driven;
+
+    void drive(float pedalPosition, float steeringAngle, microseconds elapsed) {
+        double seconds = elapsed.count() / 1000000.0;
+        double speed = Odometry::cmPerSecond(pedalPosition) * speedFactor;
+        x += speed * std::cos(heading) * seconds;
+        y += speed * std::sin(heading) * seconds;
+        heading += speed / WHEELBASE_CM * std::tan(steeringAngle) * seconds;
+        driven += speed * seconds;
+    }
+};
+
+/*
+ * The update sequence of fl_sim.cpp, 100 LeaderStatus messages 125 ms apart.
+ */
+static void flSimInput(int update, float &speed, float &steering) {
+    if (update < 18) {
+        speed += 0.01f;
+    } else if (update == 99) {
+        speed = 0;
+    }
+
+    if (update > 16 && update < 24) {
+        steering += 0.05f;
+    } else if (update == 60) {
+        steering = 0;
+    }
+}
+
+/*
+ * Largest distance between any follower position and the leader's path.
+ */
+static double maxDeviation(const std::vector<Position> &leaderPath, const std::vector<Position> &followerPath) {
+    double worst = 0;
+    for (const Position &f : followerPath) {
+        double nearest = 1e9;
+        for (const Position &l : leaderPath) {
+            nearest = std::min(nearest, std::hypot(f.x - l.x, f.y - l.y));
+        }
+        worst = std::max(worst, nearest);
+    }
+    return worst;
+}
+
+struct Recording {
+    std::vector<Position> leaderPath;
+    std::vector<float> speeds;
+    std::vector<float> steerings;
+    std::vector<uint8_t> distances;
+};
+
+/*
+ * Drives the leader through the fl_sim input and records its path together with the LeaderStatus stream it sends.
+ */
+static Recording driveLeader(int totalSteps) {
+    Recording recording;
+    SimulatedCar leader = {0, 0, 0, 1.0f, 0};
+    Odometry odometry;
+    float speed = 0, steering = 0, reportedSpeed = 0;
+
+    for (int step = 0; step < totalSteps; step++) {
+        if (step % STEPS_PER_STATUS == 0 && step / STEPS_PER_STATUS < 100) {
+            flSimInput(step / STEPS_PER_STATUS, speed, steering);
+
+            // Same as V2VService::leaderStatus, the interval was driven at the previously reported speed.
+            odometry.advance(reportedSpeed, SIMULATION_STEP * STEPS_PER_STATUS);
+            reportedSpeed = speed;
+            recording.speeds.push_back(speed);
+            recording.steerings.push_back(steering);
+            recording.distances.push_back(step == 0 ? 0 : odometry.takeDistanceTraveled());
+        }
+        leader.drive(speed, steering, SIMULATION_STEP);
+        recording.leaderPath.push_back(Position{leader.x, leader.y});
+    }
+    return recording;
+}
+
+TEST_CASE("Distance based following turns where the leader turned.") {
+    const int totalSteps = 30 * 1000 / 5; // 30 seconds
+    Recording recording = driveLeader(totalSteps);
+
+    // Distance mode, the follower starts one follow distance behind the leader.
+    SimulatedCar follower = {-FOLLOW_DISTANCE_CM, 0, 0, FOLLOWER_SPEED_FACTOR, 0};
+    DistanceTrail trail(FOLLOWER_SPEED_FACTOR);
+    trail.reset(-FOLLOW_DISTANCE_CM);
+    TrailCommand command = {0, 0};
+    std::vector<Position> distancePath;
+
+    for (int step = 0; step < totalSteps; step++) {
+        int update = step / STEPS_PER_STATUS;
+        if (step % STEPS_PER_STATUS == 0 && update < (int) recording.speeds.size()) {
+            trail.record(recording.distances[update], recording.speeds[update], recording.steerings[update]);
+        }
+        if (step % STEPS_PER_TRAIL_STEP == 0) {
+            command = trail.step(SIMULATION_STEP * STEPS_PER_TRAIL_STEP);
+        }
+        follower.drive(command.speed, command.steeringAngle, SIMULATION_STEP);
+
+        // Only compare once the follower has reached the leader's starting point.
+        if (follower.driven >= FOLLOW_DISTANCE_CM) {
+            distancePath.push_back(Position{follower.x, follower.y});
+        }
+    }
+
+    // Time mode, 9 pre fill updates straight ahead and then every leader update 125 ms after the previous one.
+    SimulatedCar timeFollower = {-FOLLOW_DISTANCE_CM, 0, 0, FOLLOWER_SPEED_FACTOR, 0};
+    std::vector<Position> timePath;
+    for (int step = 0; step < totalSteps; step++) {
+        int update = step / STEPS_PER_STATUS - 9;
+        float speed = 0.15f, steering = 0;
+        if (update >= (int) recording.speeds.size()) {
+            speed = 0;
+        } else if (update >= 0) {
+            speed = recording.speeds[update];
+            steering = recording.steerings[update];
+        }
+        timeFollower.drive(speed, steering, SIMULATION_STEP);
+        if (timeFollower.driven >= FOLLOW_DISTANCE_CM) {
+            timePath.push_back(Position{timeFollower.x, timeFollower.y});
+        }
+    }
+
+    double distanceDeviation = maxDeviation(recording.leaderPath, distancePath);
+    double timeDeviation = maxDeviation(recording.leaderPath, timePath);
+    std::cout << "Path deviation from the leader: distance mode " << distanceDeviation << " cm, time mode "
+              << timeDeviation << " cm" << std::endl;
+
+    REQUIRE(!distancePath.empty());
+    REQUIRE(distanceDeviation < 5.0);
+    REQUIRE(distanceDeviation < timeDeviation);
+    REQUIRE(trail.overflows() == 0);
+
+    // The follower stopped one follow distance behind where the leader stopped.
+    REQUIRE(command.speed == 0);
+    REQUIRE(std::abs(trail.leaderDistance() - FOLLOW_DISTANCE_CM - trail.followerDistance()) < 10.0);
+}
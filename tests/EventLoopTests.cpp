@@ -0,0 +1,95 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "catch.hpp"
+
+#include "v2v/event_loop.hpp"
+
+using namespace std::chrono;
+
+
+TEST_CASE("EventLoop runs armed tasks once per period.") {
+    EventLoop loop(false);
+    int runs = 0;
+    EventLoop::Clock::time_point start = EventLoop::Clock::now();
+    EventLoop::TaskId id = loop.arm(milliseconds(100), [&runs]() { runs++; });
+
+    REQUIRE(id != 0);
+    REQUIRE(loop.armedTasks() == 1);
+
+    // The first run is due right away, the next one a period later.
+    EventLoop::Clock::time_point next = loop.runDueTasks(start + milliseconds(1));
+    REQUIRE(runs == 1);
+    REQUIRE(loop.runDueTasks(start + milliseconds(50)) == next);
+    REQUIRE(runs == 1);
+
+    loop.runDueTasks(next);
+    REQUIRE(runs == 2);
+
+    // Far behind, the missed runs are skipped instead of being run in a burst.
+    EventLoop::Clock::time_point late = next + seconds(10);
+    REQUIRE(loop.runDueTasks(late) == late + milliseconds(100));
+    REQUIRE(runs == 3);
+}
+
+TEST_CASE("EventLoop tasks can be disarmed, also from within a task.") {
+    EventLoop loop(false);
+    int firstRuns = 0, secondRuns = 0;
+    EventLoop::TaskId second = 0;
+    EventLoop::TaskId first = loop.arm(milliseconds(10), [&]() {
+        firstRuns++;
+        loop.disarm(first);
+        loop.disarm(second);
+    });
+    second = loop.arm(milliseconds(10), [&secondRuns]() { secondRuns++; });
+
+    REQUIRE(loop.runDueTasks(EventLoop::Clock::now() + milliseconds(1)) == EventLoop::Clock::time_point::max());
+    REQUIRE(firstRuns == 1);
+    REQUIRE(secondRuns == 0);
+    REQUIRE(loop.armedTasks() == 0);
+    REQUIRE(!loop.disarm(first));
+}
+
+TEST_CASE("EventLoop runs the after tasks hook once per round that ran a task.") {
+    // Both tasks are armed at the same simulated time, so they are due together.
+    ManualTimeSource time;
+    EventLoop loop(false, time);
+    int taskRuns = 0, hookRuns = 0;
+    loop.setAfterTasks([&]() {
+        // Sees every task of the round done.
+        REQUIRE(taskRuns == 2 * (hookRuns + 1));
+        hookRuns++;
+    });
+    loop.arm(milliseconds(100), [&taskRuns]() { taskRuns++; });
+    loop.arm(milliseconds(100), [&taskRuns]() { taskRuns++; });
+
+    EventLoop::Clock::time_point start = time.now();
+    EventLoop::Clock::time_point next = loop.runDueTasks(start + milliseconds(1));
+    REQUIRE(hookRuns == 1);
+    loop.runDueTasks(start + milliseconds(50));
+    REQUIRE(hookRuns == 1);
+    loop.runDueTasks(next);
+    REQUIRE(hookRuns == 2);
+
+    loop.setAfterTasks(nullptr);
+    loop.runDueTasks(next + milliseconds(100));
+    REQUIRE(taskRuns == 6);
+    REQUIRE(hookRuns == 2);
+}
+
+TEST_CASE("EventLoop thread runs tasks until stopped.") {
+    std::atomic<int> runs(0);
+    {
+        EventLoop loop;
+        loop.arm(milliseconds(5), [&runs]() { runs++; });
+
+        std::this_thread::sleep_for(milliseconds(100));
+        REQUIRE(runs.load() >= 5);
+    }
+
+    // The destructor joined the loop thread, nothing runs anymore.
+    int stopped = runs.load();
+    std::this_thread::sleep_for(milliseconds(20));
+    REQUIRE(runs.load() == stopped);
+}
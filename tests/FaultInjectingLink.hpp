@@ -0,0 +1,130 @@
+#ifndef V2V_TESTS_FAULT_INJECTING_LINK_H
+#define V2V_TESTS_FAULT_INJECTING_LINK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * What a FaultInjectingLink does to the datagrams it forwards, as probabilities per datagram.
+ */
+struct LinkFaults {
+    double loss = 0.0;
+    double duplicate = 0.0;
+    // A reordered datagram is held back for reorderDelay, so the ones after it overtake it.
+    double reorder = 0.0;
+    std::chrono::milliseconds reorderDelay{15};
+    // Every datagram is delayed by up to jitter.
+    std::chrono::milliseconds jitter{0};
+    uint32_t seed = 7;
+};
+
+/**
+ * UDP forwarder on a free loopback port standing in for a lossy radio link: what is sent to its port is forwarded to
+ * the destination port on the loopback interface, after dropping, duplicating, delaying and reordering datagrams as
+ * given by the faults. The faults are drawn from a seeded generator, so a test sees the same ones on every run as
+ * long as the datagrams arrive at the link in the same order.
+ */
+class FaultInjectingLink {
+public:
+    FaultInjectingLink(uint16_t destinationPort, const LinkFaults &linkFaults) :
+        faults(linkFaults), random(linkFaults.seed), forwardedCount(0), droppedCount(0), running(true) {
+        fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = inet_addr("127.0.0.1");
+        ::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        ::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+        port = ntohs(address.sin_port);
+
+        destination = {};
+        destination.sin_family = AF_INET;
+        destination.sin_addr.s_addr = inet_addr("127.0.0.1");
+        destination.sin_port = htons(destinationPort);
+
+        forwarder = std::thread(&FaultInjectingLink::forward, this);
+    }
+
+    ~FaultInjectingLink() {
+        running = false;
+        forwarder.join();
+        ::close(fd);
+    }
+
+    // Datagrams forwarded, duplicates included.
+    uint64_t forwarded() const {
+        return forwardedCount;
+    }
+
+    uint64_t dropped() const {
+        return droppedCount;
+    }
+
+    uint16_t port;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void forward() {
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        char buffer[65536];
+        while (running || !delayed.empty()) {
+            // Wakes up every millisecond to forward what is due and to check whether to stop.
+            pollfd readable = {fd, POLLIN, 0};
+            if (running && ::poll(&readable, 1, 1) > 0) {
+                ssize_t length = ::recv(fd, buffer, sizeof(buffer), 0);
+                if (length > 0) {
+                    std::string datagram(buffer, static_cast<size_t>(length));
+                    if (chance(random) < faults.loss) {
+                        droppedCount++;
+                    } else {
+                        int copies = chance(random) < faults.duplicate ? 2 : 1;
+                        for (int i = 0; i < copies; i++) {
+                            Clock::duration delay = std::chrono::microseconds(static_cast<int64_t>(
+                                chance(random) * std::chrono::microseconds(faults.jitter).count()));
+                            if (chance(random) < faults.reorder) {
+                                delay += faults.reorderDelay;
+                            }
+                            delayed.emplace(Clock::now() + delay, datagram);
+                        }
+                    }
+                }
+            } else if (!running) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            Clock::time_point now = Clock::now();
+            while (!delayed.empty() && delayed.begin()->first <= now) {
+                const std::string &datagram = delayed.begin()->second;
+                ::sendto(fd, datagram.data(), datagram.size(), 0, reinterpret_cast<const sockaddr *>(&destination),
+                         sizeof(destination));
+                forwardedCount++;
+                delayed.erase(delayed.begin());
+            }
+        }
+    }
+
+    const LinkFaults faults;
+    std::mt19937 random;
+    int fd;
+    sockaddr_in destination;
+    // Datagrams waiting to be forwarded, by the time they are due. Only used by the forwarder thread.
+    std::multimap<Clock::time_point, std::string> delayed;
+    std::atomic<uint64_t> forwardedCount;
+    std::atomic<uint64_t> droppedCount;
+    std::atomic<bool> running;
+    std::thread forwarder;
+};
+
+#endif // V2V_TESTS_FAULT_INJECTING_LINK_H
@@ -0,0 +1,160 @@
+#include <memory>
+#include <string>
+
+#include "catch.hpp"
+
+#include "v2v/follower_group.hpp"
+
+#include "LoopbackPeer.hpp"
+
+TEST_CASE("FollowerGroup takes followers up to its capacity and starts a returning one over.") {
+    SendPool pool;
+    FollowerGroup group(2);
+    std::shared_ptr<Follower> first = group.add("10.0.0.1", pool.acquire("10.0.0.1", 50001), Framing::BINARY);
+    REQUIRE(first != nullptr);
+    REQUIRE(first->peer == "follower 10.0.0.1");
+    REQUIRE(group.add("10.0.0.2", pool.acquire("10.0.0.2", 50001), Framing::LEGACY_HEX) != nullptr);
+    REQUIRE(group.add("10.0.0.3", pool.acquire("10.0.0.3", 50001), Framing::BINARY) == nullptr);
+    REQUIRE(group.size() == 2);
+
+    // Asking again gives a new session, in the same place.
+    std::shared_ptr<Follower> again = group.add("10.0.0.1", pool.acquire("10.0.0.1", 50001), Framing::LEGACY_HEX);
+    REQUIRE(again != first);
+    REQUIRE(group.find("10.0.0.1") == again);
+    REQUIRE(group.followers()[0]->framing == Framing::LEGACY_HEX);
+    REQUIRE(group.size() == 2);
+
+    REQUIRE(group.remove("10.0.0.2") != nullptr);
+    REQUIRE(group.remove("10.0.0.2") == nullptr);
+    REQUIRE(group.find("10.0.0.2") == nullptr);
+    REQUIRE(group.add("10.0.0.3", pool.acquire("10.0.0.3", 50001), Framing::BINARY) != nullptr);
+
+    REQUIRE(group.clear().size() == 2);
+    REQUIRE(group.empty());
+}
+
+TEST_CASE("FollowerGroup fans a LeaderStatus out to every follower with its own echo and framing.") {
+    LoopbackPeer peers[3];
+    SendPool pool;
+    FollowerGroup group;
+    for (size_t i = 0; i < 3; i++) {
+        std::string name = "127.0.0." + std::to_string(i + 1);
+        std::shared_ptr<Follower> follower = group.add(name, pool.acquire("127.0.0.1", peers[i].port),
+                                                       i == 1 ? Framing::LEGACY_HEX : Framing::BINARY);
+        FollowerStatus followerStatus;
+        followerStatus.sentMicros(1000 * (i + 1));
+        follower->clock.processFollowerStatus(followerStatus, 1000 * (i + 1) + 7);
+    }
+
+    LeaderStatus leaderStatus;
+    leaderStatus.timestamp(1525000000125);
+    leaderStatus.speed(0.2f);
+    leaderStatus.steeringAngle(-0.1f);
+    leaderStatus.distanceTraveled(3);
+    REQUIRE(group.fanOut(pool, leaderStatus, 1525000000125000) == 3);
+    REQUIRE(pool.flush() == 3);
+#ifdef __linux__
+    REQUIRE(pool.sendCalls() == 1);
+#endif
+
+    for (size_t i = 0; i < 3; i++) {
+        std::string data = peers[i].receive();
+        REQUIRE((static_cast<uint8_t>(data[0]) == BINARY_FRAME_MAGIC) == (i != 1));
+        Frame frame = extractFrame(data);
+        REQUIRE(frame.id == LeaderStatus::ID());
+
+        LeaderStatus received;
+        REQUIRE(decodeLeaderStatus(frame.payload, received));
+        REQUIRE(received.timestamp() == 1525000000125);
+        REQUIRE(received.speed() == 0.2f);
+        REQUIRE(received.steeringAngle() == -0.1f);
+        REQUIRE(received.distanceTraveled() == 3);
+        REQUIRE(received.timestampMicros() == 1525000000125000);
+        REQUIRE(received.echoSentMicros() == 1000 * (i + 1));
+        REQUIRE(received.echoReceivedMicros() == 1000 * (i + 1) + 7);
+
+        // Byte for byte what encoding the stamped status in one go gives.
+        LeaderStatus expected = received;
+        REQUIRE(data == encodeFrame(expected, i == 1 ? Framing::LEGACY_HEX : Framing::BINARY));
+    }
+}
+
+TEST_CASE("FollowerGroup sends nothing without followers.") {
+    SendPool pool;
+    FollowerGroup group;
+    LeaderStatus leaderStatus;
+    REQUIRE(group.fanOut(pool, leaderStatus, 1) == 0);
+    REQUIRE(pool.flush() == 0);
+}
+
+TEST_CASE("FollowerGroup multicasts once to the followers that joined the group, echoing each in turn.") {
+    const std::string group = multicastGroupFor("127.0.0.1");
+    const uint16_t port = MULTICAST_PORT + 100;
+    MulticastPeer members[2] = {{group, port}, {group, port}};
+    REQUIRE(members[0].receiver.isRunning());
+    REQUIRE(members[1].receiver.isRunning());
+    LoopbackPeer unicast;
+
+    SendPool pool;
+    REQUIRE(pool.setMulticastInterface("127.0.0.1"));
+    FollowerGroup followers;
+    followers.setMulticastGroup(pool.acquire(group, port));
+    for (size_t i = 0; i < 3; i++) {
+        std::string name = "127.0.0." + std::to_string(i + 1);
+        std::shared_ptr<Follower> follower = followers.add(name, pool.acquire("127.0.0.1", unicast.port),
+                                                           Framing::BINARY);
+        follower->multicast = i < 2;
+        FollowerStatus followerStatus;
+        followerStatus.sentMicros(1000 * (i + 1));
+        follower->clock.processFollowerStatus(followerStatus, 1000 * (i + 1) + 7);
+    }
+
+    for (uint64_t round = 0; round < 2; round++) {
+        LeaderStatus leaderStatus;
+        leaderStatus.timestamp(1525000000125 + round);
+        leaderStatus.speed(0.2f);
+        REQUIRE(followers.fanOut(pool, leaderStatus, 1525000000125000) == 2);
+        REQUIRE(pool.flush() == 2);
+
+        // Both members get the same datagram, with the echo of one of them.
+        std::string data = members[0].receive();
+        REQUIRE(data == members[1].receive());
+        Frame frame = extractFrame(data);
+        LeaderStatus received;
+        REQUIRE(decodeLeaderStatus(frame.payload, received));
+        REQUIRE(received.timestamp() == 1525000000125 + round);
+        REQUIRE(received.echoSentMicros() == 1000 * (round + 1));
+
+        // The follower that did not join keeps getting its own.
+        data = unicast.receive();
+        frame = extractFrame(data);
+        REQUIRE(decodeLeaderStatus(frame.payload, received));
+        REQUIRE(received.echoSentMicros() == 3000);
+    }
+#ifdef __linux__
+    REQUIRE(pool.sendCalls() == 2);
+#endif
+}
+
+TEST_CASE("FollowerGroup falls back to unicast when the multicast group cannot be sent to.") {
+    LoopbackPeer peer;
+    SendPool pool;
+    FollowerGroup followers;
+    // Sending to the broadcast address without permission fails like an unusable group does.
+    followers.setMulticastGroup(pool.acquire("255.255.255.255", peer.port));
+    std::shared_ptr<Follower> follower = followers.add("127.0.0.1", pool.acquire("127.0.0.1", peer.port),
+                                                       Framing::BINARY);
+    follower->multicast = true;
+
+    LeaderStatus leaderStatus;
+    REQUIRE(followers.fanOut(pool, leaderStatus, 1) == 1);
+    REQUIRE(pool.flush() == 0);
+    REQUIRE(peer.receive().empty());
+
+    REQUIRE(followers.fanOut(pool, leaderStatus, 2) == 1);
+    REQUIRE(pool.flush() == 1);
+    REQUIRE(followers.multicastGroup() == nullptr);
+    std::string data = peer.receive();
+    Frame frame = extractFrame(data);
+    REQUIRE(frame.id == LeaderStatus::ID());
+}
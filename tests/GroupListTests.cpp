@@ -0,0 +1,81 @@
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "v2v/group_list.hpp"
+
+
+static std::vector<GroupListEntry> makeGroups(int count) {
+    std::vector<GroupListEntry> groups;
+    for (int i = 0; i < count; i++) {
+        groups.push_back(GroupListEntry{std::to_string(i), "10.0." + std::to_string(i / 250) + "." +
+                                        std::to_string(i % 250), (uint32_t) i * 10, (uint32_t) i % 4});
+    }
+    return groups;
+}
+
+TEST_CASE("packGroupList fits a small list into one page.") {
+    std::vector<InternalGetAllGroupsBatch> pages = packGroupList(makeGroups(3), 7);
+    REQUIRE(pages.size() == 1);
+    REQUIRE(pages[0].batchId() == 7);
+    REQUIRE(pages[0].page() == 0);
+    REQUIRE(pages[0].pageCount() == 1);
+    REQUIRE(pages[0].total() == 3);
+    REQUIRE(pages[0].groups() == "0,10.0.0.0,0,0\n1,10.0.0.1,10,1\n2,10.0.0.2,20,2\n");
+
+    std::vector<GroupListEntry> groups;
+    REQUIRE(unpackGroupList(pages[0].groups(), groups));
+    REQUIRE(groups.size() == 3);
+    REQUIRE(groups[2].groupId == "2");
+    REQUIRE(groups[2].ip == "10.0.0.2");
+    REQUIRE(groups[2].ageMillis == 20);
+    REQUIRE(groups[2].capabilities == 2);
+}
+
+TEST_CASE("packGroupList marks an empty list as complete.") {
+    std::vector<InternalGetAllGroupsBatch> pages = packGroupList(std::vector<GroupListEntry>(), 1);
+    REQUIRE(pages.size() == 1);
+    REQUIRE(pages[0].pageCount() == 1);
+    REQUIRE(pages[0].total() == 0);
+
+    GroupListAssembler assembler;
+    REQUIRE(assembler.add(pages[0]));
+    REQUIRE(assembler.groups().empty());
+}
+
+TEST_CASE("packGroupList pages long lists and GroupListAssembler puts them back together.") {
+    std::vector<GroupListEntry> sent = makeGroups(200);
+    sent.push_back(GroupListEntry{"bad,group", "10.9.9.9", 0, 0});
+    std::vector<InternalGetAllGroupsBatch> pages = packGroupList(sent, 3);
+    REQUIRE(pages.size() > 1);
+    for (const InternalGetAllGroupsBatch &page : pages) {
+        REQUIRE(page.groups().size() <= GROUP_LIST_PAGE_BYTES);
+        REQUIRE(page.total() == 200);
+    }
+
+    GroupListAssembler assembler;
+    // A page of an older batch is dropped once a newer one arrives.
+    REQUIRE_FALSE(assembler.add(packGroupList(makeGroups(200), 2)[0]));
+
+    // Pages arrive out of order, one of them twice.
+    REQUIRE_FALSE(assembler.add(pages.back()));
+    REQUIRE_FALSE(assembler.add(pages.back()));
+    for (size_t i = 0; i + 1 < pages.size(); i++) {
+        REQUIRE(assembler.add(pages[i]) == (i + 2 == pages.size()));
+    }
+
+    REQUIRE(assembler.groups().size() == 200);
+    for (size_t i = 0; i < 200; i++) {
+        REQUIRE(assembler.groups()[i].groupId == sent[i].groupId);
+        REQUIRE(assembler.groups()[i].ip == sent[i].ip);
+    }
+}
+
+TEST_CASE("unpackGroupList rejects malformed lines.") {
+    std::vector<GroupListEntry> groups;
+    REQUIRE_FALSE(unpackGroupList("7,10.0.0.7,10,1\n8,10.0.0.8\n", groups));
+    REQUIRE(groups.size() == 1);
+    REQUIRE_FALSE(unpackGroupList("9,10.0.0.9,10,1", groups));
+    REQUIRE(groups.size() == 1);
+}
@@ -0,0 +1,227 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "v2v/framing.hpp"
+#include "v2v/send_pool.hpp"
+#include "v2v/time_source.hpp"
+#include "v2v/v2v.hpp"
+
+using namespace std::chrono;
+
+/*
+ * Heap allocations made by the current thread. Counted per thread, so the threads of other tests that are still
+ * winding down do not count towards the thread under test.
+ */
+static thread_local uint64_t threadAllocations = 0;
+
+void *operator new(size_t size) {
+    threadAllocations++;
+    void *p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+static LeaderStatus makeLeaderStatus(int i) {
+    LeaderStatus leaderStatus;
+    leaderStatus.timestamp(1525000000000 + i * 125);
+    leaderStatus.speed(0.15f + (i % 5) * 0.01f);
+    leaderStatus.steeringAngle(-0.2f + (i % 9) * 0.05f);
+    leaderStatus.distanceTraveled(static_cast<uint8_t>(i % 14));
+    leaderStatus.timestampMicros(1525000000000000 + i * 125000);
+    // The follower reports every 500 ms, its status reached the leader 10 ms before the first echo went out.
+    leaderStatus.echoSentMicros(1524999999988000 + (i / 4) * 500000);
+    leaderStatus.echoReceivedMicros(1524999999990000 + (i / 4) * 500000);
+    return leaderStatus;
+}
+
+TEST_CASE("decodeLeaderStatus reads back what encodeLeaderStatus writes.") {
+    for (Framing framing : {Framing::LEGACY_HEX, Framing::BINARY}) {
+        for (int i = 0; i < 20; i++) {
+            LeaderStatus sent = makeLeaderStatus(i);
+            std::string data = encodeFrame(sent, framing);
+            Frame frame = extractFrame(data);
+            REQUIRE(frame.id == LeaderStatus::ID());
+
+            LeaderStatus received;
+            REQUIRE(decodeLeaderStatus(frame.payload, received));
+            LeaderStatus expected = decodePayload<LeaderStatus>(frame.payload);
+            REQUIRE(received.timestamp() == expected.timestamp());
+            REQUIRE(received.speed() == expected.speed());
+            REQUIRE(received.steeringAngle() == expected.steeringAngle());
+            REQUIRE(received.distanceTraveled() == expected.distanceTraveled());
+            REQUIRE(received.timestampMicros() == expected.timestampMicros());
+            REQUIRE(received.echoSentMicros() == expected.echoSentMicros());
+            REQUIRE(received.echoReceivedMicros() == expected.echoReceivedMicros());
+            REQUIRE(received.speed() == sent.speed());
+        }
+    }
+}
+
+TEST_CASE("decodeLeaderStatus decodes what cluon encodes.") {
+    for (int i = 0; i < 20; i++) {
+        LeaderStatus sent = makeLeaderStatus(i);
+        sent.sequence(static_cast<uint32_t>(i + 1));
+        cluon::ToProtoVisitor visitor;
+        sent.accept(visitor);
+        std::string payload = visitor.encodedData();
+
+        LeaderStatus received;
+        REQUIRE(decodeLeaderStatus(PayloadView{payload.data(), payload.length()}, received));
+        REQUIRE(received.timestamp() == sent.timestamp());
+        REQUIRE(received.speed() == sent.speed());
+        REQUIRE(received.steeringAngle() == sent.steeringAngle());
+        REQUIRE(received.distanceTraveled() == sent.distanceTraveled());
+        REQUIRE(received.timestampMicros() == sent.timestampMicros());
+        REQUIRE(received.echoSentMicros() == sent.echoSentMicros());
+        REQUIRE(received.echoReceivedMicros() == sent.echoReceivedMicros());
+        REQUIRE(received.sequence() == sent.sequence());
+    }
+}
+
+TEST_CASE("decodeLeaderStatus skips unknown fields and rejects truncated payloads.") {
+    LeaderStatus sent = makeLeaderStatus(3);
+    cluon::ToProtoVisitor v;
+    sent.accept(v);
+    std::string payload = v.encodedData();
+
+    // Field 9 as a varint and field 10 as a string, as a newer leader might send them.
+    std::string extended = payload + std::string("\x48\x96\x01\x52\x03" "abc", 8);
+    LeaderStatus received;
+    REQUIRE(decodeLeaderStatus(PayloadView{extended.data(), extended.length()}, received));
+    REQUIRE(received.timestamp() == sent.timestamp());
+    REQUIRE(received.steeringAngle() == sent.steeringAngle());
+
+    // A legacy leader without the microsecond fields.
+    LeaderStatus legacy;
+    legacy.timestamp(12345);
+    legacy.speed(0.2f);
+    cluon::ToProtoVisitor legacyVisitor;
+    legacy.accept(legacyVisitor);
+    std::string legacyPayload = legacyVisitor.encodedData();
+    REQUIRE(decodeLeaderStatus(PayloadView{legacyPayload.data(), legacyPayload.length()}, received));
+    REQUIRE(received.timestamp() == 12345);
+    REQUIRE(received.timestampMicros() == 0);
+
+    for (size_t length = 1; length < 4; length++) {
+        std::string truncated = extended.substr(0, extended.length() - length);
+        REQUIRE_FALSE(decodeLeaderStatus(PayloadView{truncated.data(), truncated.length()}, received));
+    }
+}
+
+TEST_CASE("The sender stamp of a relayed message gives back the car it came from.") {
+    for (const std::string ip : {"10.0.0.2", "192.168.1.77", "127.0.0.1", "255.255.255.255"}) {
+        REQUIRE(senderStampOf(ip) != OWN_SENDER_STAMP);
+        REQUIRE(senderIpOf(senderStampOf(ip)) == ip);
+    }
+    REQUIRE(senderStampOf("10.0.0.2") != senderStampOf("10.0.0.3"));
+    // Our own messages, and anything not an IPv4 address, come from no other car.
+    REQUIRE(senderIpOf(OWN_SENDER_STAMP).empty());
+    REQUIRE(senderStampOf("not an ip") == OWN_SENDER_STAMP);
+    REQUIRE(senderStampOf("10.0.0.2:50001") == OWN_SENDER_STAMP);
+}
+
+TEST_CASE("A LeaderStatus goes through an OFFLINE V2VService from datagram to actuation without heap allocations.") {
+    ManualTimeSource time;
+    TimeSource::time_point start = time.now();
+    V2VService service("10.0.0.1", "7", 0.0f, time, Networking::OFFLINE);
+    service.stopAnnouncing();
+
+    // What the follower thread allocated so far, as seen by itself whenever it actuates.
+    std::thread::id testThread = std::this_thread::get_id();
+    std::atomic<uint64_t> followerAllocations(0);
+    std::atomic<uint64_t> actuations(0);
+    service.setActuationObserver([&](int32_t, float) {
+        if (std::this_thread::get_id() != testThread) {
+            followerAllocations = threadAllocations;
+            actuations++;
+        }
+    });
+
+    service.followRequest("10.0.0.2");
+    FollowResponse followResponse;
+    followResponse.framing(static_cast<uint8_t>(Framing::BINARY));
+    service.receiveDatagram(encodeFrame(followResponse, Framing::LEGACY_HEX), "10.0.0.2");
+    REQUIRE(service.isFollowing());
+
+    // Datagrams as the leader sends them, encoded up front since encoding is the leader's work.
+    std::vector<std::string> datagrams;
+    for (int i = 0; i < 400; i++) {
+        LeaderStatus sent = makeLeaderStatus(i);
+        sent.sequence(static_cast<uint32_t>(i + 1));
+        datagrams.push_back(encodeFrame(sent, i % 2 == 0 ? Framing::BINARY : Framing::LEGACY_HEX));
+    }
+
+    /*
+     * Statuses come in at the protocol rate. In between, the event loop and the follower thread catch up with the
+     * simulated time, the follower thread actuating the updates that became due. Only the OFFLINE path is covered: a
+     * LIVE service also relays every status to the internal channel and sends the motor commands, and OD4Session::send
+     * builds an envelope with the serialized message each time, which allocates.
+     */
+    uint64_t receiveAllocations = 0;
+    bool settled = true;
+    auto deliver = [&](size_t i) {
+        time.advanceTo(start + LEADER_STATUS_INTERVAL * i);
+        settled = time.settle(2, seconds(5)) && settled;
+        uint64_t allocationsBefore = threadAllocations;
+        service.receiveDatagram(datagrams[i], "10.0.0.2");
+        receiveAllocations += threadAllocations - allocationsBefore;
+        settled = time.settle(2, seconds(5)) && settled;
+    };
+
+    // Warm up, the first update anchors the replay schedule.
+    for (size_t i = 0; i < 100; i++) {
+        deliver(i);
+    }
+    receiveAllocations = 0;
+    uint64_t followerBefore = followerAllocations;
+    uint64_t actuationsBefore = actuations;
+    for (size_t i = 100; i < datagrams.size(); i++) {
+        deliver(i);
+    }
+
+    REQUIRE(settled);
+    REQUIRE(service.isFollowing());
+    REQUIRE(actuations - actuationsBefore > 100);
+    REQUIRE(service.getReplayScheduler().jitter().count() > 300);
+    REQUIRE(receiveAllocations == 0);
+    REQUIRE(followerAllocations - followerBefore == 0);
+    service.setActuationObserver(nullptr);
+}
+
+TEST_CASE("A LeaderStatus is encoded and sent without heap allocations.") {
+    // Nobody listens on the port, the datagrams are dropped by the kernel once sent.
+    SendPool pool;
+    std::shared_ptr<PeerSendContext> follower = pool.acquire("127.0.0.1", 9);
+
+    auto send = [&](int i) {
+        LeaderStatus leaderStatus = makeLeaderStatus(i);
+        pool.queue(follower, leaderStatus, i % 2 == 0 ? Framing::BINARY : Framing::LEGACY_HEX);
+        return pool.flush() == 1;
+    };
+    REQUIRE(send(0));
+
+    uint64_t allocationsBefore = threadAllocations;
+    bool sent = true;
+    for (int i = 1; i < 1000; i++) {
+        sent = send(i) && sent;
+    }
+    uint64_t allocations = threadAllocations - allocationsBefore;
+
+    REQUIRE(sent);
+    REQUIRE(allocations == 0);
+}
@@ -0,0 +1,90 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "v2v/liveness_tracker.hpp"
+
+using namespace std::chrono;
+
+typedef LivenessTracker::Clock Clock;
+
+
+TEST_CASE("LivenessTracker reports a silent peer within one resolution of its deadline.") {
+    LivenessTracker tracker(milliseconds(10));
+    Clock::time_point start = Clock::now();
+    std::vector<std::string> lost;
+    Clock::time_point lostAt;
+
+    Clock::time_point now = start;
+    tracker.watch("leader", milliseconds(1000), milliseconds(125), [&](const std::string &peer) {
+        lost.push_back(peer);
+        lostAt = now;
+    }, start);
+
+    // Heard from until 500 ms, so the deadline is at 1500 ms.
+    for (; now <= start + milliseconds(3000); now += milliseconds(10)) {
+        if (now <= start + milliseconds(500) && (now - start) % milliseconds(125) == milliseconds(0)) {
+            tracker.heard("leader", now);
+        }
+        tracker.tick(now);
+    }
+
+    REQUIRE(lost.size() == 1);
+    REQUIRE(lost[0] == "leader");
+    REQUIRE(lostAt >= start + milliseconds(1500));
+    REQUIRE(lostAt <= start + milliseconds(1510));
+    REQUIRE(tracker.watchedPeers().empty());
+}
+
+TEST_CASE("LivenessTracker handles timeouts longer than the wheel and peers that are forgotten.") {
+    LivenessTracker tracker(milliseconds(1));
+    Clock::time_point start = Clock::now();
+    int losses = 0;
+
+    // 256 slots of 1 ms, the timeout wraps around the wheel several times.
+    tracker.watch("follower", milliseconds(2000), milliseconds(500), [&](const std::string &) { losses++; }, start);
+    tracker.watch("leader", milliseconds(100), milliseconds(125), [&](const std::string &) { losses++; }, start);
+    REQUIRE(tracker.forget("leader"));
+
+    Clock::time_point now = start;
+    for (; now < start + milliseconds(1999); now += milliseconds(1)) {
+        tracker.tick(now);
+    }
+    REQUIRE(losses == 0);
+
+    tracker.tick(start + milliseconds(2000));
+    REQUIRE(losses == 1);
+
+    // A single late tick still finds a deadline that passed long ago.
+    tracker.watch("follower", milliseconds(100), milliseconds(500), [&](const std::string &) { losses++; }, now);
+    tracker.tick(now + seconds(10));
+    REQUIRE(losses == 2);
+}
+
+TEST_CASE("LivenessTracker estimates loss rate and round trip time.") {
+    LivenessTracker tracker(milliseconds(10));
+    Clock::time_point start = Clock::now();
+    tracker.watch("leader", milliseconds(1000), milliseconds(125), nullptr, start);
+
+    // Every fourth status goes missing.
+    for (int i = 0; i < 40; i++) {
+        if (i % 4 != 3) {
+            tracker.heard("leader", start + milliseconds(125 * i));
+        }
+    }
+    tracker.recordRtt("leader", microseconds(800));
+    tracker.recordRtt("leader", microseconds(1600));
+
+    PeerMetrics metrics;
+    REQUIRE(tracker.metrics("leader", metrics, start + milliseconds(125 * 39)));
+    REQUIRE(metrics.received == 30);
+    REQUIRE(metrics.missed == 9);
+    REQUIRE(metrics.lossRate == Approx(9.0 / 39.0));
+    REQUIRE(metrics.lastRttMicros == 1600);
+    REQUIRE(metrics.meanRttMicros == 900);
+    REQUIRE(metrics.silence.count() == 125);
+
+    REQUIRE(!tracker.metrics("follower", metrics));
+}
@@ -0,0 +1,137 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "v2v/log.hpp"
+#include "v2v/mpmc_queue.hpp"
+
+TEST_CASE("MpmcQueue hands every element to exactly one consumer.") {
+    static const int PRODUCERS = 3;
+    static const int CONSUMERS = 3;
+    static const uint32_t ITEMS = 200000;
+
+    MpmcQueue<uint32_t, 256> queue;
+    std::atomic<uint32_t> consumed(0);
+    std::vector<std::vector<uint32_t>> seen(CONSUMERS, std::vector<uint32_t>(PRODUCERS * ITEMS, 0));
+    std::vector<int> outOfOrder(CONSUMERS, 0);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads.push_back(std::thread([&, p]() {
+            for (uint32_t i = 0; i < ITEMS; i++) {
+                while (!queue.push(p * ITEMS + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads.push_back(std::thread([&, c]() {
+            // Elements of one producer have to come out in the order it pushed them.
+            std::vector<int64_t> last(PRODUCERS, -1);
+            uint32_t item;
+            while (consumed.load() < PRODUCERS * ITEMS) {
+                if (queue.pop(item)) {
+                    seen[c][item]++;
+                    if ((int64_t) (item % ITEMS) <= last[item / ITEMS]) {
+                        outOfOrder[c]++;
+                    }
+                    last[item / ITEMS] = item % ITEMS;
+                    consumed++;
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    int missing = 0;
+    int duplicated = 0;
+    for (uint32_t item = 0; item < PRODUCERS * ITEMS; item++) {
+        uint32_t count = 0;
+        for (int c = 0; c < CONSUMERS; c++) {
+            count += seen[c][item];
+        }
+        missing += count == 0;
+        duplicated += count > 1;
+    }
+    REQUIRE(missing == 0);
+    REQUIRE(duplicated == 0);
+    for (int c = 0; c < CONSUMERS; c++) {
+        REQUIRE(outOfOrder[c] == 0);
+    }
+}
+
+TEST_CASE("MpmcQueue rejects and counts pushes on a full queue.") {
+    MpmcQueue<int, 4> queue;
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(queue.push(i));
+    }
+    REQUIRE_FALSE(queue.push(4));
+    REQUIRE(queue.overflows() == 1);
+
+    int item;
+    REQUIRE(queue.pop(item));
+    REQUIRE(item == 0);
+    REQUIRE(queue.push(5));
+    for (int expected : {1, 2, 3, 5}) {
+        REQUIRE(queue.pop(item));
+        REQUIRE(item == expected);
+    }
+    REQUIRE_FALSE(queue.pop(item));
+}
+
+TEST_CASE("LogRateLimiter lets one line through per interval and counts the rest.") {
+    LogRateLimiter limiter(std::chrono::milliseconds(100));
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    REQUIRE(limiter.allow(start) == 0);
+    REQUIRE(limiter.allow(start + std::chrono::milliseconds(10)) == -1);
+    REQUIRE(limiter.allow(start + std::chrono::milliseconds(99)) == -1);
+    REQUIRE(limiter.allow(start + std::chrono::milliseconds(100)) == 2);
+    REQUIRE(limiter.allow(start + std::chrono::milliseconds(150)) == -1);
+    REQUIRE(limiter.allow(start + std::chrono::milliseconds(500)) == 1);
+}
+
+TEST_CASE("Log lines are formatted, cut off and written by the logger.") {
+    std::ostringstream output;
+    Logger::instance().setOutput(output);
+
+    V2V_LOG(INFO) << "speed " << 0.25f << " count " << 42 << " id " << (uint16_t) 7 << ' ' << true << " "
+                  << std::string("done");
+    V2V_LOG(ERROR) << std::string(LOG_LINE_SIZE + 40, 'x');
+    Logger::instance().flush();
+
+    std::string written = output.str();
+    REQUIRE(written.find("speed 0.25 count 42 id 7 1 done\n") == 0);
+    REQUIRE(written.find(std::string(LOG_LINE_SIZE, 'x') + "\n") != std::string::npos);
+    REQUIRE(written.find(std::string(LOG_LINE_SIZE + 1, 'x')) == std::string::npos);
+
+    Logger::instance().setOutput(std::cout);
+}
+
+TEST_CASE("Log statements below the compiled in level do not evaluate their arguments.") {
+    std::ostringstream output;
+    Logger::instance().setOutput(output);
+
+    int evaluated = 0;
+    V2V_LOG(DEBUG) << "debug " << ++evaluated;
+    for (int i = 0; i < 3; i++) {
+        V2V_LOG_EVERY(WARNING, 60000) << "warning " << i << " " << ++evaluated;
+    }
+    Logger::instance().flush();
+
+    // V2V_LOG_LEVEL defaults to info, only the first of the rate limited warnings gets through.
+    REQUIRE(evaluated == (V2V_LOG_IS_ON(LogLevel::LOG_DEBUG) ? 2 : 1));
+    REQUIRE(output.str().find("warning 0 ") != std::string::npos);
+    REQUIRE(output.str().find("warning 1 ") == std::string::npos);
+
+    Logger::instance().setOutput(std::cout);
+}
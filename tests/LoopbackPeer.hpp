@@ -0,0 +1,84 @@
+#ifndef V2V_TESTS_LOOPBACK_PEER_H
+#define V2V_TESTS_LOOPBACK_PEER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "v2v/framing.hpp"
+#include "v2v/multicast.hpp"
+
+/**
+ * UDP socket on a free loopback port, standing in for a peer.
+ */
+class LoopbackPeer {
+public:
+    LoopbackPeer() {
+        fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = inet_addr("127.0.0.1");
+        ::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        ::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+        port = ntohs(address.sin_port);
+
+        timeval timeout = {1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~LoopbackPeer() {
+        ::close(fd);
+    }
+
+    // Empty if nothing arrived within a second.
+    std::string receive() {
+        char buffer[MAX_FRAME_SIZE];
+        ssize_t length = ::recv(fd, buffer, sizeof(buffer), 0);
+        return length > 0 ? std::string(buffer, static_cast<size_t>(length)) : std::string();
+    }
+
+    int fd;
+    uint16_t port;
+};
+
+/**
+ * Member of a multicast group on the loopback interface, standing in for a follower that joined it.
+ */
+class MulticastPeer {
+public:
+    MulticastPeer(const std::string &group, uint16_t port) :
+        receiver(group, port, "127.0.0.1",
+                 [this](std::string &&data, std::string &&, std::chrono::system_clock::time_point &&) {
+                     std::lock_guard<std::mutex> lock(mutex);
+                     received.push_back(std::move(data));
+                     arrived.notify_all();
+                 }) {}
+
+    // Empty if nothing arrived within a second.
+    std::string receive() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!arrived.wait_for(lock, std::chrono::seconds(1), [this] { return !received.empty(); })) {
+            return std::string();
+        }
+        std::string data = std::move(received.front());
+        received.pop_front();
+        return data;
+    }
+
+    std::mutex mutex;
+    std::condition_variable arrived;
+    std::deque<std::string> received;
+    // Declared last, so it is destroyed first and stops before what it writes to goes away.
+    MulticastReceiver receiver;
+};
+
+#endif // V2V_TESTS_LOOPBACK_PEER_H
@@ -0,0 +1,120 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "v2v/peer_registry.hpp"
+
+using namespace std::chrono;
+
+
+TEST_CASE("PeerRegistry looks cars up by group id and by IP.") {
+    ManualTimeSource time;
+    PeerRegistry registry(seconds(60), time);
+    REQUIRE(registry.snapshot()->empty());
+
+    REQUIRE(registry.announce("7", "10.0.0.7"));
+    REQUIRE(registry.announce("8", "10.0.0.8"));
+    // Announcing again at the same IP only refreshes the car.
+    REQUIRE_FALSE(registry.announce("7", "10.0.0.7"));
+
+    std::shared_ptr<const PeerSnapshot> snapshot = registry.snapshot();
+    REQUIRE(snapshot->size() == 2);
+    REQUIRE(snapshot->byGroupId("7")->ip == "10.0.0.7");
+    REQUIRE(snapshot->byIp("10.0.0.8")->groupId == "8");
+    REQUIRE(snapshot->byGroupId("9") == nullptr);
+    REQUIRE(snapshot->byIp("10.0.0.9") == nullptr);
+    REQUIRE(snapshot->byGroupId("7")->id != snapshot->byGroupId("8")->id);
+}
+
+TEST_CASE("PeerRegistry follows cars that change their IP or take over another one.") {
+    ManualTimeSource time;
+    PeerRegistry registry(seconds(60), time);
+    registry.announce("7", "10.0.0.7");
+    registry.announce("8", "10.0.0.8");
+    std::shared_ptr<const PeerSnapshot> before = registry.snapshot();
+    PeerId id = before->byGroupId("7")->id;
+
+    REQUIRE(registry.announce("7", "10.0.0.70"));
+    std::shared_ptr<const PeerSnapshot> moved = registry.snapshot();
+    REQUIRE(moved->byGroupId("7")->ip == "10.0.0.70");
+    REQUIRE(moved->byGroupId("7")->id == id);
+    REQUIRE(moved->byIp("10.0.0.7") == nullptr);
+
+    // A car restarted under another group id replaces the one announced at its IP.
+    REQUIRE(registry.announce("9", "10.0.0.8"));
+    std::shared_ptr<const PeerSnapshot> takenOver = registry.snapshot();
+    REQUIRE(takenOver->size() == 2);
+    REQUIRE(takenOver->byGroupId("8") == nullptr);
+    REQUIRE(takenOver->byIp("10.0.0.8")->groupId == "9");
+
+    // Snapshots taken earlier do not change.
+    REQUIRE(before->size() == 2);
+    REQUIRE(before->byGroupId("7")->ip == "10.0.0.7");
+    REQUIRE(before->byGroupId("8")->ip == "10.0.0.8");
+}
+
+TEST_CASE("PeerRegistry forgets cars once they have been silent for the time to live.") {
+    ManualTimeSource time;
+    PeerRegistry registry(seconds(60), time);
+    registry.announce("7", "10.0.0.7");
+    registry.announce("8", "10.0.0.8");
+
+    time.advance(seconds(40));
+    registry.announce("8", "10.0.0.8");
+    std::shared_ptr<const PeerSnapshot> snapshot = registry.snapshot();
+    REQUIRE(registry.age(*snapshot->byGroupId("7")) == seconds(40));
+    REQUIRE(registry.age(*snapshot->byGroupId("8")) == seconds(0));
+
+    time.advance(seconds(20));
+    REQUIRE(registry.expire() == 0);
+    time.advance(milliseconds(1));
+    REQUIRE(registry.expire() == 1);
+    REQUIRE(registry.snapshot()->byGroupId("7") == nullptr);
+    REQUIRE(registry.snapshot()->byGroupId("8") != nullptr);
+
+    // A forgotten car comes back under the id it had.
+    PeerId id = snapshot->byGroupId("7")->id;
+    REQUIRE(registry.announce("7", "10.0.0.7"));
+    REQUIRE(registry.snapshot()->byGroupId("7")->id == id);
+
+    time.advance(seconds(61));
+    REQUIRE(registry.expire() == 2);
+    REQUIRE(registry.snapshot()->empty());
+}
+
+TEST_CASE("PeerRegistry snapshots can be read while cars announce themselves.") {
+    PeerRegistry registry(seconds(60));
+    std::vector<std::string> groups;
+    for (int i = 0; i < 50; i++) {
+        groups.push_back(std::to_string(i));
+        registry.announce(groups.back(), "10.0.1." + std::to_string(i));
+    }
+
+    std::atomic<bool> running(true);
+    std::thread writer([&]() {
+        for (int i = 0; i < 20000; i++) {
+            // Every hundredth announcement moves a car, which publishes a new snapshot.
+            std::string ip = "10.0." + std::to_string(i % 100 == 0 ? 2 : 1) + "." + std::to_string(i % 50);
+            registry.announce(groups[i % 50], ip);
+        }
+        running = false;
+    });
+
+    size_t found = 0;
+    while (running) {
+        std::shared_ptr<const PeerSnapshot> snapshot = registry.snapshot();
+        REQUIRE(snapshot->size() == 50);
+        for (const PeerEntry &peer : snapshot->entries()) {
+            REQUIRE(snapshot->byIp(peer.ip) == &peer);
+            REQUIRE(registry.age(peer) >= milliseconds(0));
+            found++;
+        }
+    }
+    writer.join();
+    REQUIRE(found > 0);
+}
@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "catch.hpp"
+
+#include "recorder/recording.hpp"
+
+template <class T>
+static void append(std::string &bytes, const T &value) {
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/*
+ * A chunk as the recorder writes it, a record every 10 us from firstMicros, each holding its number as payload.
+ */
+static std::string chunkOf(uint32_t first, uint32_t count, int64_t firstMicros) {
+    std::string records;
+    std::string index;
+    for (uint32_t i = 0; i < count; i++) {
+        RecordHeader header = {};
+        header.receivedMicros = firstMicros + i * 10;
+        header.dataType = 1001;
+        header.channel = 181;
+        header.length = sizeof(uint32_t);
+        if (i % RECORD_INDEX_STRIDE == 0) {
+            append(index, IndexEntry{header.receivedMicros, static_cast<uint32_t>(records.size()), 0});
+        }
+        append(records, header);
+        append(records, first + i);
+    }
+    ChunkHeader chunk = {CHUNK_MAGIC, count, static_cast<uint32_t>(records.size()),
+                         static_cast<uint32_t>(index.size() / sizeof(IndexEntry)), firstMicros,
+                         firstMicros + (count - 1) * 10};
+    std::string bytes;
+    append(bytes, chunk);
+    return bytes + records + index;
+}
+
+static uint32_t numberOf(const RecordView &record) {
+    uint32_t number;
+    std::memcpy(&number, record.data, sizeof(number));
+    return number;
+}
+
+TEST_CASE("RecordingReader reads and seeks the complete chunks of a recording cut short.") {
+    RecordingHeader header = {};
+    std::memcpy(header.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    header.version = RECORDING_VERSION;
+    std::string bytes;
+    append(bytes, header);
+    bytes += chunkOf(0, 200, 1000000);
+    bytes += chunkOf(200, 100, 1005000);
+    // Power lost halfway through writing the third chunk.
+    std::string torn = chunkOf(300, 100, 1010000);
+    bytes += torn.substr(0, torn.size() / 2);
+
+    char path[] = "/tmp/RecordingReaderTestsXXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    REQUIRE(write(fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size()));
+    close(fd);
+
+    RecordingReader reader;
+    REQUIRE(reader.open(path));
+    std::remove(path);
+    REQUIRE(reader.chunks() == 2);
+    REQUIRE(reader.records() == 300);
+    REQUIRE(reader.chunk(1).firstMicros == 1005000);
+
+    RecordView record;
+    uint32_t expected = 0;
+    while (reader.next(record)) {
+        REQUIRE(numberOf(record) == expected);
+        REQUIRE(record.header.channel == 181);
+        expected++;
+    }
+    REQUIRE(expected == 300);
+
+    // Between two indexed records, on an exact time, between two chunks and past the end.
+    reader.seek(1000000 + 70 * 10 - 5);
+    REQUIRE(reader.next(record));
+    REQUIRE(numberOf(record) == 70);
+    reader.seek(1000000 + 128 * 10);
+    REQUIRE(reader.next(record));
+    REQUIRE(numberOf(record) == 128);
+    reader.seek(1003000);
+    REQUIRE(reader.next(record));
+    REQUIRE(numberOf(record) == 200);
+    REQUIRE(reader.next(record));
+    REQUIRE(numberOf(record) == 201);
+    reader.seek(1010000);
+    REQUIRE_FALSE(reader.next(record));
+
+    REQUIRE_FALSE(reader.open("/nonexistent/recording.g7r"));
+}
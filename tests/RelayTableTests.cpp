@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "visualisation/relay_table.hpp"
+#include "visualisation/visualisation.hpp"
+
+TEST_CASE("RelayTable reads channels with their message types and wildcards.") {
+    RelayTable table;
+    REQUIRE(RelayTable::parse("250:1001;181:2001,3001;180:*", table));
+
+    REQUIRE(table.relays(250, 1001));
+    REQUIRE_FALSE(table.relays(250, 1002));
+    REQUIRE(table.relays(181, 2001));
+    REQUIRE(table.relays(181, 3001));
+    REQUIRE_FALSE(table.relays(181, 1001));
+    REQUIRE(table.relays(180, 1041));
+    REQUIRE(table.relays(180, 1045));
+    REQUIRE(table.relays(180, 0));
+    REQUIRE_FALSE(table.relays(182, 1001));
+    REQUIRE(table.channels() == std::vector<uint16_t>({250, 181, 180}));
+
+    // Written back sorted per channel, and read back the same.
+    REQUIRE(table.toString() == "250:1001;181:2001,3001;180:*");
+    RelayTable again;
+    REQUIRE(RelayTable::parse(table.toString(), again));
+    REQUIRE(again.toString() == table.toString());
+
+    // Types are merged per channel, a wildcard next to types relays everything.
+    REQUIRE(RelayTable::parse("181:3001;181:2001,2001;;180:1041,*", table));
+    REQUIRE(table.toString() == "181:2001,3001;180:*,1041");
+    REQUIRE(table.relays(180, 1039));
+}
+
+TEST_CASE("RelayTable rejects a malformed list as a whole.") {
+    RelayTable table;
+    REQUIRE(RelayTable::parse("250:1001", table));
+
+    const std::vector<std::string> malformed = {
+        "181",              // no types
+        "181:",             // empty list of types
+        ":2001",            // no channel
+        "x:2001",           // channel not a number
+        "0:2001",           // channel out of range
+        "65536:2001",       // channel out of range
+        "181:2001,",        // empty type
+        "181:20x1",         // type not a number
+        "181:-5",           // negative type
+        "181:2001;180:abc", // valid channel before a broken one
+    };
+    for (const std::string &spec : malformed) {
+        INFO(spec);
+        REQUIRE_FALSE(RelayTable::parse(spec, table));
+        // Nothing of it is applied, not even the valid part.
+        REQUIRE(table.toString() == "250:1001");
+    }
+
+    REQUIRE(RelayTable::parse("", table));
+    REQUIRE(table.channels().empty());
+}
+
+TEST_CASE("The default relay routes relay what the switch statements of VIZService did.") {
+    RelayTable table(DEFAULT_RELAY_ROUTES);
+
+    // The cases of the switch statement per channel, before the relay table replaced them.
+    const std::vector<RelayRoute> switched = {
+        {BROADCAST_CHANNEL, ANNOUNCE_PRESENCE},
+        {INTERNAL_BROADCAST_CHANNEL, FOLLOW_REQUEST},
+        {INTERNAL_BROADCAST_CHANNEL, FOLLOW_RESPONSE},
+        {INTERNAL_BROADCAST_CHANNEL, STOP_FOLLOW},
+        {INTERNAL_BROADCAST_CHANNEL, FOLLOWER_STATUS},
+        {INTERNAL_BROADCAST_CHANNEL, LEADER_STATUS},
+        {INTERNAL_BROADCAST_CHANNEL, INTERNAL_ANNOUNCE_PRESENCE},
+        {INTERNAL_BROADCAST_CHANNEL, INTERNAL_FOLLOW_REQUEST},
+        {INTERNAL_BROADCAST_CHANNEL, INTERNAL_STOP_FOLLOW_REQUEST},
+        {INTERNAL_BROADCAST_CHANNEL, INTERNAL_GET_ALL_GROUPS_REQUEST},
+        {INTERNAL_BROADCAST_CHANNEL, INTERNAL_EMERGENCY_BRAKE},
+        {MOTOR_BROADCAST_CHANNEL, DISTANCE_READING},
+        {MOTOR_BROADCAST_CHANNEL, PEDAL_POSITION_READING},
+        {MOTOR_BROADCAST_CHANNEL, GROUND_STEERING_READING},
+    };
+    const std::vector<int32_t> types = {
+        ANNOUNCE_PRESENCE, FOLLOW_REQUEST, FOLLOW_RESPONSE, STOP_FOLLOW, LEADER_STATUS, FOLLOWER_STATUS,
+        INTERNAL_FOLLOW_REQUEST, INTERNAL_FOLLOW_RESPONSE, INTERNAL_STOP_FOLLOW_REQUEST, INTERNAL_STOP_FOLLOW_RESPONSE,
+        INTERNAL_GET_ALL_GROUPS_REQUEST, INTERNAL_GET_ALL_GROUPS_RESPONSE, INTERNAL_EMERGENCY_BRAKE,
+        INTERNAL_ANNOUNCE_PRESENCE, DISTANCE_READING, PEDAL_POSITION_READING, GROUND_STEERING_READING,
+    };
+
+    for (uint16_t channel : {BROADCAST_CHANNEL, INTERNAL_BROADCAST_CHANNEL, MOTOR_BROADCAST_CHANNEL,
+                             VISUALIZATION_CHANNEL}) {
+        for (int32_t dataType : types) {
+            bool expected = false;
+            for (const RelayRoute &route : switched) {
+                expected = expected || (route.channel == channel && route.dataType == dataType);
+            }
+            INFO(channel << ":" << dataType);
+            REQUIRE(table.relays(channel, dataType) == expected);
+        }
+    }
+    REQUIRE(table.channels() == std::vector<uint16_t>({BROADCAST_CHANNEL, INTERNAL_BROADCAST_CHANNEL,
+                                                       MOTOR_BROADCAST_CHANNEL}));
+}
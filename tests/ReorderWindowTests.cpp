@@ -0,0 +1,188 @@
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "v2v/framing.hpp"
+#include "v2v/reorder_window.hpp"
+#include "v2v/send_pool.hpp"
+
+#include "FaultInjectingLink.hpp"
+#include "LoopbackPeer.hpp"
+
+using namespace std::chrono;
+
+static LeaderStatus numbered(uint32_t sequence) {
+    LeaderStatus status;
+    status.timestamp(1525000000000 + 125 * sequence);
+    status.speed(0.01f * sequence);
+    status.steeringAngle(-0.1f);
+    status.distanceTraveled(static_cast<uint8_t>(2 * sequence));
+    status.sequence(sequence);
+    return status;
+}
+
+/*
+ * Feeds the statuses with the given sequence numbers to the window, 1 ms apart, and returns the sequence numbers
+ * released.
+ */
+static std::vector<uint32_t> feed(ReorderWindow &window, const std::vector<uint32_t> &sequences,
+                                  TimeSource::time_point &now) {
+    std::vector<uint32_t> out;
+    LeaderStatus released[REORDER_MAX_RELEASED];
+    for (uint32_t sequence : sequences) {
+        size_t count = window.accept(numbered(sequence), now, released);
+        for (size_t i = 0; i < count; i++) {
+            out.push_back(released[i].sequence());
+        }
+        now += milliseconds(1);
+    }
+    return out;
+}
+
+TEST_CASE("ReorderWindow passes statuses in order straight through and drops duplicates.") {
+    ReorderWindow window;
+    TimeSource::time_point now;
+    REQUIRE(feed(window, {5, 6, 7, 7, 8, 6}, now) == std::vector<uint32_t>({5, 6, 7, 8}));
+    REQUIRE(window.duplicates() == 2);
+    REQUIRE(window.lost() == 0);
+    REQUIRE(window.reordered() == 0);
+    REQUIRE(window.held() == 0);
+}
+
+TEST_CASE("ReorderWindow holds statuses back until the missing one arrives.") {
+    ReorderWindow window;
+    TimeSource::time_point now;
+    REQUIRE(feed(window, {1, 3, 4}, now) == std::vector<uint32_t>({1}));
+    REQUIRE(window.held() == 2);
+    REQUIRE(feed(window, {2, 4}, now) == std::vector<uint32_t>({2, 3, 4}));
+    REQUIRE(window.reordered() == 1);
+    REQUIRE(window.duplicates() == 1);
+    REQUIRE(window.lost() == 0);
+    REQUIRE(window.held() == 0);
+}
+
+TEST_CASE("ReorderWindow interpolates a short gap once the missing statuses were waited for long enough.") {
+    ReorderWindow window;
+    TimeSource::time_point now;
+    LeaderStatus released[REORDER_MAX_RELEASED];
+    REQUIRE(feed(window, {1, 4}, now) == std::vector<uint32_t>({1}));
+    REQUIRE(window.expire(now + REORDER_HOLD - milliseconds(2), released) == 0);
+
+    REQUIRE(window.expire(now + REORDER_HOLD, released) == 3);
+    REQUIRE(released[0].sequence() == 2);
+    REQUIRE(released[1].sequence() == 3);
+    REQUIRE(released[2].sequence() == 4);
+    REQUIRE(released[0].speed() == Approx(0.02f));
+    REQUIRE(released[1].timestamp() == numbered(3).timestamp());
+    REQUIRE(released[1].distanceTraveled() == 6);
+    REQUIRE(window.lost() == 2);
+    REQUIRE(window.interpolated() == 2);
+
+    // Too late now.
+    REQUIRE(feed(window, {2, 5}, now) == std::vector<uint32_t>({5}));
+    REQUIRE(window.late() == 1);
+    REQUIRE(window.duplicates() == 0);
+}
+
+TEST_CASE("ReorderWindow gives up on a long gap without making statuses up.") {
+    ReorderWindow window;
+    TimeSource::time_point now;
+    REQUIRE(feed(window, {1, 10, 11}, now) == std::vector<uint32_t>({1, 10, 11}));
+    REQUIRE(window.lost() == 8);
+    REQUIRE(window.interpolated() == 0);
+
+    // Holding REORDER_DEPTH statuses gives up on the missing one without waiting.
+    REQUIRE(feed(window, {13, 14, 15, 16}, now) == std::vector<uint32_t>({12, 13, 14, 15, 16}));
+    REQUIRE(window.lost() == 9);
+    REQUIRE(window.interpolated() == 1);
+}
+
+TEST_CASE("ReorderWindow never releases more than REORDER_MAX_RELEASED statuses at once.") {
+    ReorderWindow window;
+    TimeSource::time_point now;
+    feed(window, {1}, now);
+    // 2 to 4 and 7 to 9 are missing, 10 is too far ahead to be held.
+    std::vector<uint32_t> out = feed(window, {5, 6, 10}, now);
+    REQUIRE(out == std::vector<uint32_t>({2, 3, 4, 5, 6, 7, 8, 9, 10}));
+    REQUIRE(out.size() <= REORDER_MAX_RELEASED);
+}
+
+TEST_CASE("ReorderWindow releases statuses without a sequence number as they come and follows a restart.") {
+    ReorderWindow window;
+    TimeSource::time_point now;
+    REQUIRE(feed(window, {0, 0}, now) == std::vector<uint32_t>({0, 0}));
+    REQUIRE(feed(window, {200, 201}, now) == std::vector<uint32_t>({200, 201}));
+    REQUIRE(feed(window, {1, 2}, now) == std::vector<uint32_t>({1, 2}));
+    REQUIRE(window.late() == 0);
+    REQUIRE(window.lost() == 0);
+
+    window.reset();
+    REQUIRE(feed(window, {40, 41}, now) == std::vector<uint32_t>({40, 41}));
+}
+
+TEST_CASE("ReorderWindow puts a lossy, reordering and duplicating link back in order.") {
+    LoopbackPeer follower;
+    LinkFaults faults;
+    faults.loss = 0.05;
+    faults.duplicate = 0.05;
+    faults.reorder = 0.1;
+    faults.reorderDelay = milliseconds(6);
+    faults.jitter = milliseconds(2);
+    FaultInjectingLink link(follower.port, faults);
+
+    SendPool pool;
+    std::shared_ptr<PeerSendContext> toFollower = pool.acquire("127.0.0.1", link.port);
+    std::thread leader([&pool, &toFollower]() {
+        for (uint32_t sequence = 1; sequence <= 400; sequence++) {
+            LeaderStatus status = numbered(sequence);
+            pool.send(toFollower, status, Framing::BINARY);
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+    });
+
+    ReorderWindow window;
+    std::vector<uint32_t> out;
+    LeaderStatus released[REORDER_MAX_RELEASED];
+    uint64_t received = 0;
+    while (true) {
+        std::string data = follower.receive();
+        size_t count;
+        if (data.empty()) {
+            count = window.expire(TimeSource::time_point::max(), released);
+        } else {
+            received++;
+            Frame frame = extractFrame(data);
+            LeaderStatus status;
+            REQUIRE(decodeLeaderStatus(frame.payload, status));
+            count = window.accept(status, steady_clock::now(), released);
+        }
+        for (size_t i = 0; i < count; i++) {
+            out.push_back(released[i].sequence());
+        }
+        if (data.empty()) {
+            break;
+        }
+    }
+    leader.join();
+
+    REQUIRE(link.dropped() > 0);
+    REQUIRE(received == link.forwarded());
+    REQUIRE(window.held() == 0);
+    for (size_t i = 1; i < out.size(); i++) {
+        REQUIRE(out[i] > out[i - 1]);
+    }
+    REQUIRE(window.reordered() > 0);
+    REQUIRE(window.duplicates() > 0);
+
+    // Every sequence number up to the last one released was received once, dropped as a duplicate or late, or lost.
+    std::set<uint32_t> unique(out.begin(), out.end());
+    REQUIRE(unique.size() == out.size());
+    uint64_t span = out.back() - out.front() + 1;
+    REQUIRE(out.size() - window.interpolated() + window.lost() == span);
+    REQUIRE(received == out.size() - window.interpolated() + window.duplicates() + window.late());
+}
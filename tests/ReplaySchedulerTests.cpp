@@ -0,0 +1,58 @@
+#include <chrono>
+
+#include "catch.hpp"
+
+#include "v2v/replay_scheduler.hpp"
+
+using namespace std::chrono;
+
+
+TEST_CASE("ReplayScheduler spaces updates by their leader timestamps.") {
+    ReplayScheduler scheduler;
+
+    ReplayScheduler::Clock::time_point first = scheduler.schedule(10000);
+    ReplayScheduler::Clock::time_point second = scheduler.schedule(10100);
+    ReplayScheduler::Clock::time_point third = scheduler.schedule(10250);
+
+    REQUIRE(duration_cast<milliseconds>(second - first).count() == 100);
+    REQUIRE(duration_cast<milliseconds>(third - second).count() == 150);
+}
+
+TEST_CASE("ReplayScheduler falls back to the nominal spacing for untrusted timestamps.") {
+    ReplayScheduler scheduler;
+
+    ReplayScheduler::Clock::time_point previous = scheduler.schedule(0);
+    // No timestamp, a gap of several seconds, a timestamp going backwards and one not in milliseconds.
+    uint64_t timestamps[] = {0, 5000, 4000, 4001};
+    for (uint64_t timestamp : timestamps) {
+        ReplayScheduler::Clock::time_point next = scheduler.schedule(timestamp);
+        REQUIRE(next - previous == NOMINAL_UPDATE_SPACING);
+        previous = next;
+    }
+}
+
+TEST_CASE("ReplayScheduler carries extra delays over and restarts after a reset.") {
+    ReplayScheduler scheduler;
+
+    ReplayScheduler::Clock::time_point first = scheduler.schedule(1000);
+    ReplayScheduler::Clock::time_point delayed = scheduler.schedule(1125, milliseconds(150));
+    ReplayScheduler::Clock::time_point after = scheduler.schedule(1250);
+    REQUIRE(duration_cast<milliseconds>(delayed - first).count() == 275);
+    REQUIRE(duration_cast<milliseconds>(after - delayed).count() == 125);
+
+    scheduler.reset();
+    ReplayScheduler::Clock::time_point restarted = scheduler.schedule(1375);
+    REQUIRE(restarted - ReplayScheduler::Clock::now() <= NOMINAL_UPDATE_SPACING);
+}
+
+TEST_CASE("ReplayScheduler records the actuation jitter.") {
+    ReplayScheduler scheduler;
+
+    ReplayScheduler::Clock::time_point deadline = ReplayScheduler::Clock::now() + milliseconds(5);
+    scheduler.waitUntil(deadline);
+    scheduler.waitUntil(ReplayScheduler::Clock::now() - milliseconds(30));
+
+    REQUIRE(scheduler.jitter().count() == 2);
+    REQUIRE(scheduler.jitter().maxMicros() >= 30000);
+    REQUIRE(scheduler.jitter().percentileMicros(100) >= 30000);
+}
@@ -0,0 +1,141 @@
+#include <memory>
+#include <string>
+
+#include "catch.hpp"
+
+#include "v2v/framing.hpp"
+#include "v2v/send_pool.hpp"
+
+#include "LoopbackPeer.hpp"
+
+template <class T>
+static std::string cluonEncode(T &msg) {
+    cluon::ToProtoVisitor v;
+    msg.accept(v);
+    return v.encodedData();
+}
+
+template <class T>
+static std::string writerEncode(T &msg) {
+    Frame frame = extractFrame(encodeFrame(msg, Framing::BINARY));
+    REQUIRE(frame.id == T::ID());
+    return std::string(frame.payload.data, frame.payload.length);
+}
+
+TEST_CASE("Frames are encoded to the same bytes as cluon's ToProtoVisitor encodes.") {
+    LeaderStatus leaderStatus;
+    leaderStatus.timestamp(1525000000125);
+    leaderStatus.speed(0.17f);
+    leaderStatus.steeringAngle(-0.25f);
+    leaderStatus.distanceTraveled(13);
+    leaderStatus.timestampMicros(1525000000125000);
+    leaderStatus.echoSentMicros(1524999999988000);
+    leaderStatus.sequence(70001);
+    REQUIRE(writerEncode(leaderStatus) == cluonEncode(leaderStatus));
+
+    FollowerStatus followerStatus;
+    followerStatus.sentMicros(1525000000500000);
+    REQUIRE(writerEncode(followerStatus) == cluonEncode(followerStatus));
+
+    FollowRequest followRequest;
+    followRequest.framing(static_cast<uint8_t>(Framing::BINARY));
+    REQUIRE(writerEncode(followRequest) == cluonEncode(followRequest));
+
+    StopFollow stopFollow;
+    REQUIRE(writerEncode(stopFollow) == cluonEncode(stopFollow));
+
+    AnnouncePresence announcePresence;
+    announcePresence.vehicleIp("192.168.1.7");
+    announcePresence.groupId("7");
+    announcePresence.capabilities(3);
+    REQUIRE(writerEncode(announcePresence) == cluonEncode(announcePresence));
+
+    InternalGetAllGroupsBatch batch;
+    batch.batchId(300);
+    batch.page(2);
+    batch.pageCount(5);
+    batch.total(70000);
+    batch.groups("1,10.0.0.1,20,3\n");
+    REQUIRE(writerEncode(batch) == cluonEncode(batch));
+}
+
+TEST_CASE("SendPool sends the statuses queued for several peers with one system call.") {
+    LoopbackPeer leader, follower;
+    SendPool pool;
+    std::shared_ptr<PeerSendContext> toLeader = pool.acquire("127.0.0.1", leader.port);
+    std::shared_ptr<PeerSendContext> toFollower = pool.acquire("127.0.0.1", follower.port);
+
+    FollowerStatus followerStatus;
+    followerStatus.sentMicros(42);
+    LeaderStatus leaderStatus;
+    leaderStatus.speed(0.2f);
+    StopFollow stopFollow;
+    pool.queue(toLeader, followerStatus, Framing::BINARY);
+    pool.queue(toFollower, leaderStatus, Framing::LEGACY_HEX);
+    pool.queue(toFollower, stopFollow, Framing::LEGACY_HEX);
+    REQUIRE(pool.datagramsSent() == 0);
+
+    REQUIRE(pool.flush() == 3);
+    REQUIRE(pool.datagramsSent() == 3);
+#ifdef __linux__
+    REQUIRE(pool.sendCalls() == 1);
+#endif
+    REQUIRE(pool.sendErrors() == 0);
+    REQUIRE(pool.flush() == 0);
+
+    std::string data = leader.receive();
+    Frame frame = extractFrame(data);
+    REQUIRE(frame.id == FollowerStatus::ID());
+    REQUIRE(static_cast<uint8_t>(data[0]) == BINARY_FRAME_MAGIC);
+    REQUIRE(decodePayload<FollowerStatus>(frame.payload).sentMicros() == 42);
+
+    data = follower.receive();
+    frame = extractFrame(data);
+    REQUIRE(frame.id == LeaderStatus::ID());
+    REQUIRE(decodePayload<LeaderStatus>(frame.payload).speed() == 0.2f);
+    REQUIRE(extractFrame(follower.receive()).id == StopFollow::ID());
+}
+
+TEST_CASE("SendPool flushes early instead of overwriting a queued message.") {
+    LoopbackPeer follower;
+    SendPool pool;
+    std::shared_ptr<PeerSendContext> toFollower = pool.acquire("127.0.0.1", follower.port);
+
+    for (uint64_t i = 1; i <= 2; i++) {
+        LeaderStatus leaderStatus;
+        leaderStatus.timestamp(i);
+        pool.queue(toFollower, leaderStatus, Framing::BINARY);
+    }
+    REQUIRE(pool.datagramsSent() == 1);
+    REQUIRE(pool.flush() == 1);
+
+    for (uint64_t i = 1; i <= 2; i++) {
+        std::string data = follower.receive();
+        Frame frame = extractFrame(data);
+        LeaderStatus received;
+        REQUIRE(decodeLeaderStatus(frame.payload, received));
+        REQUIRE(received.timestamp() == i);
+    }
+}
+
+TEST_CASE("SendPool keeps the context of a known peer and evicts the least recently used one.") {
+    SendPool pool(2);
+    std::shared_ptr<PeerSendContext> first = pool.acquire("10.0.0.1", 50001);
+    std::weak_ptr<PeerSendContext> second = pool.acquire("10.0.0.2", 50001);
+    REQUIRE(pool.acquire("10.0.0.1", 50001) == first);
+    REQUIRE(pool.acquire("10.0.0.1", 50002) != first);
+    REQUIRE(pool.size() == 2);
+
+    // The second peer was used least recently and is not held, it made room for the other port of the first one.
+    REQUIRE(second.expired());
+    pool.acquire("10.0.0.3", 50001);
+    REQUIRE(pool.size() == 2);
+    REQUIRE(pool.acquire("10.0.0.1", 50001) == first);
+
+    // A held context is never evicted, the pool grows instead.
+    std::shared_ptr<PeerSendContext> third = pool.acquire("10.0.0.3", 50001);
+    std::shared_ptr<PeerSendContext> fourth = pool.acquire("10.0.0.4", 50001);
+    REQUIRE(pool.size() == 3);
+    REQUIRE(fourth->ip() == "10.0.0.4");
+    REQUIRE(fourth->port() == 50001);
+}
@@ -0,0 +1,90 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "v2v/seqlock.hpp"
+#include "v2v/v2v.hpp"
+
+/*
+ * Build with -DWITH_TSAN=ON to run these under ThreadSanitizer, which checks that readers racing with the writer are
+ * not data races.
+ */
+
+TEST_CASE("SeqLock returns the last stored value.") {
+    SeqLock<CarStatus> status;
+    REQUIRE(status.load().speed == 0);
+    REQUIRE(status.version() == 1);
+
+    CarStatus update = {0.3f, -0.2f, std::chrono::steady_clock::now()};
+    status.store(update);
+
+    CarStatus read = status.load();
+    REQUIRE(read.speed == 0.3f);
+    REQUIRE(read.steeringAngle == -0.2f);
+    REQUIRE(read.sampled == update.sampled);
+    REQUIRE(status.version() == 2);
+}
+
+TEST_CASE("SeqLock readers never see a status that was not stored as a whole.") {
+    const int stores = 200000;
+    const int readerCount = 3;
+
+    SeqLock<CarStatus> status(CarStatus{0, 0, std::chrono::steady_clock::time_point()});
+    std::atomic<bool> done(false);
+    std::atomic<int> started(0);
+    std::vector<int> torn(readerCount, 0);
+    std::vector<int> reads(readerCount, 0);
+    std::vector<int> backwards(readerCount, 0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < readerCount; r++) {
+        readers.push_back(std::thread([&, r]() {
+            float lastSpeed = 0;
+            started++;
+            // At least one read, even if the writer was done before this reader got to run.
+            do {
+                // Every stored status has the steering angle mirror the speed and the time set to the speed.
+                CarStatus read = status.load();
+                if (read.steeringAngle != -read.speed ||
+                    read.sampled.time_since_epoch().count() != (int64_t) read.speed) {
+                    torn[r]++;
+                }
+                if (read.speed < lastSpeed) {
+                    backwards[r]++;
+                }
+                lastSpeed = read.speed;
+                reads[r]++;
+            } while (!done.load());
+        }));
+    }
+
+    std::thread writer([&]() {
+        // Only start once every reader runs, so the reads race with the stores even on a single core.
+        while (started.load() < readerCount) {
+            std::this_thread::yield();
+        }
+        for (int i = 1; i <= stores; i++) {
+            CarStatus update;
+            update.speed = (float) i;
+            update.steeringAngle = -(float) i;
+            update.sampled = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(i));
+            status.store(update);
+        }
+        done = true;
+    });
+
+    writer.join();
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    for (int r = 0; r < readerCount; r++) {
+        REQUIRE(reads[r] > 0);
+        REQUIRE(torn[r] == 0);
+        REQUIRE(backwards[r] == 0);
+    }
+    REQUIRE(status.load().speed == (float) stores);
+    REQUIRE(status.version() == (uint64_t) stores + 1);
+}
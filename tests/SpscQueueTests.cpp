@@ -0,0 +1,93 @@
+#include <cstdint>
+#include <thread>
+
+#include "catch.hpp"
+
+#include "v2v/spsc_queue.hpp"
+
+
+TEST_CASE("SpscQueue keeps FIFO order.") {
+    SpscQueue<int, 8> queue;
+    REQUIRE(queue.empty());
+
+    for (int i = 0; i < 5; i++) {
+        REQUIRE(queue.push(i));
+    }
+    REQUIRE(queue.size() == 5);
+
+    int value;
+    for (int i = 0; i < 5; i++) {
+        REQUIRE(queue.pop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE_FALSE(queue.pop(value));
+}
+
+TEST_CASE("SpscQueue counts overflows and tracks the high water mark.") {
+    SpscQueue<int, 4> queue;
+
+    for (int i = 0; i < 6; i++) {
+        queue.push(i);
+    }
+    REQUIRE(queue.size() == 4);
+    REQUIRE(queue.overflows() == 2);
+    REQUIRE(queue.highWaterMark() == 4);
+
+    // The oldest elements are kept, the rejected pushes are the newest ones.
+    int value;
+    REQUIRE(queue.pop(value));
+    REQUIRE(value == 0);
+
+    queue.clear();
+    REQUIRE(queue.empty());
+    REQUIRE(queue.highWaterMark() == 4);
+
+    // Wrapping around the end of the storage.
+    for (int i = 0; i < 10; i++) {
+        REQUIRE(queue.push(i));
+        REQUIRE(queue.pop(value));
+        REQUIRE(value == i);
+    }
+}
+
+struct Pair {
+    uint64_t first;
+    uint64_t second;
+};
+
+TEST_CASE("SpscQueue stress test with one producer and one consumer thread.") {
+    static const uint64_t ITEMS = 2000000;
+    SpscQueue<Pair, 256> queue;
+
+    std::thread producer([&queue]() {
+        for (uint64_t i = 0; i < ITEMS; i++) {
+            Pair item = {i, ~i};
+            while (!queue.push(item)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t expected = 0;
+    uint64_t outOfOrder = 0;
+    uint64_t torn = 0;
+    while (expected < ITEMS) {
+        Pair item;
+        if (!queue.pop(item)) {
+            // On a single core the producer only gets to run when we give way.
+            std::this_thread::yield();
+            continue;
+        }
+        if (item.first != expected) outOfOrder++;
+        if (item.second != ~item.first) torn++;
+        expected = item.first + 1;
+    }
+    producer.join();
+
+    REQUIRE(outOfOrder == 0);
+    REQUIRE(torn == 0);
+    REQUIRE(queue.empty());
+    REQUIRE(queue.highWaterMark() <= 256);
+    // Every rejected push was retried, so each overflow corresponds to the queue actually being full.
+    REQUIRE((queue.overflows() == 0 || queue.highWaterMark() == 256));
+}
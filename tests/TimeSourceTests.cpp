@@ -0,0 +1,202 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "catch.hpp"
+
+#include "v2v/event_loop.hpp"
+#include "v2v/liveness_tracker.hpp"
+#include "v2v/replay_scheduler.hpp"
+#include "v2v/time_source.hpp"
+
+using namespace std::chrono;
+
+/*
+ * Waits in real time for another thread to catch up with the simulated time.
+ */
+template <class Condition>
+static bool eventually(Condition condition) {
+    steady_clock::time_point giveUp = steady_clock::now() + seconds(5);
+    while (!condition()) {
+        if (steady_clock::now() > giveUp) {
+            return false;
+        }
+        std::this_thread::sleep_for(microseconds(100));
+    }
+    return true;
+}
+
+TEST_CASE("ManualTimeSource only moves when advanced, wall clock steps leave the monotonic clock alone.") {
+    ManualTimeSource time;
+    TimeSource::time_point start = time.now();
+    int64_t wallStart = time.wallMicros();
+
+    std::this_thread::sleep_for(milliseconds(2));
+    REQUIRE(time.now() == start);
+
+    time.advance(milliseconds(125));
+    REQUIRE(time.now() - start == milliseconds(125));
+    REQUIRE(time.wallMicros() - wallStart == 125000);
+    REQUIRE(time.wallMillis() == (uint64_t) (wallStart / 1000 + 125));
+
+    // NTP stepping the system time back an hour.
+    time.stepWallClock(hours(-1));
+    REQUIRE(time.now() - start == milliseconds(125));
+    REQUIRE(time.wallMicros() - wallStart == 125000 - 3600000000LL);
+
+    time.advanceTo(start + milliseconds(100));
+    REQUIRE(time.now() - start == milliseconds(125));
+    time.advanceTo(start + seconds(1));
+    REQUIRE(time.now() - start == seconds(1));
+}
+
+TEST_CASE("ManualTimeSource keeps track of the threads waiting on it, to step them from deadline to deadline.") {
+    ManualTimeSource time;
+    TimeSource::time_point start = time.now();
+    REQUIRE(time.parked() == 0);
+    REQUIRE(time.nextDeadline() == TimeSource::time_point::max());
+
+    std::atomic<int> wakeups(0);
+    std::thread sleeper([&]() {
+        for (int i = 1; i <= 3; i++) {
+            time.sleepUntil(start + milliseconds(100 * i));
+            wakeups++;
+        }
+    });
+    REQUIRE(time.settle(1, seconds(5)));
+    REQUIRE(time.nextDeadline() == start + milliseconds(100));
+
+    // Each advance to the next deadline wakes the thread exactly once, however long it takes to get going again.
+    for (int i = 1; i <= 2; i++) {
+        time.advanceTo(time.nextDeadline());
+        REQUIRE(time.settle(1, seconds(5)));
+        REQUIRE(wakeups.load() == i);
+        REQUIRE(time.nextDeadline() == start + milliseconds(100 * (i + 1)));
+    }
+
+    // Nothing left waiting, so nothing to settle on.
+    time.advanceTo(time.nextDeadline());
+    sleeper.join();
+    REQUIRE(wakeups.load() == 3);
+    REQUIRE(time.parked() == 0);
+    REQUIRE_FALSE(time.settle(1, milliseconds(5)));
+}
+
+TEST_CASE("ManualTimeSource settles only once a signalled thread has handled the signal.") {
+    ManualTimeSource time;
+    std::mutex mutex;
+    std::condition_variable signal;
+    int requested = 0;
+    std::atomic<int> handled(0);
+    std::atomic<bool> stopping(false);
+    std::thread waiter([&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            int seen = handled.load();
+            time.waitUntil(lock, signal, TimeSource::time_point::max(),
+                           [&]() { return requested > seen || stopping; });
+            if (requested > seen) {
+                // Slow to get going again, as a loaded machine would be.
+                lock.unlock();
+                std::this_thread::sleep_for(milliseconds(20));
+                lock.lock();
+                handled++;
+            }
+        }
+    });
+    REQUIRE(time.settle(1, seconds(5)));
+
+    for (int i = 1; i <= 3; i++) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requested = i;
+        }
+        signal.notify_one();
+        REQUIRE(time.settle(1, seconds(5)));
+        REQUIRE(handled.load() == i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    signal.notify_one();
+    waiter.join();
+}
+
+TEST_CASE("ReplayScheduler in simulated time.") {
+    ManualTimeSource time;
+    ReplayScheduler scheduler(time);
+
+    ReplayScheduler::Clock::time_point first = scheduler.schedule(10000);
+    REQUIRE(first == time.now() + NOMINAL_UPDATE_SPACING);
+    REQUIRE(scheduler.schedule(10100) == first + milliseconds(100));
+
+    // A leader that stalled for seconds is not replayed in a burst.
+    time.advance(seconds(5));
+    REQUIRE(scheduler.schedule(15100) == time.now());
+
+    // The follower thread sleeps until the simulated time reaches the deadline.
+    ReplayScheduler::Clock::time_point deadline = scheduler.schedule(15225);
+    std::atomic<bool> woken(false);
+    std::thread follower([&]() {
+        scheduler.waitUntil(deadline);
+        woken = true;
+    });
+    time.advance(milliseconds(100));
+    std::this_thread::sleep_for(milliseconds(5));
+    REQUIRE_FALSE(woken.load());
+
+    time.advanceTo(deadline);
+    follower.join();
+    REQUIRE(woken.load());
+    REQUIRE(scheduler.jitter().count() == 1);
+    REQUIRE(scheduler.jitter().maxMicros() == 0);
+}
+
+TEST_CASE("EventLoop thread runs tasks as the simulated time advances.") {
+    ManualTimeSource time;
+    EventLoop loop(true, time);
+    std::atomic<int> runs(0);
+
+    loop.arm(milliseconds(100), [&]() { runs++; });
+    REQUIRE(eventually([&]() { return runs.load() == 1; }));
+
+    for (int i = 2; i <= 10; i++) {
+        time.advance(milliseconds(100));
+        REQUIRE(eventually([&]() { return runs.load() == i; }));
+    }
+
+    // Half a period more does not make the next run due.
+    time.advance(milliseconds(50));
+    std::this_thread::sleep_for(milliseconds(5));
+    REQUIRE(runs.load() == 10);
+
+    loop.stop();
+}
+
+TEST_CASE("LivenessTracker times out in simulated time, regardless of the wall clock.") {
+    ManualTimeSource time;
+    LivenessTracker tracker(milliseconds(10), time);
+    int lost = 0;
+
+    tracker.watch("leader", milliseconds(1000), milliseconds(125), [&](const std::string &) { lost++; });
+    time.advance(milliseconds(500));
+    tracker.heard("leader");
+
+    // NTP steps the system time forward, which used to look like a second of silence.
+    time.stepWallClock(seconds(10));
+    time.advance(milliseconds(999));
+    REQUIRE(tracker.tick() == 0);
+
+    PeerMetrics metrics;
+    REQUIRE(tracker.metrics("leader", metrics));
+    REQUIRE(metrics.silence == milliseconds(999));
+
+    time.advance(milliseconds(11));
+    REQUIRE(tracker.tick() == 1);
+    REQUIRE(lost == 1);
+}
@@ -0,0 +1,127 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "v2v/v2v.hpp"
+#include "messages.hpp"
+
+/**
+ * Runs the clock offset estimation against a stand-in for the leading car on the loopback interface.
+ *
+ * The stand-in answers FollowerStatus messages with LeaderStatus messages at the protocol rates, just like
+ * V2VService does, but its clock is off by a known offset and drifts at a known rate. FollowerStatus messages are held
+ * back by a random delay before they go out, to simulate an asymmetric, jittery link. Prints the estimate against the
+ * real offset as it goes and fails if, once the first exchanges are in, the estimate is off by more than a millisecond
+ * on average. The error of a single exchange is bounded by half its round trip, so the jitter has to stay around ten
+ * milliseconds for that.
+ *
+ * Usage: clock_sync_loopback [seconds] [offset ms] [drift ppm] [jitter ms]
+ */
+
+static const uint16_t STAND_IN_LEADER_PORT = 50101;
+static const uint16_t STAND_IN_FOLLOWER_PORT = 50102;
+
+static const int64_t MAX_MEAN_OFFSET_ERROR_MICROS = 1000;
+static const int SETTLE_SECONDS = 5;
+
+int main(int argc, char **argv) {
+    using namespace std::chrono;
+
+    int runSeconds = argc > 1 ? std::atoi(argv[1]) : 60;
+    int64_t offsetMicros = (argc > 2 ? std::atoll(argv[2]) : 2500) * 1000;
+    double driftPpm = argc > 3 ? std::atof(argv[3]) : 40.0;
+    int jitterMillis = argc > 4 ? std::atoi(argv[4]) : 10;
+
+    TimeSource &timeSource = TimeSource::system();
+    const int64_t start = timeSource.wallMicros();
+
+    // The clock of the stand-in, offset and drifting against ours.
+    auto leaderMicros = [&]() {
+        int64_t now = timeSource.wallMicros();
+        return now + offsetMicros + (int64_t) (driftPpm * 1e-6 * (double) (now - start));
+    };
+    auto realOffset = [&](int64_t at) {
+        return offsetMicros + (int64_t) (driftPpm * 1e-6 * (double) (at - start));
+    };
+
+    ClockSync leaderSide;
+    ClockSync followerSide;
+    std::atomic<bool> running(true);
+
+    cluon::UDPReceiver leaderIn("127.0.0.1", STAND_IN_LEADER_PORT,
+        [&](std::string &&data, std::string &&, std::chrono::system_clock::time_point) noexcept {
+            int64_t received = leaderMicros();
+            Frame frame = extractFrame(data);
+            if (frame.id == FOLLOWER_STATUS) {
+                leaderSide.processFollowerStatus(decodePayload<FollowerStatus>(frame.payload), received);
+            }
+        });
+    cluon::UDPReceiver followerIn("127.0.0.1", STAND_IN_FOLLOWER_PORT,
+        [&](std::string &&data, std::string &&, std::chrono::system_clock::time_point) noexcept {
+            int64_t received = timeSource.wallMicros();
+            Frame frame = extractFrame(data);
+            if (frame.id == LEADER_STATUS) {
+                followerSide.processLeaderStatus(decodePayload<LeaderStatus>(frame.payload), received);
+            }
+        });
+    cluon::UDPSender toFollower("127.0.0.1", STAND_IN_FOLLOWER_PORT);
+    cluon::UDPSender toLeader("127.0.0.1", STAND_IN_LEADER_PORT);
+
+    std::thread leader([&]() {
+        steady_clock::time_point next = steady_clock::now();
+        while (running) {
+            LeaderStatus status;
+            status.timestamp((uint64_t) (leaderMicros() / 1000));
+            leaderSide.stampLeaderStatus(status, leaderMicros());
+            toFollower.send(std::move(encodeFrame(status, Framing::BINARY)));
+            next += milliseconds(125);
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    std::thread follower([&]() {
+        std::mt19937 random(7);
+        std::uniform_int_distribution<int> jitter(0, jitterMillis * 1000);
+        steady_clock::time_point next = steady_clock::now();
+        while (running) {
+            FollowerStatus status;
+            followerSide.stampFollowerStatus(status, timeSource.wallMicros());
+            std::this_thread::sleep_for(microseconds(jitter(random)));
+            toLeader.send(std::move(encodeFrame(status, Framing::BINARY)));
+            next += milliseconds(500);
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    int64_t errorSum = 0;
+    int errorCount = 0;
+    for (int elapsed = 1; elapsed <= runSeconds; elapsed++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        int64_t now = timeSource.wallMicros();
+        int64_t error = followerSide.offsetMicros(now) - realOffset(now);
+        if (elapsed > SETTLE_SECONDS) {
+            errorSum += std::llabs(error);
+            errorCount++;
+        }
+        if (elapsed % 5 == 0 || elapsed == runSeconds) {
+            std::cout << elapsed << " s: " << (followerSide.synced() ? "synced" : "not synced") << ", offset "
+                      << followerSide.offsetMicros(now) << " us (real " << realOffset(now) << " us, error " << error
+                      << " us), drift " << followerSide.driftPpm() << " ppm (real " << driftPpm << " ppm)"
+                      << std::endl;
+        }
+    }
+
+    running = false;
+    leader.join();
+    follower.join();
+
+    followerSide.latency().print(std::cout, "One way latency");
+    int64_t meanError = errorCount > 0 ? errorSum / errorCount : 0;
+    std::cout << "Mean offset error after " << SETTLE_SECONDS << " s: " << meanError << " us" << std::endl;
+    bool passed = followerSide.synced() && meanError <= MAX_MEAN_OFFSET_ERROR_MICROS;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "v2v/v2v.hpp"
+
+/**
+ * End to end latency of a convoy of V2VService instances on the loopback interface, from the lead car changing its
+ * speed to each car behind it sending the same speed to its motor.
+ *
+ * Every car is a V2VService of its own in this process, on its own 127.0.0.x address with Networking::V2V_ONLY, so the
+ * cars talk to each other over UDP exactly as on the road but share no OD4 channel. In a chain every car follows the
+ * car in front of it, in a star every car follows the lead car. The lead car changes its speed at a fixed interval,
+ * each time to a value not used for a while, and the time of every change is kept. Every other car takes each motor
+ * command it sends into its car status right away, as if its motor followed instantly, so the cars behind it see the
+ * change in its next LeaderStatus. A car sending a speed the lead car changed to records the time since that change.
+ *
+ * The figures are those of the whole follow path: the status timer of every car in front, the network stack, the
+ * reorder window and the replay delay of the follow mode, not the cost of a datagram alone.
+ *
+ * Usage: convoy_benchmark [cars] [seconds] [chain|star] [change interval ms] [time|distance]
+ */
+
+// Speeds the lead car cycles through, far enough apart for each change to pass the speed deadband.
+static const float CONVOY_LOWEST_SPEED = 0.15f;
+static const float CONVOY_SPEED_STEP = 0.01f;
+static const int CONVOY_SPEEDS = 50;
+// Time the cars get to start following before the lead car starts changing its speed.
+static const std::chrono::seconds CONVOY_SETTLE(3);
+// Longest the last change gets to reach every car, per car.
+static const std::chrono::seconds CONVOY_DRAIN_PER_CAR(5);
+
+/*
+ * The speed changes of the lead car, and for every other car the latency of each change reaching it.
+ */
+class SpeedChanges {
+public:
+    explicit SpeedChanges(size_t cars) : latencies(cars), lastMatched(cars, 0) {}
+
+    void changed(float speed, std::chrono::steady_clock::time_point when) {
+        std::lock_guard<std::mutex> lock(mutex);
+        times.push_back(when);
+        latestChange[speed] = times.size();
+    }
+
+    void actuated(size_t car, float speed, std::chrono::steady_clock::time_point when) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = latestChange.find(speed);
+        // Speeds the lead car did not change to, like the stop of a car losing its leader, and repeats are not counted.
+        if (found == latestChange.end() || found->second <= lastMatched[car]) {
+            return;
+        }
+        lastMatched[car] = found->second;
+        latencies[car].push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+            when - times[found->second - 1]).count());
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return times.size();
+    }
+
+    // True once the last change reached every car.
+    bool drained() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t car = 1; car < lastMatched.size(); car++) {
+            if (lastMatched[car] < times.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Latencies of a car sorted, kept whole since they run into seconds, past what LatencyHistogram resolves.
+    std::vector<int64_t> latency(size_t car) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<int64_t> sorted = latencies[car];
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    }
+
+private:
+    std::mutex mutex;
+    // Time of every change, and the number of the latest change to each speed, counted from 1.
+    std::vector<std::chrono::steady_clock::time_point> times;
+    std::map<float, size_t> latestChange;
+    std::vector<std::vector<int64_t>> latencies;
+    std::vector<size_t> lastMatched;
+};
+
+static int64_t percentileOf(const std::vector<int64_t> &sorted, int percentile) {
+    return sorted[std::min(sorted.size() - 1, sorted.size() * percentile / 100)];
+}
+
+static std::string addressOf(int car) {
+    return "127.0.0." + std::to_string(car + 1);
+}
+
+int main(int argc, char **argv) {
+    using namespace std::chrono;
+    int cars = argc > 1 ? std::atoi(argv[1]) : 5;
+    int duration = argc > 2 ? std::atoi(argv[2]) : 30;
+    const bool chain = argc <= 3 || std::strcmp(argv[3], "star") != 0;
+    milliseconds interval(argc > 4 ? std::atoi(argv[4]) : 500);
+    const FollowMode mode = argc > 5 && std::strcmp(argv[5], "distance") == 0 ? FollowMode::DISTANCE : FollowMode::TIME;
+    if (cars < 2 || cars > (int) MAX_FOLLOWERS + 1 || duration <= 0 || interval.count() <= 0) {
+        std::cerr << "Between 2 and " << MAX_FOLLOWERS + 1 << " cars, and a positive duration and interval!"
+                  << std::endl;
+        return 1;
+    }
+    // The results go to standard output, what the services log does not.
+    Logger::instance().setOutput(std::cerr);
+
+    SpeedChanges changes(static_cast<size_t>(cars));
+    std::vector<std::unique_ptr<V2VService>> convoy;
+    for (int car = 0; car < cars; car++) {
+        convoy.emplace_back(new V2VService(addressOf(car), "convoy" + std::to_string(car), 0.0f,
+                                           TimeSource::system(), Networking::V2V_ONLY));
+        V2VService &service = *convoy.back();
+        service.stopAnnouncing();
+        service.setFollowMode(mode);
+        if (car == 0) {
+            continue;
+        }
+        // Called under the actuation lock of the service, so there is only ever one writer of the car status.
+        service.setActuationObserver([&changes, &service, car](int32_t dataType, float value) {
+            if (dataType != PEDAL_POSITION_READING) {
+                return;
+            }
+            changes.actuated(static_cast<size_t>(car), value, steady_clock::now());
+            CarStatus status = service.getCurrentCarStatus();
+            status.speed = value;
+            status.sampled = steady_clock::now();
+            service.setCurrentCarStatus(status);
+        });
+    }
+
+    // From the back, so a car already has its follower when it starts following itself.
+    for (int car = cars - 1; car > 0; car--) {
+        convoy[car]->followRequest(addressOf(chain ? car - 1 : 0));
+    }
+    std::this_thread::sleep_for(CONVOY_SETTLE);
+    for (int car = 1; car < cars; car++) {
+        if (!convoy[car]->isFollowing()) {
+            std::cerr << "Car " << car << " did not start following!" << std::endl;
+            return 1;
+        }
+    }
+
+    steady_clock::time_point next = steady_clock::now();
+    steady_clock::time_point end = next + seconds(duration);
+    for (int i = 0; next < end; i++) {
+        float speed = CONVOY_LOWEST_SPEED + (i % CONVOY_SPEEDS) * CONVOY_SPEED_STEP;
+        changes.changed(speed, steady_clock::now());
+        convoy[0]->setCurrentCarStatus(CarStatus{speed, 0.0f, steady_clock::now()});
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+    steady_clock::time_point giveUp = steady_clock::now() + cars * CONVOY_DRAIN_PER_CAR;
+    while (!changes.drained() && steady_clock::now() < giveUp) {
+        std::this_thread::sleep_for(milliseconds(50));
+    }
+
+    // Stopped from the back, so no car loses its leader while it still counts.
+    for (int car = cars - 1; car >= 0; car--) {
+        convoy[car]->setActuationObserver(nullptr);
+        convoy[car].reset();
+    }
+
+    std::cout << cars << " V2VService cars in a " << (chain ? "chain" : "star") << ", "
+              << (mode == FollowMode::DISTANCE ? "distance" : "time") << " mode, the lead car changing its speed every "
+              << interval.count() << " ms for " << duration << " s, " << changes.count() << " changes" << std::endl;
+    for (int car = 1; car < cars; car++) {
+        std::vector<int64_t> latency = changes.latency(static_cast<size_t>(car));
+        std::cout << "car " << car << (chain ? " (" + std::to_string(car) + " hops)" : "")
+                  << (car == cars - 1 ? ", tail" : "") << " : " << latency.size() << " changes reached it";
+        if (!latency.empty()) {
+            std::cout << ", p50 " << percentileOf(latency, 50) / 1000.0 << " ms, p99 "
+                      << percentileOf(latency, 99) / 1000.0 << " ms, max " << latency.back() / 1000.0 << " ms";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
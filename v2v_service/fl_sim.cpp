@@ -3,10 +3,6 @@
 #include "v2v/v2v.hpp"
 #include "messages.hpp"
 
-
-template <class T>
-std::string encode(T msg);
-
 /**
  * This is just a simulation program to use before any other group gets their following/leading logic in place. It will
  * create leader updates and can feed them to our car to simulate another vehicle. Note that you will need to uncomment
@@ -61,7 +57,7 @@ int main(int argc, char** argv) {
         ls.speed(currentSpeed);
         ls.steeringAngle(currentSteering);
         
-        sender->send(encode(ls));
+        sender->send(std::move(encodeFrame(ls, Framing::LEGACY_HEX)));
         numberOfUpdates += 1;
         
         cout << "|" << std::flush;
@@ -71,15 +67,3 @@ int main(int argc, char** argv) {
     cout << endl;
 
 }
-
-template <class T>
-std::string encode(T msg) {
-    cluon::ToProtoVisitor v;
-    msg.accept(v);
-    std::stringstream buff;
-    buff << std::hex << std::setfill('0')
-         << std::setw(4) << msg.ID()
-         << std::setw(6) << v.encodedData().length()
-         << v.encodedData();
-    return buff.str();
-}
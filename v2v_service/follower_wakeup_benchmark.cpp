@@ -0,0 +1,134 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include <sys/resource.h>
+
+#include "v2v/v2v.hpp"
+#include "messages.hpp"
+
+/**
+ * Idle load and wake up latency of the follower thread in time mode.
+ *
+ * A follow session is started without a leader and fed leader statuses directly. First the CPU time the whole service
+ * uses is measured while the leader stands still and while it moves but its next status has not arrived yet, the two
+ * states the follower thread spends its time waiting in. Then a moving status is handed over at a time and the time
+ * until its pedal position shows up on the motor channel is measured. The statuses are far enough apart that they are
+ * due at once when they arrive, so that time is the wake up of the follower thread and the actuation alone.
+ *
+ * Usage: follower_wakeup_benchmark [samples] [idle seconds]
+ */
+
+// Spacing of the measured statuses, long enough for every one of them to be due as soon as it arrives.
+static const std::chrono::milliseconds SAMPLE_SPACING(300);
+
+/**
+ * @return CPU time used by the process so far, user and system, in microseconds
+ */
+static int64_t cpuMicros() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL + usage.ru_utime.tv_usec +
+           usage.ru_stime.tv_usec;
+}
+
+/**
+ * @return share of one core the process used over the given time, in percent
+ */
+static double cpuPercent(std::chrono::seconds period) {
+    using namespace std::chrono;
+    int64_t before = cpuMicros();
+    steady_clock::time_point start = steady_clock::now();
+    std::this_thread::sleep_for(period);
+    int64_t used = cpuMicros() - before;
+    return 100.0 * (double) used / (double) duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+static LeaderStatus leaderStatus(uint64_t timestamp, float speed) {
+    LeaderStatus status;
+    status.timestamp(timestamp);
+    status.speed(speed);
+    status.steeringAngle(0.0f);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    using namespace std::chrono;
+    int samples = argc > 1 ? std::atoi(argv[1]) : 50;
+    seconds idle(argc > 2 ? std::atoi(argv[2]) : 2);
+
+    // The pedal positions the service sends, as the motor proxy would receive them.
+    std::mutex mutex;
+    std::condition_variable actuated;
+    float lastPedal = -1.0f;
+    steady_clock::time_point lastPedalAt;
+    cluon::OD4Session motor(MOTOR_BROADCAST_CHANNEL, [&](cluon::data::Envelope &&envelope) {
+        if (envelope.dataType() != opendlv::proxy::PedalPositionReading::ID()) {
+            return;
+        }
+        auto pedal = cluon::extractMessage<opendlv::proxy::PedalPositionReading>(std::move(envelope));
+        std::lock_guard<std::mutex> lock(mutex);
+        lastPedal = pedal.percent();
+        lastPedalAt = steady_clock::now();
+        actuated.notify_all();
+    });
+    auto waitForPedal = [&](float pedal, steady_clock::time_point *at) {
+        std::unique_lock<std::mutex> lock(mutex);
+        bool arrived = actuated.wait_for(lock, seconds(2), [&] { return lastPedal == pedal; });
+        *at = lastPedalAt;
+        return arrived;
+    };
+
+    V2VService v2v("127.0.0.1", "wakeup", 0);
+    v2v.stopAnnouncing();
+    v2v.startFollowing();
+    // Lets the follower thread pick the session up before anything is measured.
+    std::this_thread::sleep_for(milliseconds(100));
+
+    // Leader timestamps of the measured statuses, further apart than any replayed spacing.
+    uint64_t timestamp = v2v.getTime();
+    steady_clock::time_point at;
+
+    v2v.processLeaderStatus(leaderStatus(timestamp, 0.0f));
+    waitForPedal(0.0f, &at);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Idle CPU, leader standing still   : " << cpuPercent(idle) << " % of a core" << std::endl;
+
+    // The pre filled updates are replayed first, they are done once our own status went out.
+    timestamp += MAX_UPDATE_SPACING.count() * 2;
+    v2v.processLeaderStatus(leaderStatus(timestamp, 0.3f));
+    steady_clock::time_point deadline = steady_clock::now() + seconds(5);
+    while (!waitForPedal(0.3f, &at) && steady_clock::now() < deadline) {
+    }
+    std::cout << "Idle CPU, waiting for next update : " << cpuPercent(idle) << " % of a core" << std::endl;
+
+    LatencyHistogram latency;
+    int missed = 0;
+    for (int i = 0; i < samples; i++) {
+        // Alternating, so every pedal position is a change the motor commands are not coalesced over.
+        float speed = i % 2 == 0 ? 0.2f : 0.3f;
+        timestamp += MAX_UPDATE_SPACING.count() * 2;
+        std::this_thread::sleep_for(SAMPLE_SPACING);
+
+        steady_clock::time_point handedOver = steady_clock::now();
+        v2v.processLeaderStatus(leaderStatus(timestamp, speed));
+        if (waitForPedal(speed, &at)) {
+            latency.record(duration_cast<microseconds>(at - handedOver).count());
+        } else {
+            missed++;
+        }
+    }
+    v2v.stopFollow();
+
+    std::cout << samples << " updates, " << latency.count() << " actuated";
+    if (missed > 0) {
+        std::cout << ", " << missed << " missed";
+    }
+    std::cout << std::endl;
+    latency.print(std::cout, "Wake to actuate");
+    return missed == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+#include "v2v/framing.hpp"
+#include "messages.hpp"
+
+/**
+ * Microbenchmark of the V2V framing. Every LeaderStatus is encoded, extracted again and decoded the way the incoming
+ * UDP receiver does it, using the old stringstream based header, the new legacy hex writer and the binary header, the
+ * latter also with the LeaderStatus decoder the receiver uses, which bypasses cluon's FromProtoVisitor. Reports
+ * nanoseconds and heap allocations per packet for each, the allocations left with the direct decoder are cluon's
+ * encoding on the sending side.
+ */
+
+static std::atomic<uint64_t> allocations(0);
+
+void *operator new(size_t size) {
+    allocations++;
+    void *p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+/*
+ * The framing as it was before the binary header was introduced, kept here as the baseline.
+ */
+template <class T>
+std::string stringstreamEncode(T msg) {
+    cluon::ToProtoVisitor v;
+    msg.accept(v);
+    std::stringstream buff;
+    buff << std::hex << std::setfill('0')
+         << std::setw(4) << msg.ID()
+         << std::setw(6) << v.encodedData().length()
+         << v.encodedData();
+    return buff.str();
+}
+
+std::pair<int16_t, std::string> stringstreamExtract(std::string data) {
+    if (data.length() < 10) return std::pair<int16_t, std::string>(-1, "");
+    unsigned int id, len;
+    std::stringstream ssId(data.substr(0, 4));
+    std::stringstream ssLen(data.substr(4, 10));
+    ssId >> std::hex >> id;
+    ssLen >> std::hex >> len;
+    return std::pair<int16_t, std::string> (
+            data.length() -10 == len ? id : -1,
+            data.substr(10, data.length() -10)
+    );
+}
+
+template <class T>
+T stringstreamDecode(std::string data) {
+    std::stringstream buff(data);
+    cluon::FromProtoVisitor v;
+    v.decodeFrom(buff);
+    T tmp = T();
+    tmp.accept(v);
+    return tmp;
+}
+
+struct Result {
+    double nsPerPacket;
+    double allocationsPerPacket;
+};
+
+template <class F>
+Result measure(int packets, F roundTrip) {
+    using namespace std::chrono;
+    float checksum = 0;
+
+    // Warm up, this also lets the thread local frame buffers allocate their storage.
+    for (int i = 0; i < 1000; i++) checksum += roundTrip(i);
+
+    uint64_t allocationsBefore = allocations;
+    steady_clock::time_point start = steady_clock::now();
+    for (int i = 0; i < packets; i++) {
+        checksum += roundTrip(i);
+    }
+    steady_clock::time_point end = steady_clock::now();
+    uint64_t allocationsAfter = allocations;
+
+    // Keeps the compiler from optimising the round trips away.
+    if (checksum == -1) std::cout << checksum << std::endl;
+
+    Result result;
+    result.nsPerPacket = duration_cast<nanoseconds>(end - start).count() / (double) packets;
+    result.allocationsPerPacket = (allocationsAfter - allocationsBefore) / (double) packets;
+    return result;
+}
+
+LeaderStatus makeLeaderStatus(int i) {
+    LeaderStatus leaderStatus;
+    leaderStatus.timestamp(1525000000000 + i * 125);
+    leaderStatus.speed(0.15f + (i % 5) * 0.01f);
+    leaderStatus.steeringAngle(-0.2f + (i % 9) * 0.05f);
+    leaderStatus.distanceTraveled(static_cast<uint8_t>(i % 14));
+    return leaderStatus;
+}
+
+void print(const std::string &name, const Result &result) {
+    std::cout << std::left << std::setw(16) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1) << result.nsPerPacket << " ns/packet"
+              << std::setw(10) << std::setprecision(2) << result.allocationsPerPacket << " allocs/packet" << std::endl;
+}
+
+using namespace std;
+int main(int argc, char** argv) {
+    int packets = argc > 1 ? atoi(argv[1]) : 200000;
+
+    Result baseline = measure(packets, [](int i) {
+        LeaderStatus out = makeLeaderStatus(i);
+        std::pair<int16_t, std::string> msg = stringstreamExtract(stringstreamEncode(out));
+        return stringstreamDecode<LeaderStatus>(msg.second).speed();
+    });
+
+    Result legacy = measure(packets, [](int i) {
+        LeaderStatus out = makeLeaderStatus(i);
+        std::string &data = encodeFrame(out, Framing::LEGACY_HEX);
+        Frame frame = extractFrame(data);
+        return decodePayload<LeaderStatus>(frame.payload).speed();
+    });
+
+    Result binary = measure(packets, [](int i) {
+        LeaderStatus out = makeLeaderStatus(i);
+        std::string &data = encodeFrame(out, Framing::BINARY);
+        Frame frame = extractFrame(data);
+        return decodePayload<LeaderStatus>(frame.payload).speed();
+    });
+
+    Result direct = measure(packets, [](int i) {
+        LeaderStatus out = makeLeaderStatus(i);
+        std::string &data = encodeFrame(out, Framing::BINARY);
+        Frame frame = extractFrame(data);
+        LeaderStatus in;
+        decodeLeaderStatus(frame.payload, in);
+        return in.speed();
+    });
+
+    cout << "LeaderStatus encode + extract + decode, " << packets << " packets" << endl;
+    print("stringstream", baseline);
+    print("legacy hex", legacy);
+    print("binary", binary);
+    print("binary direct", direct);
+}
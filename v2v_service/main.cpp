@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 #include <map>
 #include <fstream>
 #include <string>
@@ -15,15 +16,37 @@ int main(int argc, char** argv) {
 
     // Check that both IP address and groupid for the service has been provided.
     if (argc < 4) {
-        cout << "You need to provide <ip-address>, <group ID> and <steering offset>" << endl;
+        cout << "You need to provide <ip-address>, <group ID>, <steering offset> and optionally <follow mode>, "
+             << "<groups response>, <announce period> and <leader status mode>" << endl;
         exit(1);
     }
     /*
      * argv[1] = IP
      * argv[2] = Group ID
      * argv[3] = steering offset for going straight
+     * argv[4] = follow mode, "time" (default) or "distance" (optional)
+     * argv[5] = get all groups response, "batched" (default) or "per-car" for older remote controls (optional)
+     * argv[6] = base period of the automatic presence announcements in ms, 0 to only announce on request (optional)
+     * argv[7] = leader statuses to followers, "unicast" (default) or "multicast" (optional)
      */
     shared_ptr<V2VService> v2vService = make_shared<V2VService>(argv[1], argv[2], stof(argv[3]));
+    if (argc > 4 && string(argv[4]) == "distance") {
+        v2vService->setFollowMode(FollowMode::DISTANCE);
+    }
+    if (argc > 5 && string(argv[5]) == "per-car") {
+        v2vService->setGroupsResponseMode(GroupsResponseMode::PER_CAR);
+    }
+    if (argc > 6) {
+        chrono::milliseconds period(stoi(argv[6]));
+        if (period.count() > 0) {
+            v2vService->startAnnouncing(period, max(period, ANNOUNCE_MAX_PERIOD));
+        } else {
+            v2vService->stopAnnouncing();
+        }
+    }
+    if (argc > 7 && string(argv[7]) == "multicast") {
+        v2vService->setLeaderStatusMode(LeaderStatusMode::MULTICAST);
+    }
 
     // Messages to test
     while (true) {
@@ -47,8 +70,8 @@ int main(int argc, char** argv) {
                 break;
             }
             case 2: {
-                map<string, string> ipMap = v2vService->getMapOfIps();
-                if (ipMap.size() < 1) {
+                std::shared_ptr<const PeerSnapshot> peers = v2vService->getPeers();
+                if (peers->empty()) {
                     cout << "There are no IPs to choose from, wait for someone to announce themselves!" << endl;
                     break;
                 }
@@ -56,18 +79,25 @@ int main(int argc, char** argv) {
                 std::string groupId = "";
 
                 cout << "Which vehicle would you like to follow?" << endl;
-                for(std::map<std::string, std::string>::iterator it = ipMap.begin(); it != ipMap.end(); ++it) {
-                    cout << it->first << " " << it->second << endl;
+                for (const PeerEntry &peer : peers->entries()) {
+                    cout << peer.groupId << " " << peer.ip << endl;
                 }
                 cin >> groupId;
 
+                const PeerEntry *chosen = peers->byGroupId(groupId);
+                if (chosen == nullptr) {
+                    cout << "No vehicle with group ID " << groupId << " has announced itself!" << endl;
+                    break;
+                }
                 cout << "You chose: " << groupId << endl;
-                v2vService->followRequest(ipMap[groupId]);
+                v2vService->followRequest(chosen->ip);
                 
                 break;
             }
             case 3: {
-                v2vService->followResponse();
+                for (const std::string &followerIp : v2vService->getFollowerIps()) {
+                    v2vService->followResponse(followerIp);
+                }
                 break;
             }
             case 4: {
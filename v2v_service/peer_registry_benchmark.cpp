@@ -0,0 +1,161 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "v2v/peer_registry.hpp"
+
+/**
+ * Microbenchmark of the peer registry with a crowd of announcing cars. Every car announces itself once per round, the
+ * way AnnouncePresence messages come in on the broadcast channel, while lookups by group id and by IP stand in for the
+ * internal follow requests and the FollowResponse handling. The two std::map members the service used before, and the
+ * copy getMapOfIps() handed out, are measured alongside as the baseline.
+ */
+
+struct Car {
+    std::string groupId;
+    std::string ip;
+};
+
+/*
+ * The IP maps as they were before the registry was introduced, kept here as the baseline.
+ */
+struct LegacyMaps {
+    std::map<std::string, std::string> mapOfIps;
+    std::map<std::string, std::string> mapOfIds;
+
+    void announce(const Car &car) {
+        mapOfIps.insert(std::make_pair(car.groupId, car.ip));
+        mapOfIds[car.ip] = car.groupId;
+    }
+};
+
+std::vector<Car> makeCars(int count) {
+    std::vector<Car> cars;
+    for (int i = 0; i < count; i++) {
+        Car car;
+        car.groupId = std::to_string(100 + i);
+        car.ip = "10.42." + std::to_string(i / 250) + "." + std::to_string(i % 250 + 1);
+        cars.push_back(car);
+    }
+    return cars;
+}
+
+template <class F>
+double nsPerOperation(int operations, F operation) {
+    using namespace std::chrono;
+    steady_clock::time_point start = steady_clock::now();
+    size_t checksum = 0;
+    for (int i = 0; i < operations; i++) {
+        checksum += operation(i);
+    }
+    steady_clock::time_point end = steady_clock::now();
+
+    // Keeps the compiler from optimising the operations away.
+    if (checksum == (size_t) -1) std::cout << checksum << std::endl;
+    return duration_cast<nanoseconds>(end - start).count() / (double) operations;
+}
+
+void print(const std::string &name, double registry, double legacy) {
+    std::cout << std::left << std::setw(24) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(1) << registry << " ns"
+              << std::setw(12) << legacy << " ns" << std::endl;
+}
+
+using namespace std;
+int main(int argc, char** argv) {
+    int peers = argc > 1 ? atoi(argv[1]) : 1000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+    int operations = peers * rounds;
+    vector<Car> cars = makeCars(peers);
+
+    ManualTimeSource time;
+    PeerRegistry registry(chrono::seconds(60), time);
+    LegacyMaps legacy;
+
+    // Every car announces itself for the first time, each one publishes a new snapshot.
+    double firstRegistry = nsPerOperation(peers, [&](int i) { return (size_t) registry.announce(cars[i].groupId, cars[i].ip); });
+    double firstLegacy = nsPerOperation(peers, [&](int i) { legacy.announce(cars[i]); return legacy.mapOfIds.size(); });
+
+    double announceRegistry = nsPerOperation(operations, [&](int i) {
+        const Car &car = cars[i % peers];
+        return (size_t) registry.announce(car.groupId, car.ip);
+    });
+    double announceLegacy = nsPerOperation(operations, [&](int i) {
+        legacy.announce(cars[i % peers]);
+        return legacy.mapOfIds.size();
+    });
+
+    double byGroupRegistry = nsPerOperation(operations, [&](int i) {
+        return registry.snapshot()->byGroupId(cars[i % peers].groupId)->ip.size();
+    });
+    double byGroupLegacy = nsPerOperation(operations, [&](int i) {
+        return legacy.mapOfIps.find(cars[i % peers].groupId)->second.size();
+    });
+
+    double byIpRegistry = nsPerOperation(operations, [&](int i) {
+        return registry.snapshot()->byIp(cars[i % peers].ip)->groupId.size();
+    });
+    double byIpLegacy = nsPerOperation(operations, [&](int i) {
+        return legacy.mapOfIds.find(cars[i % peers].ip)->second.size();
+    });
+
+    // What a caller listing the cars gets: the shared snapshot, or a copy of the whole map.
+    double listRegistry = nsPerOperation(rounds * 10, [&](int) { return registry.snapshot()->size(); });
+    double listLegacy = nsPerOperation(rounds * 10, [&](int) {
+        std::map<std::string, std::string> copy = legacy.mapOfIps;
+        return copy.size();
+    });
+
+    // The periodic expiry sweep when nobody expired, and when everybody did.
+    double sweep = nsPerOperation(rounds, [&](int) { return registry.expire(); });
+    time.advance(chrono::seconds(61));
+    double sweepAll = nsPerOperation(1, [&](int) { return registry.expire(); });
+
+    // Lookups from reader threads while every car keeps announcing itself and one keeps moving between two IPs.
+    for (int i = 0; i < peers; i++) {
+        registry.announce(cars[i].groupId, cars[i].ip);
+    }
+    atomic<bool> running(true);
+    thread writer([&]() {
+        for (int i = 0; running; i++) {
+            const Car &car = cars[i % peers];
+            registry.announce(car.groupId, i % (peers * 10) == 0 ? car.ip + "0" : car.ip);
+        }
+    });
+    const int readers = 3;
+    vector<double> readerNs(readers);
+    vector<thread> readerThreads;
+    for (int r = 0; r < readers; r++) {
+        readerThreads.emplace_back([&, r]() {
+            readerNs[r] = nsPerOperation(operations, [&](int i) {
+                const PeerEntry *peer = registry.snapshot()->byGroupId(cars[(i * 7 + r) % peers].groupId);
+                return peer == nullptr ? 0 : peer->ip.size();
+            });
+        });
+    }
+    for (thread &t : readerThreads) {
+        t.join();
+    }
+    running = false;
+    writer.join();
+
+    cout << peers << " announcing cars, " << rounds << " announcement rounds" << endl;
+    cout << left << setw(24) << "" << right << setw(15) << "registry" << setw(15) << "std::map" << endl;
+    print("first announcement", firstRegistry, firstLegacy);
+    print("repeated announcement", announceRegistry, announceLegacy);
+    print("lookup by group id", byGroupRegistry, byGroupLegacy);
+    print("lookup by IP", byIpRegistry, byIpLegacy);
+    print("list all cars", listRegistry, listLegacy);
+    cout << left << setw(24) << "expiry sweep" << right << setw(12) << sweep << " ns (" << sweepAll
+         << " ns expiring all)" << endl;
+    for (int r = 0; r < readers; r++) {
+        cout << left << setw(24) << ("concurrent lookup " + to_string(r)) << right << setw(12) << readerNs[r] << " ns"
+             << endl;
+    }
+}
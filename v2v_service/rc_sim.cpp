@@ -12,9 +12,10 @@
 
 using namespace std;
 int main() {
+    GroupListAssembler groupList;
     shared_ptr<cluon::OD4Session> internalBroadcast = make_shared<cluon::OD4Session>(
         INTERNAL_BROADCAST_CHANNEL,
-        [](cluon::data::Envelope &&envelope) noexcept {
+        [&groupList](cluon::data::Envelope &&envelope) noexcept {
             
             switch (envelope.dataType()) {
                 case INTERNAL_FOLLOW_RESPONSE: {
@@ -35,6 +36,18 @@ int main() {
                     cout << "[RC INTERNAL] Got group: " << msg.groupid() << endl;
                     break;
                 }
+                case INTERNAL_GET_ALL_GROUPS_BATCH: {
+                    InternalGetAllGroupsBatch msg = cluon::extractMessage<InternalGetAllGroupsBatch>(std::move(envelope));
+
+                    if (groupList.add(msg)) {
+                        cout << "[RC INTERNAL] Got " << groupList.groups().size() << " groups" << endl;
+                        for (const GroupListEntry &group : groupList.groups()) {
+                            cout << "[RC INTERNAL]     group: " << group.groupId << " ip: " << group.ip << " seen "
+                                 << group.ageMillis << " ms ago, capabilities: " << group.capabilities << endl;
+                        }
+                    }
+                    break;
+                }
                 case INTERNAL_EMERGENCY_BRAKE: {
                     InternalEmergencyBrake msg = cluon::extractMessage<InternalEmergencyBrake>(std::move(envelope));
                     
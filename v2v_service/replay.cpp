@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "recorder/recording.hpp"
+#include "v2v/v2v.hpp"
+
+/**
+ * Replays a recorded follow session into a V2VService in simulated time and writes out the motor commands it sends, so
+ * the actuation of a follower can be compared across code changes.
+ *
+ * The recording is one made by the recorder of the visualisation service on the follower. The service relays every
+ * message another car sends it to the internal channel, stamped with the IP of that car, so the V2V stream the follower
+ * received is in the recording as well, told apart from the messages it sent itself by the sender stamp. Every
+ * FollowResponse, LeaderStatus and StopFollow it received is handed back to the service as a datagram from the same
+ * car, at the time it was recorded. The service takes them the way it did live: a FollowResponse starts following the
+ * car it came from, statuses from any other car are ignored, and those from the leader go through clock sync and the
+ * reorder window before they are actuated. Motor commands are written one per line, with the simulated time in
+ * milliseconds since the start of the recording.
+ *
+ * A recording started in the middle of a session has no FollowResponse, the leader is then given with --leader and
+ * followed from its first status on. The FollowerStatus messages of the replay are not those the leader echoed back
+ * while recorded, so clock sync takes no samples and the replay runs on the leader timestamps as they are.
+ *
+ * The service runs on a ManualTimeSource. Time is advanced to every recorded message and to every deadline the threads
+ * of the service wait for, each time waiting for them to settle before advancing again, so the output is the same
+ * whatever the speed. Threads that do not settle are an error rather than something to move on from, since the output
+ * would no longer be reproducible. The service is OFFLINE, so nothing goes out on the network and the replay can run
+ * next to a live service. Every motor command is taken into the car status straight away, as if the car followed it
+ * instantly.
+ *
+ * Options, all optional but the recording, are given as --name=value:
+ *   --recording  the recording to replay
+ *   --speed      1 for real time, a factor like 10, or max for as fast as possible (max)
+ *   --mode       follow mode, time or distance (time)
+ *   --offset     steering offset for going straight, as given to the V2V service (0)
+ *   --out        file to write the motor commands to (standard output)
+ *   --recorded   yes to write the motor commands in the recording instead, in the same format
+ *   --leader     IP of the leader, for a recording started in the middle of a session
+ */
+
+using namespace std;
+
+static const char *const OPTIONS[] = {"recording", "speed", "mode", "offset", "out", "recorded", "leader"};
+
+// How long the threads of the service get to settle after each step before the replay gives up.
+static const chrono::seconds REPLAY_SETTLE_TIMEOUT(5);
+// Simulated time replayed after the last message, for the follower to act on what it still has queued.
+static const chrono::seconds REPLAY_TAIL(3);
+
+static void usage(const char *name) {
+    cerr << "Usage: " << name << " --recording=recording.g7r [--speed=1|N|max] [--mode=time|distance] [--offset=0] "
+         << "[--out=actuation.txt] [--recorded=yes] [--leader=ip]" << endl;
+}
+
+static void writeCommand(ostream &out, int64_t micros, int32_t dataType, float value) {
+    out << fixed << setprecision(3) << (double) micros / 1000.0 << " "
+        << (dataType == PEDAL_POSITION_READING ? "pedal" : "steering") << " " << setprecision(6) << value << "\n";
+}
+
+/*
+ * The motor commands in the recording, as the car sent them while it was recorded.
+ */
+static void writeRecorded(RecordingReader &reader, ostream &out) {
+    RecordView record;
+    int64_t first = reader.chunks() > 0 ? reader.chunk(0).firstMicros : 0;
+    while (reader.next(record)) {
+        if (record.header.channel != MOTOR_BROADCAST_CHANNEL) {
+            continue;
+        }
+        PayloadView payload{record.data, record.header.length};
+        if (record.header.dataType == PEDAL_POSITION_READING) {
+            opendlv::proxy::PedalPositionReading msg =
+                decodePayload<opendlv::proxy::PedalPositionReading>(payload);
+            writeCommand(out, record.header.receivedMicros - first, record.header.dataType, msg.percent());
+        } else if (record.header.dataType == GROUND_STEERING_READING) {
+            opendlv::proxy::GroundSteeringReading msg =
+                decodePayload<opendlv::proxy::GroundSteeringReading>(payload);
+            writeCommand(out, record.header.receivedMicros - first, record.header.dataType, msg.steeringAngle());
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    map<string, string> options;
+    for (int i = 1; i < argc; i++) {
+        string argument(argv[i]);
+        size_t equals = argument.find('=');
+        if (argument.compare(0, 2, "--") != 0 || equals == string::npos ||
+            find(begin(OPTIONS), end(OPTIONS), argument.substr(2, equals - 2)) == end(OPTIONS)) {
+            usage(argv[0]);
+            return 1;
+        }
+        options[argument.substr(2, equals - 2)] = argument.substr(equals + 1);
+    }
+    double speed = 0.0;
+    if (options.count("speed") && options["speed"] != "max") {
+        speed = atof(options["speed"].c_str());
+    }
+    if (options.count("recording") == 0 || (options.count("speed") && options["speed"] != "max" && speed <= 0.0) ||
+        (options.count("mode") && options["mode"] != "time" && options["mode"] != "distance")) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    RecordingReader reader;
+    if (!reader.open(options["recording"])) {
+        cerr << "Could not read the recording " << options["recording"] << endl;
+        return 1;
+    }
+    ofstream file;
+    if (options.count("out")) {
+        file.open(options["out"]);
+        if (!file) {
+            cerr << "Could not write to " << options["out"] << endl;
+            return 1;
+        }
+    }
+    ostream &out = options.count("out") ? file : cout;
+    if (options["recorded"] == "yes") {
+        writeRecorded(reader, out);
+        return 0;
+    }
+    if (reader.chunks() == 0) {
+        cerr << "The recording is empty" << endl;
+        return 1;
+    }
+
+    // The log goes with the errors, the motor commands may be going to standard output.
+    Logger::instance().setOutput(cerr);
+    const int64_t firstMicros = reader.chunk(0).firstMicros;
+    ManualTimeSource time(TimeSource::time_point(chrono::hours(1)), firstMicros);
+    const TimeSource::time_point start = time.now();
+
+    uint64_t commands = 0;
+    {
+        V2VService v2vService("127.0.0.1", "7", options.count("offset") ? stof(options["offset"]) : 0.0f, time,
+                              Networking::OFFLINE);
+        v2vService.stopAnnouncing();
+        if (options["mode"] == "distance") {
+            v2vService.setFollowMode(FollowMode::DISTANCE);
+        }
+        // Called under the actuation lock of the service, so there is only ever one writer of the car status.
+        v2vService.setActuationObserver([&](int32_t dataType, float value) {
+            writeCommand(out, chrono::duration_cast<chrono::microseconds>(time.now() - start).count(), dataType,
+                         value);
+            commands++;
+            CarStatus status = v2vService.getCurrentCarStatus();
+            if (dataType == PEDAL_POSITION_READING) {
+                status.speed = value;
+            } else {
+                status.steeringAngle = value;
+            }
+            status.sampled = time.now();
+            v2vService.setCurrentCarStatus(status);
+        });
+
+        // Output after threads that did not settle would not be reproducible, so the replay stops there.
+        bool settled = true;
+        auto settle = [&]() {
+            while (settled) {
+                size_t threads = v2vService.getTimedThreads();
+                if (time.settle(threads, REPLAY_SETTLE_TIMEOUT)) {
+                    break;
+                }
+                // Losing the leader ends the session on the event loop while settling, the follower thread is then
+                // no longer one of the threads to wait for.
+                settled = v2vService.getTimedThreads() != threads;
+            }
+            return settled;
+        };
+        settle();
+        const chrono::steady_clock::time_point realStart = chrono::steady_clock::now();
+        auto step = [&](TimeSource::time_point to) {
+            if (speed > 0.0) {
+                this_thread::sleep_until(realStart + chrono::duration_cast<chrono::steady_clock::duration>(
+                    (to - start) / speed));
+            }
+            time.advanceTo(to);
+            return settle();
+        };
+        // Every deadline up to a time is stepped to on the way, so each timer fires exactly when it is due.
+        auto runUntil = [&](TimeSource::time_point to) {
+            for (TimeSource::time_point next = time.nextDeadline(); next < to; next = time.nextDeadline()) {
+                if (!step(next)) {
+                    return false;
+                }
+            }
+            return step(to);
+        };
+
+        // The car we asked to follow, as far as the recording tells.
+        const string givenLeader = options.count("leader") ? options["leader"] : "";
+        string leader;
+        RecordView record;
+        while (settled && reader.next(record)) {
+            const int32_t dataType = record.header.dataType;
+            if (record.header.channel != INTERNAL_BROADCAST_CHANNEL || record.header.senderStamp == OWN_SENDER_STAMP ||
+                (dataType != FOLLOW_RESPONSE && dataType != LEADER_STATUS && dataType != STOP_FOLLOW)) {
+                continue;
+            }
+            const string sender = senderIpOf(record.header.senderStamp);
+            if (!runUntil(start + chrono::microseconds(record.header.receivedMicros - firstMicros))) {
+                break;
+            }
+
+            PayloadView payload{record.data, record.header.length};
+            if (dataType == FOLLOW_RESPONSE) {
+                // A response only comes to a request, which we only sent after leaving the leader we had before.
+                if (!leader.empty() && leader != sender) {
+                    v2vService.stopFollow();
+                }
+                leader = sender;
+                v2vService.followRequest(sender);
+                FollowResponse followResponse = decodePayload<FollowResponse>(payload);
+                v2vService.receiveDatagram(encodeFrame(followResponse, Framing::LEGACY_HEX), sender);
+            } else if (dataType == LEADER_STATUS) {
+                LeaderStatus leaderStatus;
+                if (!decodeLeaderStatus(payload, leaderStatus)) {
+                    continue;
+                }
+                if (leader.empty() && sender == givenLeader) {
+                    leader = sender;
+                    v2vService.followRequest(sender);
+                    FollowResponse followResponse;
+                    followResponse.framing(static_cast<uint8_t>(Framing::BINARY));
+                    v2vService.receiveDatagram(encodeFrame(followResponse, Framing::LEGACY_HEX), sender);
+                }
+                v2vService.receiveDatagram(encodeFrame(leaderStatus, Framing::BINARY), sender);
+            } else {
+                StopFollow stopFollow = decodePayload<StopFollow>(payload);
+                v2vService.receiveDatagram(encodeFrame(stopFollow, Framing::BINARY), sender);
+                if (sender == leader) {
+                    leader.clear();
+                }
+            }
+            settle();
+        }
+        if (settled) {
+            runUntil(time.now() + REPLAY_TAIL);
+        }
+        v2vService.setActuationObserver(nullptr);
+        if (!settled) {
+            cerr << "The service did not settle " << chrono::duration_cast<chrono::milliseconds>(time.now() - start)
+                .count() << " ms into the recording, stopped the replay there" << endl;
+            return 1;
+        }
+    }
+    out.flush();
+    if (commands == 0 && options.count("leader") == 0) {
+        cerr << "Nothing was actuated, a recording started in the middle of a session needs --leader" << endl;
+    }
+    cerr << "Replayed " << reader.records() << " records, " << commands << " motor commands" << endl;
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "v2v/v2v.hpp"
+
+/**
+ * Soak test of the V2V session handling. The service follows itself over loopback (it sends the FollowRequest to its
+ * own port, accepts it as the leader and receives the FollowResponse as the follower) and stops again, many times in a
+ * row. Every session arms and disarms the status tasks and runs the follower thread, so the number of threads and the
+ * resident set size have to be the same after the last cycle as after the first ones.
+ *
+ * The V2V messages go to the service's own address over unicast loopback, but it joins the OD4 channels and listens on
+ * DEFAULT_PORT like the service itself, so nothing else may be using them meanwhile and it is not part of the unit tests.
+ */
+
+using namespace std;
+using namespace std::chrono;
+
+static const int DEFAULT_CYCLES = 10000;
+static const int WARM_UP_CYCLES = 100;
+
+// Allocator caches and the like may move a little, a leak of one session per cycle would not.
+static const long RSS_TOLERANCE_KB = 2048;
+
+static int threadCount() {
+    int count = 0;
+    DIR *tasks = opendir("/proc/self/task");
+    if (tasks == nullptr) {
+        return -1;
+    }
+    while (struct dirent *entry = readdir(tasks)) {
+        if (entry->d_name[0] != '.') {
+            count++;
+        }
+    }
+    closedir(tasks);
+    return count;
+}
+
+static long residentKb() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            return atol(line.c_str() + 6);
+        }
+    }
+    return -1;
+}
+
+static bool waitForFollowing(V2VService &v2v, milliseconds timeout) {
+    steady_clock::time_point deadline = steady_clock::now() + timeout;
+    while (!v2v.isFollowing()) {
+        if (steady_clock::now() > deadline) {
+            return false;
+        }
+        this_thread::sleep_for(microseconds(100));
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int cycles = argc > 1 ? atoi(argv[1]) : DEFAULT_CYCLES;
+
+    V2VService v2v("127.0.0.1", "soak", 0);
+    int established = 0;
+    int baselineThreads = 0;
+    long baselineRss = 0;
+
+    for (int cycle = 1; cycle <= cycles; cycle++) {
+        v2v.followRequest("127.0.0.1");
+        if (waitForFollowing(v2v, milliseconds(100))) {
+            established++;
+        }
+        v2v.stopFollow();
+
+        // Give our own StopFollow messages time to arrive before the next session starts.
+        this_thread::sleep_for(milliseconds(1));
+
+        if (cycle == WARM_UP_CYCLES) {
+            baselineThreads = threadCount();
+            baselineRss = residentKb();
+        }
+        if (cycle % 1000 == 0 || cycle == WARM_UP_CYCLES) {
+            cout << "cycle " << cycle << ": " << threadCount() << " threads, " << residentKb() << " kB resident, "
+                 << established << " sessions established" << endl;
+        }
+    }
+
+    int threads = threadCount();
+    long rss = residentKb();
+    cout << "Threads after warm up " << baselineThreads << ", at the end " << threads << endl;
+    cout << "Resident after warm up " << baselineRss << " kB, at the end " << rss << " kB" << endl;
+
+    if (cycles <= WARM_UP_CYCLES) {
+        cout << "FAILED: needs more than " << WARM_UP_CYCLES << " cycles" << endl;
+        return 1;
+    }
+    if (established == 0) {
+        cout << "FAILED: no follow session was established" << endl;
+        return 1;
+    }
+    if (threads != baselineThreads) {
+        cout << "FAILED: thread count changed" << endl;
+        return 1;
+    }
+    if (rss - baselineRss > RSS_TOLERANCE_KB) {
+        cout << "FAILED: resident set size grew" << endl;
+        return 1;
+    }
+    cout << "PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "actuation_coalescer.hpp"
+
+#include <cmath>
+
+/**
+ * Implementation of the ActuationCoalescer class as declared in actuation_coalescer.hpp
+ */
+
+/**
+ * Constructor for the actuation coalescer.
+ *
+ * @param deadband - smallest change of the command that is sent
+ * @param keepAlive - longest time between two commands sent
+ */
+ActuationCoalescer::ActuationCoalescer(float deadband, TimeSource::duration keepAlive) :
+    deadband(deadband), keepAlive(keepAlive), sentCount(0), suppressedCount(0) {
+    reset();
+}
+
+/**
+ * Decides whether to send a command, and remembers it as the last one sent if so.
+ *
+ * @param command - command about to be sent
+ * @param now - current monotonic time
+ * @return true if the command should be sent
+ */
+bool ActuationCoalescer::shouldSend(float command, TimeSource::time_point now) {
+    // Stopping and starting are never held back, however small the step.
+    bool stopOrStart = command != lastSent && (command == 0 || lastSent == 0);
+    if (haveSent && !stopOrStart && std::fabs(command - lastSent) <= deadband && now - lastSentAt < keepAlive) {
+        suppressedCount++;
+        return false;
+    }
+    haveSent = true;
+    lastSent = command;
+    lastSentAt = now;
+    sentCount++;
+    return true;
+}
+
+/**
+ * Forgets the command last sent, so the next one is sent whatever it is. The counters are kept.
+ */
+void ActuationCoalescer::reset() {
+    haveSent = false;
+    lastSent = 0.0f;
+    lastSentAt = TimeSource::time_point();
+}
+
+/**
+ * @return number of commands sent
+ */
+uint64_t ActuationCoalescer::sent() const {
+    return sentCount;
+}
+
+/**
+ * @return number of commands not sent because they were too close to the one sent before
+ */
+uint64_t ActuationCoalescer::suppressed() const {
+    return suppressedCount;
+}
@@ -0,0 +1,47 @@
+#ifndef V2V_ACTUATION_COALESCER_H
+#define V2V_ACTUATION_COALESCER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "time_source.hpp"
+
+// Changes smaller than these are not sent to the motor, in pedal position and steering angle.
+static const float SPEED_DEADBAND = 0.005f;
+static const float STEERING_DEADBAND = 0.01f;
+
+// A command is sent again at least this often even if it did not change, in case the proxy missed it.
+static const std::chrono::milliseconds ACTUATION_KEEP_ALIVE(500);
+
+/**
+ * Decides which commands for one actuator are worth sending, so repeating the same command does not flood the motor
+ * channel. A command is sent if it moved further than the deadband from the one last sent, if it is an exact stop or
+ * start, or if the last one was sent ACTUATION_KEEP_ALIVE ago. Comparing with the one last sent rather than the one
+ * last given means a slow ramp is still sent once it added up to more than the deadband.
+ *
+ * Not thread safe, apart from reading the counters.
+ */
+class ActuationCoalescer {
+public:
+    ActuationCoalescer(float deadband, TimeSource::duration keepAlive = ACTUATION_KEEP_ALIVE);
+
+    bool shouldSend(float command, TimeSource::time_point now);
+    void reset();
+
+    uint64_t sent() const;
+    uint64_t suppressed() const;
+
+private:
+    const float deadband;
+    const TimeSource::duration keepAlive;
+
+    bool haveSent;
+    float lastSent;
+    TimeSource::time_point lastSentAt;
+
+    std::atomic<uint64_t> sentCount;
+    std::atomic<uint64_t> suppressedCount;
+};
+
+#endif // V2V_ACTUATION_COALESCER_H
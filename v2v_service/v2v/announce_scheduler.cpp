@@ -0,0 +1,120 @@
+#include "announce_scheduler.hpp"
+
+#include <algorithm>
+
+/**
+ * Implementation of the AnnounceScheduler class as declared in announce_scheduler.hpp
+ */
+
+/**
+ * Constructor for the announce scheduler. Nothing is due until start is called.
+ *
+ * @param period - interval to start out at and to fall back to when a car shows up
+ * @param maxPeriod - interval the back off stops at
+ * @param jitter - fraction every interval is randomly shortened or lengthened by, from 0 to 1
+ * @param fastDelay - longest delay before announcing to a car that showed up
+ * @param seed - seed of the jitter, should differ between cars
+ */
+AnnounceScheduler::AnnounceScheduler(std::chrono::milliseconds period, std::chrono::milliseconds maxPeriod,
+                                     double jitter, std::chrono::milliseconds fastDelay, uint32_t seed) :
+    jitter(std::min(std::max(jitter, 0.0), 1.0)), fastDelay(fastDelay), basePeriod(period),
+    maxPeriod(std::max(period, maxPeriod)), random(seed), current(period), next(TimeSource::time_point::max()) {}
+
+/**
+ * Changes the periods, takes effect from the next announcement on.
+ *
+ * @param newPeriod - interval to start out at and to fall back to when a car shows up
+ * @param newMaxPeriod - interval the back off stops at
+ */
+void AnnounceScheduler::setPeriod(std::chrono::milliseconds newPeriod, std::chrono::milliseconds newMaxPeriod) {
+    std::lock_guard<std::mutex> lock(mutex);
+    basePeriod = newPeriod;
+    maxPeriod = std::max(newPeriod, newMaxPeriod);
+    current = std::min(std::max(current, basePeriod), maxPeriod);
+}
+
+/**
+ * Schedules the first announcement within the fast delay.
+ *
+ * @param now - current time
+ */
+void AnnounceScheduler::start(TimeSource::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = basePeriod;
+    next = now + fast();
+}
+
+/**
+ * Stops scheduling announcements until start is called again.
+ */
+void AnnounceScheduler::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    next = TimeSource::time_point::max();
+}
+
+/**
+ * @param now - current time
+ * @return true if an announcement should be sent
+ */
+bool AnnounceScheduler::due(TimeSource::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return now >= next;
+}
+
+/**
+ * Records that we announced ourselves, whether on schedule or on request, and backs off the next announcement.
+ *
+ * @param now - time the announcement was sent
+ */
+void AnnounceScheduler::sent(TimeSource::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (next == TimeSource::time_point::max()) {
+        return;
+    }
+    next = now + jittered(current);
+    current = std::min(current * 2, maxPeriod);
+}
+
+/**
+ * Falls back to the base period after a car showed up, moved or changed what it supports, and announces shortly so
+ * it learns about us without waiting out the back off.
+ *
+ * @param now - current time
+ */
+void AnnounceScheduler::peersChanged(TimeSource::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (next == TimeSource::time_point::max()) {
+        return;
+    }
+    current = basePeriod;
+    next = std::min(next, now + fast());
+}
+
+/**
+ * @return interval the next announcement after this one will be scheduled at, before jitter
+ */
+std::chrono::milliseconds AnnounceScheduler::interval() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+TimeSource::time_point AnnounceScheduler::nextAnnouncement() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return next;
+}
+
+/**
+ * Called with the lock held.
+ */
+TimeSource::duration AnnounceScheduler::jittered(TimeSource::duration interval) {
+    std::uniform_real_distribution<double> factor(1.0 - jitter, 1.0 + jitter);
+    return std::chrono::duration_cast<TimeSource::duration>(interval * factor(random));
+}
+
+/**
+ * Called with the lock held.
+ */
+TimeSource::duration AnnounceScheduler::fast() {
+    std::uniform_real_distribution<double> factor(0.0, 1.0);
+    return std::chrono::duration_cast<TimeSource::duration>(fastDelay * factor(random));
+}
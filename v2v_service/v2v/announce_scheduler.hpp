@@ -0,0 +1,61 @@
+#ifndef V2V_ANNOUNCE_SCHEDULER_H
+#define V2V_ANNOUNCE_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+
+#include "time_source.hpp"
+
+// Interval between our AnnouncePresence messages while cars come and go. While nobody new shows up the interval
+// doubles after every announcement up to the maximum, which is kept well below PEER_TTL so other cars only forget us
+// after several announcements in a row got lost.
+static const std::chrono::milliseconds ANNOUNCE_PERIOD(2000);
+static const std::chrono::milliseconds ANNOUNCE_MAX_PERIOD(16000);
+
+// Every interval is randomly shortened or lengthened by up to this fraction, so cars started together do not keep
+// announcing at the same instant.
+static const double ANNOUNCE_JITTER = 0.25;
+
+// A car that shows up for the first time is answered within this delay, randomised for the same reason.
+static const std::chrono::milliseconds ANNOUNCE_FAST_DELAY(250);
+
+/**
+ * Decides when to announce our presence next. Starts out at the base period and backs off exponentially while the
+ * set of cars around us is stable, falling back to the base period and announcing shortly when it changes.
+ *
+ * The scheduler only keeps time, sending is left to the owner, which polls due(). While stopped nothing is ever due,
+ * announcements sent on request do not start it. All functions may be called from any thread.
+ */
+class AnnounceScheduler {
+public:
+    AnnounceScheduler(std::chrono::milliseconds period, std::chrono::milliseconds maxPeriod, double jitter,
+                      std::chrono::milliseconds fastDelay, uint32_t seed);
+
+    void setPeriod(std::chrono::milliseconds period, std::chrono::milliseconds maxPeriod);
+    void start(TimeSource::time_point now);
+    void stop();
+    bool due(TimeSource::time_point now);
+    void sent(TimeSource::time_point now);
+    void peersChanged(TimeSource::time_point now);
+
+    std::chrono::milliseconds interval();
+    TimeSource::time_point nextAnnouncement();
+
+private:
+    TimeSource::duration jittered(TimeSource::duration interval);
+    TimeSource::duration fast();
+
+    const double jitter;
+    const std::chrono::milliseconds fastDelay;
+
+    std::mutex mutex;
+    std::chrono::milliseconds basePeriod;
+    std::chrono::milliseconds maxPeriod;
+    std::mt19937 random;
+    std::chrono::milliseconds current;
+    TimeSource::time_point next;
+};
+
+#endif // V2V_ANNOUNCE_SCHEDULER_H
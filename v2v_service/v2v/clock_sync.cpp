@@ -0,0 +1,266 @@
+#include "clock_sync.hpp"
+
+/**
+ * Implementation of the ClockSync class as declared in clock_sync.hpp
+ */
+
+ClockSync::ClockSync() {
+    reset();
+}
+
+/**
+ * Stamps an outgoing FollowerStatus with our wall clock, the leader echoes it back.
+ *
+ * @param status - status about to be sent to the leader
+ * @param nowMicros - our wall clock in microseconds
+ */
+void ClockSync::stampFollowerStatus(FollowerStatus &status, int64_t nowMicros) {
+    status.sentMicros((uint64_t) nowMicros);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stamped[stampedNext] = (uint64_t) nowMicros;
+    stampedNext = (stampedNext + 1) % CLOCK_STAMP_HISTORY;
+}
+
+/**
+ * Tells whether a LeaderStatus echoes one of our recent FollowerStatus messages. A leader multicasting its statuses
+ * echoes a different follower in each of them, the others must not be taken for exchanges of ours.
+ *
+ * @param status - received LeaderStatus
+ * @return true if the echo is of a FollowerStatus we stamped
+ */
+bool ClockSync::echoesOurs(const LeaderStatus &status) {
+    if (status.echoSentMicros() == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < CLOCK_STAMP_HISTORY; i++) {
+        if (stamped[i] == status.echoSentMicros()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Takes a sample from a LeaderStatus echoing one of our FollowerStatus messages, and records the one way latency of
+ * the update if we are synced.
+ *
+ * @param status - received LeaderStatus
+ * @param receivedMicros - our wall clock when it was received
+ * @param sample - receives the sample if one was taken
+ * @return false if the status did not carry a new usable exchange, for example because the leader does not take part
+ */
+bool ClockSync::processLeaderStatus(const LeaderStatus &status, int64_t receivedMicros, ClockSample *sample) {
+    bool firstEcho;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        firstEcho = status.echoSentMicros() != lastEcho;
+        // A status without an echo does not end the run of echoes of the same FollowerStatus.
+        if (status.echoSentMicros() != 0) {
+            lastEcho = status.echoSentMicros();
+        }
+    }
+    bool taken = firstEcho && addSample((int64_t) status.echoSentMicros(), (int64_t) status.echoReceivedMicros(),
+                                        (int64_t) status.timestampMicros(), receivedMicros, sample);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (havePicked && status.timestampMicros() != 0) {
+        latencies.record(receivedMicros - ((int64_t) status.timestampMicros() - offsetAt(receivedMicros)));
+    }
+    return taken;
+}
+
+/**
+ * Remembers a FollowerStatus to echo in the next LeaderStatus messages.
+ *
+ * @param status - received FollowerStatus
+ * @param receivedMicros - our wall clock when it was received
+ */
+void ClockSync::processFollowerStatus(const FollowerStatus &status, int64_t receivedMicros) {
+    if (status.sentMicros() == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    echoSent = status.sentMicros();
+    echoReceived = (uint64_t) receivedMicros;
+}
+
+/**
+ * Stamps an outgoing LeaderStatus with our wall clock and echoes the last FollowerStatus, if we got one.
+ *
+ * @param status - status about to be sent to the follower
+ * @param nowMicros - our wall clock in microseconds
+ */
+void ClockSync::stampLeaderStatus(LeaderStatus &status, int64_t nowMicros) {
+    std::lock_guard<std::mutex> lock(mutex);
+    status.timestampMicros((uint64_t) nowMicros);
+    status.echoSentMicros(echoSent);
+    status.echoReceivedMicros(echoReceived);
+}
+
+/**
+ * Adds an exchange to the filter.
+ *
+ * @param t1 - follower clock when the follower sent
+ * @param t2 - leader clock when the leader received
+ * @param t3 - leader clock when the leader answered
+ * @param t4 - follower clock when the follower received the answer
+ * @param sample - receives the sample computed from the exchange
+ * @return false if the exchange is incomplete or impossible, it is then ignored
+ */
+bool ClockSync::addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4, ClockSample *sample) {
+    if (t1 == 0 || t2 == 0 || t3 == 0 || t4 == 0 || t3 < t2 || t4 < t1) {
+        return false;
+    }
+    ClockSample added;
+    added.delayMicros = (t4 - t1) - (t3 - t2);
+    added.offsetMicros = ((t2 - t1) + (t3 - t4)) / 2;
+    added.takenMicros = t4;
+    if (added.delayMicros < 0) {
+        return false; // One of the clocks was stepped during the exchange.
+    }
+    if (sample != nullptr) {
+        *sample = added;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    filter[filterNext] = added;
+    filterNext = (filterNext + 1) % CLOCK_FILTER_SIZE;
+    if (filterCount < CLOCK_FILTER_SIZE) {
+        filterCount++;
+    }
+
+    const ClockSample *best = &filter[0];
+    for (size_t i = 1; i < filterCount; i++) {
+        if (filter[i].delayMicros < best->delayMicros) {
+            best = &filter[i];
+        }
+    }
+
+    // Each exchange only counts once towards the drift, however long it stays the best one.
+    if (!havePicked || best->takenMicros != picked.takenMicros) {
+        picked = *best;
+        havePicked = true;
+        history[historyNext] = picked;
+        historyNext = (historyNext + 1) % CLOCK_DRIFT_HISTORY;
+        if (historyCount < CLOCK_DRIFT_HISTORY) {
+            historyCount++;
+        }
+        fitDrift();
+    }
+    return true;
+}
+
+/**
+ * Forgets every sample and the FollowerStatus to echo, used when a new session starts. The latency histogram is kept.
+ */
+void ClockSync::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    filterCount = 0;
+    filterNext = 0;
+    havePicked = false;
+    historyCount = 0;
+    historyNext = 0;
+    drift = 0.0;
+    lastEcho = 0;
+    for (size_t i = 0; i < CLOCK_STAMP_HISTORY; i++) {
+        stamped[i] = 0;
+    }
+    stampedNext = 0;
+    echoSent = 0;
+    echoReceived = 0;
+}
+
+/**
+ * @return true once an offset has been estimated
+ */
+bool ClockSync::synced() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return havePicked;
+}
+
+/**
+ * @param atMicros - follower time to estimate the offset at
+ * @return leader clock minus follower clock in microseconds, 0 while not synced
+ */
+int64_t ClockSync::offsetMicros(int64_t atMicros) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return offsetAt(atMicros);
+}
+
+/**
+ * @return how many microseconds per second the leader clock gains on ours, 0 until enough time has been covered
+ */
+double ClockSync::driftPpm() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return drift;
+}
+
+/**
+ * @param leaderSentMicros - leader clock when it sent a message
+ * @param receivedMicros - follower clock when we received it
+ * @return time the message spent on the way, only meaningful while synced
+ */
+int64_t ClockSync::oneWayLatencyMicros(int64_t leaderSentMicros, int64_t receivedMicros) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return receivedMicros - (leaderSentMicros - offsetAt(receivedMicros));
+}
+
+const LatencyHistogram &ClockSync::latency() const {
+    return latencies;
+}
+
+/**
+ * Called with the lock held.
+ */
+int64_t ClockSync::offsetAt(int64_t atMicros) const {
+    if (!havePicked) {
+        return 0;
+    }
+    return picked.offsetMicros + (int64_t) (drift * 1e-6 * (double) (atMicros - picked.takenMicros));
+}
+
+/**
+ * Fits a line through the picked offsets, its slope is the drift. Called with the lock held.
+ */
+void ClockSync::fitDrift() {
+    drift = 0.0;
+    if (historyCount < 2) {
+        return;
+    }
+
+    int64_t first = history[0].takenMicros;
+    int64_t last = history[0].takenMicros;
+    for (size_t i = 1; i < historyCount; i++) {
+        first = history[i].takenMicros < first ? history[i].takenMicros : first;
+        last = history[i].takenMicros > last ? history[i].takenMicros : last;
+    }
+    if (last - first < CLOCK_DRIFT_MIN_SPAN_MICROS) {
+        return;
+    }
+
+    // Relative to the first sample, so the sums stay well within the precision of a double.
+    double meanX = 0.0;
+    double meanY = 0.0;
+    for (size_t i = 0; i < historyCount; i++) {
+        meanX += (double) (history[i].takenMicros - first);
+        meanY += (double) history[i].offsetMicros;
+    }
+    meanX /= (double) historyCount;
+    meanY /= (double) historyCount;
+
+    double covariance = 0.0;
+    double variance = 0.0;
+    for (size_t i = 0; i < historyCount; i++) {
+        double x = (double) (history[i].takenMicros - first) - meanX;
+        covariance += x * ((double) history[i].offsetMicros - meanY);
+        variance += x * x;
+    }
+    drift = covariance / variance * 1e6;
+    if (drift > CLOCK_MAX_DRIFT_PPM) {
+        drift = CLOCK_MAX_DRIFT_PPM;
+    } else if (drift < -CLOCK_MAX_DRIFT_PPM) {
+        drift = -CLOCK_MAX_DRIFT_PPM;
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef V2V_CLOCK_SYNC_H
+#define V2V_CLOCK_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "messages.hpp"
+
+#include "histogram.hpp"
+
+// Number of recent exchanges the offset is picked from, the one with the shortest round trip wins.
+static const size_t CLOCK_FILTER_SIZE = 16;
+
+// Number of picked offsets the drift is fitted to, and the time they have to span before the drift is trusted.
+static const size_t CLOCK_DRIFT_HISTORY = 32;
+static const int64_t CLOCK_DRIFT_MIN_SPAN_MICROS = 30000000;
+
+// FollowerStatus stamps remembered to recognise echoes of our own, the leader echoes the last one it received.
+static const size_t CLOCK_STAMP_HISTORY = 4;
+
+// Larger drifts are not believed, NTP uses the same bound for the frequency error of a clock.
+static const double CLOCK_MAX_DRIFT_PPM = 500.0;
+
+/**
+ * One NTP style exchange. The follower sends at t1 and the leader receives at t2, both on their own wall clock, the
+ * leader answers at t3 and the follower receives the answer at t4.
+ */
+struct ClockSample {
+    // Leader clock minus follower clock, in microseconds.
+    int64_t offsetMicros;
+    // Round trip time without the time the leader held on to the exchange.
+    int64_t delayMicros;
+    // Follower time the sample was taken at (t4).
+    int64_t takenMicros;
+};
+
+/**
+ * Estimates the offset and drift of the leader's wall clock against ours from the FollowerStatus and LeaderStatus
+ * messages that are exchanged anyway, see the microsecond fields in messages.odvd.
+ *
+ * The offset is taken from the exchange with the shortest round trip out of the last CLOCK_FILTER_SIZE ones, since
+ * its error is bounded by half its round trip, like the clock filter of NTP. The drift is the slope of a least
+ * squares line through the offsets picked over the last CLOCK_DRIFT_HISTORY picks. With both, a leader timestamp can
+ * be moved onto our clock, which gives the one way latency of every leader update.
+ *
+ * A car takes on the follower role towards its leader and the leader role towards its follower, each with its own
+ * instance. All functions may be called from any thread.
+ */
+class ClockSync {
+public:
+    ClockSync();
+
+    // Follower side.
+    void stampFollowerStatus(FollowerStatus &status, int64_t nowMicros);
+    bool processLeaderStatus(const LeaderStatus &status, int64_t receivedMicros, ClockSample *sample = nullptr);
+    bool echoesOurs(const LeaderStatus &status);
+
+    // Leader side.
+    void processFollowerStatus(const FollowerStatus &status, int64_t receivedMicros);
+    void stampLeaderStatus(LeaderStatus &status, int64_t nowMicros);
+
+    bool addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4, ClockSample *sample = nullptr);
+    void reset();
+
+    bool synced();
+    int64_t offsetMicros(int64_t atMicros);
+    double driftPpm();
+    int64_t oneWayLatencyMicros(int64_t leaderSentMicros, int64_t receivedMicros);
+
+    // One way latency of the leader updates, recorded while synced.
+    const LatencyHistogram &latency() const;
+
+private:
+    int64_t offsetAt(int64_t atMicros) const;
+    void fitDrift();
+
+    std::mutex mutex;
+
+    // Follower side, the last exchanges and the offsets picked from them.
+    ClockSample filter[CLOCK_FILTER_SIZE];
+    size_t filterCount;
+    size_t filterNext;
+    ClockSample picked;
+    bool havePicked;
+    ClockSample history[CLOCK_DRIFT_HISTORY];
+    size_t historyCount;
+    size_t historyNext;
+    double drift;
+
+    // Follower side, the last FollowerStatus echoed back. The leader echoes it until the next one arrives, only the
+    // first echo is used so the filter covers as many separate exchanges as it can.
+    uint64_t lastEcho;
+    uint64_t stamped[CLOCK_STAMP_HISTORY];
+    size_t stampedNext;
+
+    // Leader side, the last FollowerStatus to echo.
+    uint64_t echoSent;
+    uint64_t echoReceived;
+
+    LatencyHistogram latencies;
+};
+
+#endif // V2V_CLOCK_SYNC_H
@@ -0,0 +1,104 @@
+#include "distance_trail.hpp"
+
+/**
+ * Implementation of the DistanceTrail class as declared in distance_trail.hpp
+ */
+
+DistanceTrail::DistanceTrail(float followerCalibration) : followerOdometry(followerCalibration) {
+    reset(0.0f);
+}
+
+/**
+ * Records a leader status on the trail. While the leader is standing still only changes of its command are recorded,
+ * so a waiting leader does not fill up the trail.
+ *
+ * @param distanceTraveled - distance in cm the leader has driven since its previous status
+ * @param speed - pedal position of the leader
+ * @param steeringAngle - steering angle of the leader
+ * @return false if the trail was full and the point was dropped
+ */
+bool DistanceTrail::record(uint8_t distanceTraveled, float speed, float steeringAngle) {
+    float distance = recordedDistance.load(std::memory_order_relaxed) + distanceTraveled;
+    recordedDistance.store(distance, std::memory_order_release);
+    if (distanceTraveled == 0 && speed == recordedCommand.speed && steeringAngle == recordedCommand.steeringAngle) {
+        return true;
+    }
+    recordedCommand.speed = speed;
+    recordedCommand.steeringAngle = steeringAngle;
+
+    TrailPoint point = {distance, speed, steeringAngle};
+    return points.push(point);
+}
+
+/**
+ * @return distance in cm the leader has driven since following started, as reported by the leader
+ */
+float DistanceTrail::leaderDistance() const {
+    return recordedDistance.load(std::memory_order_acquire);
+}
+
+/**
+ * Moves the follower along the trail for a period of time at its current command, then works out the next command.
+ *
+ * The follower takes over the command of every point it passes, which is what the leader drove the stretch up to the
+ * next point with. A point further ahead means the leader did make it there, so the follower never drives slower than
+ * the car can move while there is one. Without any point ahead, or when it gets closer to the leader than the follow
+ * distance, the follower has caught up and stops.
+ *
+ * @param elapsed - time since the previous step
+ * @return command to drive with until the next step
+ */
+TrailCommand DistanceTrail::step(std::chrono::microseconds elapsed) {
+    followerOdometry.advance(command.speed, elapsed);
+
+    float position = followerOdometry.distance();
+    TrailPoint *next = points.front();
+    while (next != nullptr && next->distance <= position) {
+        points.pop(lastPassed);
+        next = points.front();
+    }
+
+    command.steeringAngle = lastPassed.steeringAngle;
+    if (next == nullptr || position + followDistance >= leaderDistance()) {
+        command.speed = 0.0f;
+    } else {
+        command.speed = lastPassed.speed < MIN_MOVING_PEDAL_POSITION ? MIN_MOVING_PEDAL_POSITION : lastPassed.speed;
+    }
+    return command;
+}
+
+/**
+ * @return distance in cm the follower has driven, on the same axis as the leader distance
+ */
+float DistanceTrail::followerDistance() const {
+    return followerOdometry.distance();
+}
+
+size_t DistanceTrail::pointsAhead() const {
+    return points.size();
+}
+
+/**
+ * Empties the trail for a new follow session.
+ *
+ * @param followerStartDistance - where the follower starts on the trail, negative since it is behind the leader
+ */
+void DistanceTrail::reset(float followerStartDistance) {
+    points.clear();
+    recordedDistance.store(0.0f, std::memory_order_release);
+    recordedCommand.speed = 0.0f;
+    recordedCommand.steeringAngle = 0.0f;
+
+    // Until we reach the leader's first point we drive straight at the lowest speed, like the pre fill in time mode.
+    followDistance = -followerStartDistance;
+    followerOdometry.reset(followerStartDistance);
+    lastPassed.distance = followerStartDistance;
+    lastPassed.speed = MIN_MOVING_PEDAL_POSITION;
+    lastPassed.steeringAngle = 0.0f;
+    command.speed = 0.0f;
+    command.steeringAngle = 0.0f;
+}
+
+uint64_t DistanceTrail::overflows() const {
+    return points.overflows();
+}
@@ -0,0 +1,80 @@
+#ifndef V2V_DISTANCE_TRAIL_H
+#define V2V_DISTANCE_TRAIL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "odometry.hpp"
+#include "spsc_queue.hpp"
+
+// Room for 32 seconds of leader updates at the protocol rate of 8 Hz.
+static const size_t TRAIL_SIZE = 256;
+
+// Gap to the leader when following starts, the follower keeps at least this far behind the leader on its trail.
+static const float FOLLOW_DISTANCE_CM = 100.0f;
+
+// How often the follower steps along the leader's trail.
+static const std::chrono::milliseconds TRAIL_STEP_INTERVAL(25);
+
+/**
+ * A command the leader was driving with, indexed by the leader's odometry at the moment it reported it.
+ */
+struct TrailPoint {
+    float distance;
+    float speed;
+    float steeringAngle;
+};
+
+/**
+ * Follow command produced by the trail.
+ */
+struct TrailCommand {
+    float speed;
+    float steeringAngle;
+};
+
+/**
+ * Breadcrumb trail of leader commands for distance based following.
+ *
+ * Every LeaderStatus becomes a point on the trail at the distance the leader had driven when sending it (the sum of
+ * all distanceTraveled fields so far). The follower keeps its own odometry on the same axis, starting behind the
+ * leader, and takes over the leader's command once it reaches a point, so it turns at the spot the leader turned no
+ * matter how fast either car drives. Points are dropped as soon as they have been passed.
+ *
+ * Recording is done by the UDP receiver thread and stepping by the follower thread, with the same single producer,
+ * single consumer split as the leader update queue.
+ */
+class DistanceTrail {
+public:
+    explicit DistanceTrail(float followerCalibration = 1.0f);
+
+    // Producer
+    bool record(uint8_t distanceTraveled, float speed, float steeringAngle);
+    float leaderDistance() const;
+
+    // Consumer
+    TrailCommand step(std::chrono::microseconds elapsed);
+    float followerDistance() const;
+    size_t pointsAhead() const;
+
+    // Only while there is no follower thread stepping the trail.
+    void reset(float followerStartDistance);
+
+    uint64_t overflows() const;
+
+private:
+    SpscQueue<TrailPoint, TRAIL_SIZE> points;
+
+    // Producer owned, the distance is read by the consumer to keep the follow distance.
+    std::atomic<float> recordedDistance;
+    TrailCommand recordedCommand;
+
+    // Consumer owned
+    float followDistance;
+    Odometry followerOdometry;
+    TrailPoint lastPassed;
+    TrailCommand command;
+};
+
+#endif // V2V_DISTANCE_TRAIL_H
@@ -0,0 +1,162 @@
+#include <vector>
+
+#include "event_loop.hpp"
+
+/**
+ * Implementation of the EventLoop class as declared in event_loop.hpp
+ */
+
+/**
+ * Constructor for the event loop.
+ *
+ * @param startThread - false to run tasks only when runDueTasks is called
+ * @param timeSource - clock the loop thread runs tasks by
+ */
+EventLoop::EventLoop(bool startThread, const TimeSource &timeSource) :
+    timeSource(timeSource), nextId(1), armedSinceWait(false), stopping(false) {
+    if (startThread) {
+        thread = std::thread(&EventLoop::run, this);
+    }
+}
+
+EventLoop::~EventLoop() {
+    stop();
+}
+
+/**
+ * Arms a periodic task. Its first run is due right away.
+ *
+ * @param period - time between two runs
+ * @param task - function to run on the loop thread
+ * @return id to disarm the task with
+ */
+EventLoop::TaskId EventLoop::arm(std::chrono::microseconds period, std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    TaskId id = nextId++;
+
+    Task &armed = tasks[id];
+    armed.callback = std::make_shared<std::function<void()>>(std::move(task));
+    armed.period = period;
+    armed.deadline = timeSource.now();
+
+    armedSinceWait = true;
+    wakeUp.notify_all();
+    return id;
+}
+
+/**
+ * Disarms a task, it will not be started again. A run that is already in progress on the loop thread is not
+ * interrupted.
+ *
+ * @param id - id returned by arm
+ * @return false if the task was not armed
+ */
+bool EventLoop::disarm(TaskId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.erase(id) > 0;
+}
+
+size_t EventLoop::armedTasks() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+}
+
+/**
+ * Sets the function run after every round of due tasks, replacing the previous one. Runs on the loop thread like the
+ * tasks, without the loop's lock held.
+ *
+ * @param hook - function to run, empty to run nothing
+ */
+void EventLoop::setAfterTasks(std::function<void()> hook) {
+    std::lock_guard<std::mutex> lock(mutex);
+    afterTasks = hook ? std::make_shared<std::function<void()>>(std::move(hook)) : nullptr;
+}
+
+/**
+ * Runs every task that is due at the given time, each one at most once, followed by the after tasks hook if any of
+ * them ran.
+ *
+ * @param now - current time
+ * @return deadline of the earliest task after this, Clock::time_point::max() if no task is armed
+ */
+EventLoop::Clock::time_point EventLoop::runDueTasks(Clock::time_point now) {
+    std::vector<std::pair<TaskId, std::shared_ptr<std::function<void()>>>> due;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (std::map<TaskId, Task>::iterator it = tasks.begin(); it != tasks.end(); ++it) {
+        Task &task = it->second;
+        if (task.deadline > now) {
+            continue;
+        }
+        due.push_back(std::make_pair(it->first, task.callback));
+
+        task.deadline += task.period;
+        if (task.deadline <= now) {
+            // More than one period behind, skip the missed runs.
+            task.deadline = now + task.period;
+        }
+    }
+
+    for (size_t i = 0; i < due.size(); i++) {
+        // An earlier task may have disarmed this one.
+        if (tasks.count(due[i].first) == 0) {
+            continue;
+        }
+        lock.unlock();
+        (*due[i].second)();
+        lock.lock();
+    }
+    if (!due.empty() && afterTasks) {
+        std::shared_ptr<std::function<void()>> hook = afterTasks;
+        lock.unlock();
+        (*hook)();
+        lock.lock();
+    }
+
+    Clock::time_point next = Clock::time_point::max();
+    for (std::map<TaskId, Task>::iterator it = tasks.begin(); it != tasks.end(); ++it) {
+        if (it->second.deadline < next) {
+            next = it->second.deadline;
+        }
+    }
+    return next;
+}
+
+/**
+ * Stops the loop thread and waits for it to exit. Tasks stay armed but are not run anymore.
+ */
+void EventLoop::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        wakeUp.notify_all();
+    }
+    if (!thread.joinable()) {
+        return;
+    }
+    if (thread.get_id() == std::this_thread::get_id()) {
+        // Stopped by one of our own tasks, the thread exits once the task returns.
+        thread.detach();
+    } else {
+        thread.join();
+    }
+}
+
+/**
+ * Body of the loop thread, sleeps until the earliest deadline or until a task is armed.
+ */
+void EventLoop::run() {
+    Clock::time_point next = timeSource.now();
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        timeSource.waitUntil(lock, wakeUp, next, [this] { return stopping || armedSinceWait; });
+        if (stopping) {
+            break;
+        }
+        armedSinceWait = false;
+
+        lock.unlock();
+        next = runDueTasks(timeSource.now());
+        lock.lock();
+    }
+}
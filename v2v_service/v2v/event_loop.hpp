@@ -0,0 +1,71 @@
+#ifndef V2V_EVENT_LOOP_H
+#define V2V_EVENT_LOOP_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "time_source.hpp"
+
+/**
+ * A single long-lived thread running periodic tasks.
+ *
+ * Tasks are armed with a period and run on the loop thread until they are disarmed. Deadlines are absolute, a task
+ * that runs late does not push back its later runs, and a task that fell more than one period behind skips the missed
+ * runs instead of catching up in a burst. Tasks run without the loop's lock held, so a task may arm and disarm tasks
+ * itself, including disarming itself. An after tasks hook, if set, runs on the loop thread after every round in which
+ * at least one task ran, for work the tasks of a round share, like sending what they queued in one go.
+ *
+ * A loop constructed without its thread runs nothing by itself, runDueTasks then has to be called by the owner. This
+ * is meant for tests that drive the loop through time by hand. Alternatively the loop thread can be run on a
+ * ManualTimeSource, it then runs tasks as the simulated time is advanced.
+ */
+class EventLoop {
+public:
+    typedef std::chrono::steady_clock Clock;
+    // Ids start at 1, so 0 can be used to mark "no task".
+    typedef uint64_t TaskId;
+
+    explicit EventLoop(bool startThread = true, const TimeSource &timeSource = TimeSource::system());
+    ~EventLoop();
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    TaskId arm(std::chrono::microseconds period, std::function<void()> task);
+    bool disarm(TaskId id);
+    size_t armedTasks();
+    void setAfterTasks(std::function<void()> hook);
+
+    Clock::time_point runDueTasks(Clock::time_point now);
+    void stop();
+
+private:
+    struct Task {
+        std::shared_ptr<std::function<void()>> callback;
+        std::chrono::microseconds period;
+        Clock::time_point deadline;
+    };
+
+    void run();
+
+    const TimeSource &timeSource;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::map<TaskId, Task> tasks;
+    std::shared_ptr<std::function<void()>> afterTasks;
+    TaskId nextId;
+    // Set when a task is armed, the earliest deadline may have moved up.
+    bool armedSinceWait;
+    bool stopping;
+
+    std::thread thread;
+};
+
+#endif // V2V_EVENT_LOOP_H
@@ -0,0 +1,197 @@
+#include "follower_group.hpp"
+
+#include "log.hpp"
+
+/**
+ * Implementation of the FollowerGroup class as declared in follower_group.hpp
+ */
+
+/**
+ * Constructor for a follower.
+ *
+ * @param followerIp - IP of the follower
+ * @param followerSender - context to send to the follower through
+ * @param followerFraming - framing the follower advertised in its FollowRequest
+ */
+Follower::Follower(const std::string &followerIp, std::shared_ptr<PeerSendContext> followerSender,
+                   Framing followerFraming) :
+    ip(followerIp), peer("follower " + followerIp), sender(std::move(followerSender)), framing(followerFraming),
+    multicast(false) {}
+
+/**
+ * Constructor for the follower group.
+ *
+ * @param maxFollowers - number of followers accepted at most
+ */
+FollowerGroup::FollowerGroup(size_t maxFollowers) : capacity(maxFollowers) {
+    members.reserve(capacity);
+    sharedPayload.reserve(MAX_FRAME_SIZE);
+    tailPayload.reserve(MAX_FRAME_SIZE);
+}
+
+/**
+ * Adds a follower. A car that follows us already starts over with a new session, its previous one is dropped.
+ *
+ * @param ip - IP of the follower
+ * @param sender - context to send to the follower through
+ * @param framing - framing the follower advertised
+ * @return the new follower, nullptr if the group is full
+ */
+std::shared_ptr<Follower> FollowerGroup::add(const std::string &ip, std::shared_ptr<PeerSendContext> sender,
+                                             Framing framing) {
+    std::shared_ptr<Follower> follower = std::make_shared<Follower>(ip, std::move(sender), framing);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::shared_ptr<Follower> &member : members) {
+        if (member->ip == ip) {
+            member = follower;
+            return follower;
+        }
+    }
+    if (members.size() >= capacity) {
+        return nullptr;
+    }
+    members.push_back(follower);
+    return follower;
+}
+
+/**
+ * @param ip - IP of the follower
+ * @return the follower, nullptr if the car does not follow us
+ */
+std::shared_ptr<Follower> FollowerGroup::find(const std::string &ip) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const std::shared_ptr<Follower> &member : members) {
+        if (member->ip == ip) {
+            return member;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @param ip - IP of the follower
+ * @return the removed follower, nullptr if the car did not follow us
+ */
+std::shared_ptr<Follower> FollowerGroup::remove(const std::string &ip) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < members.size(); i++) {
+        if (members[i]->ip == ip) {
+            std::shared_ptr<Follower> removed = members[i];
+            members.erase(members.begin() + i);
+            return removed;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Removes every follower.
+ *
+ * @return the removed followers
+ */
+std::vector<std::shared_ptr<Follower>> FollowerGroup::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::shared_ptr<Follower>> removed;
+    removed.swap(members);
+    members.reserve(capacity);
+    return removed;
+}
+
+/**
+ * @return the current followers, in the order they joined
+ */
+std::vector<std::shared_ptr<Follower>> FollowerGroup::followers() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return members;
+}
+
+size_t FollowerGroup::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return members.size();
+}
+
+bool FollowerGroup::empty() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return members.empty();
+}
+
+/**
+ * Starts or stops multicasting to the followers that joined the group.
+ *
+ * @param multicastGroup - context of the group from the send pool, nullptr to only send unicast
+ */
+void FollowerGroup::setMulticastGroup(std::shared_ptr<PeerSendContext> multicastGroup) {
+    std::lock_guard<std::mutex> lock(mutex);
+    group = std::move(multicastGroup);
+    groupErrors = group != nullptr ? group->sendErrors() : 0;
+}
+
+/**
+ * @return context of the multicast group, nullptr while we do not multicast
+ */
+std::shared_ptr<PeerSendContext> FollowerGroup::multicastGroup() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return group;
+}
+
+/**
+ * Queues a LeaderStatus for every follower, stamped with our wall clock and the echo of the follower's last
+ * FollowerStatus. The datagrams go out with the next flush of the pool.
+ *
+ * @param pool - send pool to queue on
+ * @param status - status to send, left holding the last echo encoded
+ * @param nowMicros - wall clock time to stamp
+ * @return number of datagrams queued
+ */
+size_t FollowerGroup::fanOut(SendPool &pool, LeaderStatus &status, int64_t nowMicros) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (members.empty()) {
+        return 0;
+    }
+
+    if (group != nullptr && group->sendErrors() > groupErrors) {
+        V2V_LOG(WARNING) << "Could not multicast to " << group->ip() << ", sending unicast to every follower!";
+        group.reset();
+    }
+
+    status.timestampMicros(static_cast<uint64_t>(nowMicros));
+    sharedPayload.clear();
+    encodeLeaderStatusShared(status, sharedPayload);
+
+    size_t queued = 0;
+    size_t inGroup = 0;
+    for (const std::shared_ptr<Follower> &follower : members) {
+        // Only our own cars join, they all understand binary framing.
+        if (group != nullptr && follower->multicast && follower->framing == Framing::BINARY) {
+            inGroup++;
+            continue;
+        }
+        follower->clock.stampLeaderStatus(status, nowMicros);
+        tailPayload.clear();
+        encodeLeaderStatusTail(status, tailPayload);
+        pool.queueFrame(follower->sender, LeaderStatus::ID(), follower->framing, sharedPayload, tailPayload);
+        queued++;
+    }
+
+    if (inGroup > 0) {
+        // Without an echo should a follower leave the group meanwhile.
+        status.echoSentMicros(0);
+        status.echoReceivedMicros(0);
+        size_t turn = echoTurn++ % inGroup;
+        for (const std::shared_ptr<Follower> &follower : members) {
+            if (!follower->multicast || follower->framing != Framing::BINARY) {
+                continue;
+            }
+            if (turn-- == 0) {
+                follower->clock.stampLeaderStatus(status, nowMicros);
+                break;
+            }
+        }
+        tailPayload.clear();
+        encodeLeaderStatusTail(status, tailPayload);
+        pool.queueFrame(group, LeaderStatus::ID(), Framing::BINARY, sharedPayload, tailPayload);
+        queued++;
+    }
+    return queued;
+}
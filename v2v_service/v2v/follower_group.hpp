@@ -0,0 +1,87 @@
+#ifndef V2V_FOLLOWER_GROUP_H
+#define V2V_FOLLOWER_GROUP_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "messages.hpp"
+
+#include "clock_sync.hpp"
+#include "framing.hpp"
+#include "send_pool.hpp"
+
+// Cars that may follow us at the same time, enough for a convoy of ten with everyone following the lead car.
+static const size_t MAX_FOLLOWERS = 10;
+
+/**
+ * A car following us, with everything kept per follower: where to send, the framing it advertised, whether it takes
+ * our statuses from the multicast group and the echo of its last FollowerStatus.
+ */
+struct Follower {
+    Follower(const std::string &ip, std::shared_ptr<PeerSendContext> sender, Framing framing);
+
+    const std::string ip;
+    // Name the follower is watched under in the liveness tracker.
+    const std::string peer;
+    const std::shared_ptr<PeerSendContext> sender;
+    const Framing framing;
+    // Set from the follower's FollowerStatus messages.
+    std::atomic<bool> multicast;
+    ClockSync clock;
+};
+
+/**
+ * The cars following us. Every LeaderStatus goes to all of them: the fields they have in common are serialised once,
+ * only the echo of each follower's last FollowerStatus is encoded per follower, and the datagrams are queued on the
+ * send pool to go out together.
+ *
+ * With a multicast group set, followers that joined it get a single datagram between them instead, echoing each of
+ * them in turn. Followers that did not join keep getting their own. Should the kernel refuse a datagram to the group,
+ * the group is given up and every follower gets unicast again.
+ *
+ * All functions may be called from any thread. Followers are handed out as shared pointers, a follower that was
+ * removed stays usable for as long as it is held.
+ */
+class FollowerGroup {
+public:
+    explicit FollowerGroup(size_t capacity = MAX_FOLLOWERS);
+
+    FollowerGroup(const FollowerGroup &) = delete;
+    FollowerGroup &operator=(const FollowerGroup &) = delete;
+
+    std::shared_ptr<Follower> add(const std::string &ip, std::shared_ptr<PeerSendContext> sender, Framing framing);
+    std::shared_ptr<Follower> find(const std::string &ip);
+    std::shared_ptr<Follower> remove(const std::string &ip);
+    std::vector<std::shared_ptr<Follower>> clear();
+    std::vector<std::shared_ptr<Follower>> followers();
+
+    size_t size();
+    bool empty();
+
+    void setMulticastGroup(std::shared_ptr<PeerSendContext> group);
+    std::shared_ptr<PeerSendContext> multicastGroup();
+
+    size_t fanOut(SendPool &pool, LeaderStatus &status, int64_t nowMicros);
+
+private:
+    const size_t capacity;
+
+    // Null while we do not multicast. The send errors seen when it was set, more mean it does not work.
+    std::shared_ptr<PeerSendContext> group;
+    uint64_t groupErrors = 0;
+    // Follower whose echo the next multicast status carries, counted among the followers in the group.
+    size_t echoTurn = 0;
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Follower>> members;
+
+    // Encoded LeaderStatus fields, reused for every fan out.
+    std::string sharedPayload;
+    std::string tailPayload;
+};
+
+#endif // V2V_FOLLOWER_GROUP_H
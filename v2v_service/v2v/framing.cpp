@@ -0,0 +1,359 @@
+#include "framing.hpp"
+
+#include <cstring>
+
+/**
+ * Implementation of the V2V wire framing as declared in framing.hpp
+ */
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+// Protobuf wire types as written by cluon's ToProtoVisitor and ProtoWriter.
+static const uint32_t WIRE_VARINT = 0;
+static const uint32_t WIRE_FIXED64 = 1;
+static const uint32_t WIRE_LENGTH_DELIMITED = 2;
+static const uint32_t WIRE_FIXED32 = 5;
+
+/**
+ * Parses a fixed width hex number.
+ *
+ * @param data - first character of the number
+ * @param width - number of characters to parse
+ * @param value - parsed value
+ * @return false if any character was not a hex digit
+ */
+static bool parseHex(const char *data, size_t width, uint32_t &value) {
+    value = 0;
+    for (size_t i = 0; i < width; i++) {
+        char c = data[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        value = (value << 4) | digit;
+    }
+    return true;
+}
+
+/**
+ * Writes a fixed width, zero padded, lower case hex number.
+ */
+static void writeHex(char *out, size_t width, uint32_t value) {
+    for (size_t i = width; i > 0; i--) {
+        out[i - 1] = HEX_DIGITS[value & 0xF];
+        value >>= 4;
+    }
+}
+
+/**
+ * Fills in the header of a frame. The frame must start with room for the header of the given framing, followed by the
+ * payload.
+ *
+ * @param framing - header format to use
+ * @param id - message ID
+ * @param frame - header space followed by the protobuf encoded message
+ */
+void writeFrameHeader(Framing framing, uint16_t id, std::string &frame) {
+    if (framing == Framing::BINARY) {
+        uint32_t length = static_cast<uint32_t>(frame.length() - BINARY_HEADER_SIZE);
+        frame[0] = static_cast<char>(BINARY_FRAME_MAGIC);
+        frame[1] = static_cast<char>(BINARY_FRAME_VERSION);
+        frame[2] = static_cast<char>(id >> 8);
+        frame[3] = static_cast<char>(id);
+        frame[4] = static_cast<char>(length >> 24);
+        frame[5] = static_cast<char>(length >> 16);
+        frame[6] = static_cast<char>(length >> 8);
+        frame[7] = static_cast<char>(length);
+    } else {
+        uint32_t length = static_cast<uint32_t>(frame.length() - LEGACY_HEADER_SIZE);
+        writeHex(&frame[0], 4, id);
+        writeHex(&frame[4], 6, length);
+    }
+}
+
+/**
+ * Appends a protobuf varint.
+ */
+static void writeVarint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static void writeKey(std::string &out, uint32_t id, uint32_t wireType) {
+    writeVarint(out, (static_cast<uint64_t>(id) << 3) | wireType);
+}
+
+static uint64_t zigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+/**
+ * Appends a fixed width field, little endian like the rest of protobuf.
+ */
+static void writeFixed(std::string &out, uint64_t bits, size_t width) {
+    for (size_t i = 0; i < width; i++) {
+        out.push_back(static_cast<char>(bits >> (8 * i)));
+    }
+}
+
+static void writeFloat(std::string &out, uint32_t id, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeKey(out, id, WIRE_FIXED32);
+    writeFixed(out, bits, 4);
+}
+
+ProtoWriter::ProtoWriter(std::string &buffer) : out(buffer) {}
+
+void ProtoWriter::preVisit(int32_t, const std::string &, const std::string &) {}
+
+void ProtoWriter::postVisit() {}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, bool &value) {
+    writeKey(out, id, WIRE_VARINT);
+    writeVarint(out, value ? 1 : 0);
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, uint8_t &value) {
+    writeKey(out, id, WIRE_VARINT);
+    writeVarint(out, value);
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, int8_t &value) {
+    writeKey(out, id, WIRE_VARINT);
+    writeVarint(out, zigZag(value));
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, uint16_t &value) {
+    writeKey(out, id, WIRE_VARINT);
+    writeVarint(out, value);
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, int16_t &value) {
+    writeKey(out, id, WIRE_VARINT);
+    writeVarint(out, zigZag(value));
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, uint32_t &value) {
+    writeKey(out, id, WIRE_VARINT);
+    writeVarint(out, value);
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, int32_t &value) {
+    writeKey(out, id, WIRE_VARINT);
+    writeVarint(out, zigZag(value));
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, uint64_t &value) {
+    writeKey(out, id, WIRE_VARINT);
+    writeVarint(out, value);
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, int64_t &value) {
+    writeKey(out, id, WIRE_VARINT);
+    writeVarint(out, zigZag(value));
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, float &value) {
+    writeFloat(out, id, value);
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, double &value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeKey(out, id, WIRE_FIXED64);
+    writeFixed(out, bits, 8);
+}
+
+void ProtoWriter::visit(uint32_t id, const std::string &, const std::string &, std::string &value) {
+    writeKey(out, id, WIRE_LENGTH_DELIMITED);
+    writeVarint(out, value.length());
+    out.append(value);
+}
+
+PayloadStreamBuf::PayloadStreamBuf(const PayloadView &payload) {
+    // The get area is only ever read from, the const_cast is required by the std::streambuf interface.
+    char *begin = const_cast<char *>(payload.data);
+    setg(begin, begin, begin + payload.length);
+}
+
+/**
+ * Extracts the message ID and a view of the payload from a received datagram. Both the legacy hex header and the
+ * binary header are accepted, the format is detected from the first byte.
+ *
+ * @param data - received datagram, must outlive the returned payload view
+ * @return frame with the message ID (-1 if invalid) and a view of the message data
+ */
+Frame extractFrame(const std::string &data) {
+    Frame invalid = {-1, {data.data(), 0}};
+
+    if (!data.empty() && static_cast<uint8_t>(data[0]) == BINARY_FRAME_MAGIC) {
+        if (data.length() < BINARY_HEADER_SIZE || static_cast<uint8_t>(data[1]) != BINARY_FRAME_VERSION) {
+            return invalid;
+        }
+        const unsigned char *header = reinterpret_cast<const unsigned char *>(data.data());
+        uint16_t id = static_cast<uint16_t>((header[2] << 8) | header[3]);
+        uint32_t length = (static_cast<uint32_t>(header[4]) << 24) | (static_cast<uint32_t>(header[5]) << 16) |
+                          (static_cast<uint32_t>(header[6]) << 8) | static_cast<uint32_t>(header[7]);
+        if (data.length() - BINARY_HEADER_SIZE != length) {
+            return invalid;
+        }
+        return Frame{static_cast<int16_t>(id), {data.data() + BINARY_HEADER_SIZE, length}};
+    }
+
+    if (data.length() < LEGACY_HEADER_SIZE) return invalid;
+    uint32_t id, length;
+    if (!parseHex(data.data(), 4, id) || !parseHex(data.data() + 4, 6, length)) {
+        return invalid;
+    }
+    if (data.length() - LEGACY_HEADER_SIZE != length) {
+        return invalid;
+    }
+    return Frame{static_cast<int16_t>(id), {data.data() + LEGACY_HEADER_SIZE, length}};
+}
+
+/**
+ * Reads a protobuf varint.
+ *
+ * @param p - position to read from, moved past the varint
+ * @param end - end of the payload
+ * @param value - value read
+ * @return false if the payload ended in the middle of the varint
+ */
+static bool readVarint(const unsigned char *&p, const unsigned char *end, uint64_t &value) {
+    value = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Decodes a LeaderStatus straight from a payload view without going through cluon's FromProtoVisitor, which collects
+ * the fields into a map and builds strings for the field names on every message. LeaderStatus is decoded once per
+ * received datagram, this keeps the receive path free of heap allocations. Field numbers are the ones of LeaderStatus
+ * in messages.odvd, unknown fields are skipped so newer leaders can add fields.
+ *
+ * @param payload - encoded LeaderStatus
+ * @param status - receives the decoded message, fields missing from the payload are left at their defaults
+ * @return false if the payload is truncated or malformed
+ */
+bool decodeLeaderStatus(const PayloadView &payload, LeaderStatus &status) {
+    status = LeaderStatus();
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(payload.data);
+    const unsigned char *end = p + payload.length;
+
+    while (p < end) {
+        uint64_t key;
+        if (!readVarint(p, end, key)) {
+            return false;
+        }
+        uint32_t wireType = static_cast<uint32_t>(key & 0x7);
+        uint64_t field = key >> 3;
+
+        uint64_t value = 0;
+        if (wireType == WIRE_VARINT) {
+            if (!readVarint(p, end, value)) {
+                return false;
+            }
+        } else if (wireType == WIRE_FIXED32 || wireType == WIRE_FIXED64) {
+            size_t width = wireType == WIRE_FIXED32 ? 4 : 8;
+            if (static_cast<size_t>(end - p) < width) {
+                return false;
+            }
+            // Little endian on the wire.
+            for (size_t i = width; i > 0; i--) {
+                value = (value << 8) | p[i - 1];
+            }
+            p += width;
+        } else if (wireType == WIRE_LENGTH_DELIMITED) {
+            if (!readVarint(p, end, value) || value > static_cast<uint64_t>(end - p)) {
+                return false;
+            }
+            p += value;
+            continue;
+        } else {
+            return false;
+        }
+
+        if (wireType == WIRE_FIXED32 && (field == 2 || field == 3)) {
+            uint32_t bits = static_cast<uint32_t>(value);
+            float decoded;
+            std::memcpy(&decoded, &bits, sizeof(decoded));
+            if (field == 2) {
+                status.speed(decoded);
+            } else {
+                status.steeringAngle(decoded);
+            }
+        } else if (wireType == WIRE_VARINT) {
+            switch (field) {
+                case 1: status.timestamp(value); break;
+                case 4: status.distanceTraveled(static_cast<uint8_t>(value)); break;
+                case 5: status.timestampMicros(value); break;
+                case 6: status.echoSentMicros(value); break;
+                case 7: status.echoReceivedMicros(value); break;
+                case 8: status.sequence(static_cast<uint32_t>(value)); break;
+                default: break;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Encodes a LeaderStatus without going through a visitor, the counterpart of decodeLeaderStatus. Writes the same bytes
+ * as cluon's ToProtoVisitor, field by field in the order of messages.odvd.
+ *
+ * @param status - message to encode
+ * @param out - buffer the payload is appended to
+ */
+void encodeLeaderStatus(const LeaderStatus &status, std::string &out) {
+    encodeLeaderStatusShared(status, out);
+    encodeLeaderStatusTail(status, out);
+}
+
+/**
+ * Encodes the fields of a LeaderStatus that are the same for every follower, everything up to the echo.
+ *
+ * @param status - message to encode
+ * @param out - buffer the fields are appended to
+ */
+void encodeLeaderStatusShared(const LeaderStatus &status, std::string &out) {
+    writeKey(out, 1, WIRE_VARINT);
+    writeVarint(out, status.timestamp());
+    writeFloat(out, 2, status.speed());
+    writeFloat(out, 3, status.steeringAngle());
+    writeKey(out, 4, WIRE_VARINT);
+    writeVarint(out, status.distanceTraveled());
+    writeKey(out, 5, WIRE_VARINT);
+    writeVarint(out, status.timestampMicros());
+}
+
+/**
+ * Encodes the fields of a LeaderStatus after the shared ones: the echo, which differs between followers, and the
+ * sequence number, which comes last in messages.odvd. Appended to the shared fields they make up the complete payload.
+ *
+ * @param status - message to encode
+ * @param out - buffer the fields are appended to
+ */
+void encodeLeaderStatusTail(const LeaderStatus &status, std::string &out) {
+    writeKey(out, 6, WIRE_VARINT);
+    writeVarint(out, status.echoSentMicros());
+    writeKey(out, 7, WIRE_VARINT);
+    writeVarint(out, status.echoReceivedMicros());
+    writeKey(out, 8, WIRE_VARINT);
+    writeVarint(out, status.sequence());
+}
@@ -0,0 +1,180 @@
+#ifndef V2V_FRAMING_H
+#define V2V_FRAMING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+#include <string>
+
+#include "cluon/ToProtoVisitor.hpp"
+#include "cluon/FromProtoVisitor.hpp"
+
+#include "messages.hpp"
+
+/*
+ * Wire framing of the datagrams exchanged between cars on DEFAULT_PORT.
+ *
+ * LEGACY_HEX is the header agreed upon between all groups: a 4 character hex message ID, followed by a 6 character hex
+ * payload length and then the protobuf encoded message.
+ *
+ * BINARY replaces the ASCII header with a fixed 8 byte header:
+ *
+ *     | magic (0xB7) | version | message ID (uint16, big endian) | payload length (uint32, big endian) | payload |
+ *
+ * The magic byte can never start a legacy frame (those always start with an ASCII hex digit), which means a receiver
+ * can tell the two apart from the first byte and always accepts both. We only ever send binary frames to a peer that
+ * advertised support for them in its FollowRequest or FollowResponse, every other car gets the legacy header.
+ */
+enum class Framing : uint8_t {
+    LEGACY_HEX = 0,
+    BINARY = 1
+};
+
+static const size_t LEGACY_HEADER_SIZE = 10;
+static const size_t BINARY_HEADER_SIZE = 8;
+static const uint8_t BINARY_FRAME_MAGIC = 0xB7;
+static const uint8_t BINARY_FRAME_VERSION = 1;
+
+// Largest frame we preallocate room for, V2V messages are a few dozen bytes so this is never exceeded in practice.
+static const size_t MAX_FRAME_SIZE = 1024;
+
+/**
+ * Non-owning view of a payload inside a received datagram. Only valid for as long as the datagram it points into.
+ */
+struct PayloadView {
+    const char *data;
+    size_t length;
+};
+
+/**
+ * Result of extracting a frame. The ID is -1 if the datagram was not a valid frame of either format.
+ */
+struct Frame {
+    int16_t id;
+    PayloadView payload;
+};
+
+/**
+ * Visitor writing the protobuf encoding of a message straight into a caller owned buffer. Produces the same bytes as
+ * cluon's ToProtoVisitor, but without the stringstream and the copy of the encoded data that comes with it, so a
+ * reused buffer is all that is needed to encode a message. Covers the field types used in messages.odvd.
+ */
+class ProtoWriter {
+public:
+    explicit ProtoWriter(std::string &out);
+
+    void preVisit(int32_t id, const std::string &shortName, const std::string &longName);
+    void postVisit();
+
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, bool &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, uint8_t &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, int8_t &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, uint16_t &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, int16_t &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, uint32_t &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, int32_t &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, uint64_t &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, int64_t &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, float &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, double &value);
+    void visit(uint32_t id, const std::string &typeName, const std::string &name, std::string &value);
+
+private:
+    std::string &out;
+};
+
+/**
+ * Stream buffer reading directly from a PayloadView, used to hand a payload to cluon's FromProtoVisitor without first
+ * copying it into a std::string.
+ */
+class PayloadStreamBuf : public std::streambuf {
+public:
+    explicit PayloadStreamBuf(const PayloadView &payload);
+};
+
+Frame extractFrame(const std::string &data);
+void writeFrameHeader(Framing framing, uint16_t id, std::string &frame);
+bool decodeLeaderStatus(const PayloadView &payload, LeaderStatus &status);
+void encodeLeaderStatus(const LeaderStatus &status, std::string &out);
+void encodeLeaderStatusShared(const LeaderStatus &status, std::string &out);
+void encodeLeaderStatusTail(const LeaderStatus &status, std::string &out);
+
+/**
+ * Encodes a message as protobuf, appending it to the given buffer.
+ *
+ * @tparam T - generic message type
+ * @param msg - message to encode
+ * @param out - buffer to append to
+ */
+template <class T>
+void encodePayload(T &msg, std::string &out) {
+    ProtoWriter writer(out);
+    msg.accept(writer);
+}
+
+/**
+ * LeaderStatus is sent eight times a second to every follower, it skips the visitor since cluon's generated accept
+ * builds strings for the longer field names on every call.
+ */
+inline void encodePayload(LeaderStatus &msg, std::string &out) {
+    encodeLeaderStatus(msg, out);
+}
+
+/**
+ * Encodes a message and frames it into the given buffer, replacing what it held. Once the buffer has grown to
+ * MAX_FRAME_SIZE encoding does not allocate anymore, apart from what cluon's accept allocates for the message.
+ *
+ * @tparam T - generic message type
+ * @param msg - message to encode
+ * @param framing - header format to use
+ * @param out - buffer to encode into
+ * @return out
+ */
+template <class T>
+std::string &encodeFrameInto(T &msg, Framing framing, std::string &out) {
+    out.clear();
+    // Reserving is a no-op unless the buffer was moved from by the previous send.
+    out.reserve(MAX_FRAME_SIZE);
+    out.append(framing == Framing::BINARY ? BINARY_HEADER_SIZE : LEGACY_HEADER_SIZE, '\0');
+    encodePayload(msg, out);
+    writeFrameHeader(framing, static_cast<uint16_t>(msg.ID()), out);
+    return out;
+}
+
+/**
+ * Encodes a message and frames it using the given framing. The returned string is the calling thread's frame buffer,
+ * it is overwritten by the next call to encodeFrame from the same thread. Handing it to UDPSender::send with std::move
+ * gives its storage away, so the next call allocates it again: one allocation per send. That is only for tools that
+ * send now and then, the service sends through SendPool, which encodes into buffers it keeps, see encodeFrameInto.
+ *
+ * @tparam T - generic message type
+ * @param msg - message to encode
+ * @param framing - header format to use
+ * @return encoded message
+ */
+template <class T>
+std::string &encodeFrame(T &msg, Framing framing) {
+    thread_local std::string frameBuffer;
+    return encodeFrameInto(msg, framing, frameBuffer);
+}
+
+/**
+ * Decodes a message directly from a payload view.
+ *
+ * @tparam T - generic message type
+ * @param payload - encoded message data
+ * @return decoded message
+ */
+template <class T>
+T decodePayload(const PayloadView &payload) {
+    PayloadStreamBuf streamBuf(payload);
+    std::istream buff(&streamBuf);
+    cluon::FromProtoVisitor v;
+    v.decodeFrom(buff);
+    T tmp = T();
+    tmp.accept(v);
+    return tmp;
+}
+
+#endif // V2V_FRAMING_H
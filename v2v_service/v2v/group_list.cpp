@@ -0,0 +1,120 @@
+#include "group_list.hpp"
+
+#include <cstdlib>
+
+/**
+ * Implementation of the group list packing and the GroupListAssembler class as declared in group_list.hpp
+ */
+
+static const char FIELD_SEPARATOR = ',';
+static const char LINE_SEPARATOR = '\n';
+
+/**
+ * Splits a list of cars into InternalGetAllGroupsBatch pages, see messages.odvd for the format. Cars whose group id
+ * or IP contain a separator cannot be listed and are left out.
+ *
+ * @param groups - cars to list
+ * @param batchId - id shared by the pages of this response
+ * @param pageBytes - upper bound for the packed groups of one page, a single car longer than this gets a page of its own
+ * @return pages to send, at least one
+ */
+std::vector<InternalGetAllGroupsBatch> packGroupList(const std::vector<GroupListEntry> &groups, uint32_t batchId,
+                                                     size_t pageBytes) {
+    std::vector<std::string> packed(1);
+    uint32_t total = 0;
+    for (const GroupListEntry &group : groups) {
+        if (group.groupId.find_first_of(",\n") != std::string::npos ||
+            group.ip.find_first_of(",\n") != std::string::npos) {
+            continue;
+        }
+        std::string line = group.groupId + FIELD_SEPARATOR + group.ip + FIELD_SEPARATOR +
+                           std::to_string(group.ageMillis) + FIELD_SEPARATOR + std::to_string(group.capabilities) +
+                           LINE_SEPARATOR;
+        if (!packed.back().empty() && packed.back().size() + line.size() > pageBytes) {
+            packed.emplace_back();
+        }
+        packed.back() += line;
+        total++;
+    }
+
+    std::vector<InternalGetAllGroupsBatch> pages(packed.size());
+    for (size_t i = 0; i < packed.size(); i++) {
+        pages[i].batchId(batchId);
+        pages[i].page((uint16_t) i);
+        pages[i].pageCount((uint16_t) packed.size());
+        pages[i].total(total);
+        pages[i].groups(packed[i]);
+    }
+    return pages;
+}
+
+/**
+ * Appends the cars of one page to a list.
+ *
+ * @param packed - groups field of an InternalGetAllGroupsBatch
+ * @param groups - list to append to
+ * @return false if a line was malformed, the cars before it are kept
+ */
+bool unpackGroupList(const std::string &packed, std::vector<GroupListEntry> &groups) {
+    size_t start = 0;
+    while (start < packed.size()) {
+        size_t end = packed.find(LINE_SEPARATOR, start);
+        if (end == std::string::npos) {
+            return false;
+        }
+        size_t ip = packed.find(FIELD_SEPARATOR, start);
+        size_t age = ip < end ? packed.find(FIELD_SEPARATOR, ip + 1) : std::string::npos;
+        size_t capabilities = age < end ? packed.find(FIELD_SEPARATOR, age + 1) : std::string::npos;
+        if (capabilities >= end) {
+            return false;
+        }
+
+        GroupListEntry group;
+        group.groupId = packed.substr(start, ip - start);
+        group.ip = packed.substr(ip + 1, age - ip - 1);
+        group.ageMillis = (uint32_t) std::strtoul(packed.c_str() + age + 1, nullptr, 10);
+        group.capabilities = (uint32_t) std::strtoul(packed.c_str() + capabilities + 1, nullptr, 10);
+        groups.push_back(group);
+        start = end + 1;
+    }
+    return true;
+}
+
+GroupListAssembler::GroupListAssembler() : batchId(0), missing(0) {}
+
+/**
+ * @param page - received page
+ * @return true if the page completed its batch, the cars are then available from groups()
+ */
+bool GroupListAssembler::add(const InternalGetAllGroupsBatch &page) {
+    if (page.pageCount() == 0 || page.page() >= page.pageCount()) {
+        return false;
+    }
+    if (pages.empty() || page.batchId() != batchId || page.pageCount() != pages.size()) {
+        batchId = page.batchId();
+        pages.assign(page.pageCount(), std::string());
+        received.assign(page.pageCount(), false);
+        missing = page.pageCount();
+    }
+    if (received[page.page()]) {
+        return false;
+    }
+    received[page.page()] = true;
+    pages[page.page()] = page.groups();
+    if (--missing > 0) {
+        return false;
+    }
+
+    complete.clear();
+    for (const std::string &packed : pages) {
+        unpackGroupList(packed, complete);
+    }
+    return true;
+}
+
+/**
+ * @return cars of the last completed batch
+ */
+const std::vector<GroupListEntry> &GroupListAssembler::groups() const {
+    return complete;
+}
@@ -0,0 +1,49 @@
+#ifndef V2V_GROUP_LIST_H
+#define V2V_GROUP_LIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "messages.hpp"
+
+// Upper bound for the packed groups of one InternalGetAllGroupsBatch page, which keeps every page in one datagram
+// below the Ethernet MTU together with the OD4 envelope.
+static const size_t GROUP_LIST_PAGE_BYTES = 1200;
+
+/**
+ * A car as listed in an InternalGetAllGroupsBatch.
+ */
+struct GroupListEntry {
+    std::string groupId;
+    std::string ip;
+    // Time since the car last announced itself.
+    uint32_t ageMillis;
+    uint32_t capabilities;
+};
+
+std::vector<InternalGetAllGroupsBatch> packGroupList(const std::vector<GroupListEntry> &groups, uint32_t batchId,
+                                                     size_t pageBytes = GROUP_LIST_PAGE_BYTES);
+bool unpackGroupList(const std::string &packed, std::vector<GroupListEntry> &groups);
+
+/**
+ * Puts the pages of a batched get all groups response back together on the requesting side. Pages may arrive in any
+ * order. A page of a newer batch drops whatever was collected of the previous one.
+ */
+class GroupListAssembler {
+public:
+    GroupListAssembler();
+
+    bool add(const InternalGetAllGroupsBatch &page);
+    const std::vector<GroupListEntry> &groups() const;
+
+private:
+    uint32_t batchId;
+    std::vector<std::string> pages;
+    std::vector<bool> received;
+    size_t missing;
+    std::vector<GroupListEntry> complete;
+};
+
+#endif // V2V_GROUP_LIST_H
@@ -0,0 +1,108 @@
+#include <iomanip>
+#include <limits>
+
+#include "histogram.hpp"
+
+/**
+ * Implementation of the LatencyHistogram class as declared in histogram.hpp
+ */
+
+// Upper bounds (inclusive) of the buckets in microseconds, the last bucket takes everything above.
+static const int64_t UPPER_BOUNDS[LatencyHistogram::BUCKETS] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, std::numeric_limits<int64_t>::max()
+};
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+/**
+ * Records one duration. Negative durations are counted as zero.
+ *
+ * @param micros - duration in microseconds
+ */
+void LatencyHistogram::record(int64_t micros) {
+    if (micros < 0) micros = 0;
+
+    size_t bucket = 0;
+    while (micros > UPPER_BOUNDS[bucket]) {
+        bucket++;
+    }
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(micros, std::memory_order_relaxed);
+
+    int64_t currentMax = max.load(std::memory_order_relaxed);
+    while (micros > currentMax && !max.compare_exchange_weak(currentMax, micros, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (size_t i = 0; i < BUCKETS; i++) {
+        buckets[i].store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    return total.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::bucketCount(size_t bucket) const {
+    return buckets[bucket].load(std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::maxMicros() const {
+    return max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::meanMicros() const {
+    uint64_t n = count();
+    return n == 0 ? 0.0 : sum.load(std::memory_order_relaxed) / (double) n;
+}
+
+int64_t LatencyHistogram::percentileMicros(double percentile) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+
+    uint64_t rank = (uint64_t) (n * percentile / 100.0);
+    if (rank >= n) rank = n - 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += bucketCount(i);
+        if (seen > rank) {
+            // The last bucket is open ended, the largest recorded value is the best upper estimate there.
+            return i == BUCKETS - 1 ? maxMicros() : UPPER_BOUNDS[i];
+        }
+    }
+    return maxMicros();
+}
+
+int64_t LatencyHistogram::bucketUpperBound(size_t bucket) {
+    return UPPER_BOUNDS[bucket];
+}
+
+/**
+ * Prints the non-empty buckets together with count, mean and max.
+ */
+void LatencyHistogram::print(std::ostream &out, const std::string &title) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << title << " : " << count() << " samples, mean " << std::fixed << std::setprecision(0) << meanMicros()
+        << " us, max " << maxMicros() << " us" << std::endl;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        uint64_t n = bucketCount(i);
+        if (n == 0) continue;
+        if (i == BUCKETS - 1) {
+            out << "    > " << std::setw(8) << UPPER_BOUNDS[i - 1] << " us : " << n << std::endl;
+        } else {
+            out << "    <= " << std::setw(7) << UPPER_BOUNDS[i] << " us : " << n << std::endl;
+        }
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
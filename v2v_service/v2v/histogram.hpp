@@ -0,0 +1,42 @@
+#ifndef V2V_HISTOGRAM_H
+#define V2V_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * Fixed bucket histogram of durations in microseconds. Recording is lock-free so it can be done from a timing
+ * critical thread while another thread prints or reads the histogram.
+ */
+class LatencyHistogram {
+public:
+    static const size_t BUCKETS = 12;
+
+    LatencyHistogram();
+
+    void record(int64_t micros);
+    void reset();
+
+    uint64_t count() const;
+    uint64_t bucketCount(size_t bucket) const;
+    int64_t maxMicros() const;
+    double meanMicros() const;
+
+    // Upper bound of the bucket containing the given percentile (0 - 100), an upper estimate of the real value.
+    int64_t percentileMicros(double percentile) const;
+
+    static int64_t bucketUpperBound(size_t bucket);
+
+    void print(std::ostream &out, const std::string &title) const;
+
+private:
+    std::atomic<uint64_t> buckets[BUCKETS];
+    std::atomic<uint64_t> total;
+    std::atomic<int64_t> sum;
+    std::atomic<int64_t> max;
+};
+
+#endif // V2V_HISTOGRAM_H
@@ -0,0 +1,233 @@
+#include "liveness_tracker.hpp"
+
+/**
+ * Implementation of the LivenessTracker class as declared in liveness_tracker.hpp
+ */
+
+/**
+ * Constructor for the liveness tracker.
+ *
+ * @param resolution - length of a wheel tick, losses are reported at most this long after the deadline
+ * @param timeSource - clock the functions without a time argument use
+ */
+LivenessTracker::LivenessTracker(std::chrono::milliseconds resolution, const TimeSource &timeSource) :
+    timeSource(timeSource),
+    tickLength(resolution.count() > 0 ? resolution : std::chrono::milliseconds(1)),
+    origin(timeSource.now()),
+    wheel(LIVENESS_WHEEL_SLOTS),
+    processedTick(0),
+    nextGeneration(1) {
+}
+
+void LivenessTracker::watch(const std::string &peer, std::chrono::milliseconds timeout,
+                            std::chrono::milliseconds expectedInterval, LossCallback onLoss) {
+    watch(peer, timeout, expectedInterval, std::move(onLoss), timeSource.now());
+}
+
+/**
+ * Starts watching a peer, replacing an earlier watch of the same peer. The peer counts as heard from right now.
+ *
+ * @param peer - name of the peer
+ * @param timeout - silence after which the peer is lost
+ * @param expectedInterval - interval the peer sends at, used to estimate the loss rate
+ * @param onLoss - called once when the peer is lost
+ * @param now - current time
+ */
+void LivenessTracker::watch(const std::string &peer, std::chrono::milliseconds timeout,
+                            std::chrono::milliseconds expectedInterval, LossCallback onLoss, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Peer &watched = peers[peer];
+    watched.timeout = timeout;
+    watched.expectedInterval = expectedInterval;
+    watched.onLoss = std::move(onLoss);
+    watched.lastHeard = now;
+    watched.deadline = now + timeout;
+    watched.generation = nextGeneration++;
+    watched.received = 0;
+    watched.missed = 0;
+    watched.lastRttMicros = -1;
+    watched.meanRttMicros = -1;
+
+    insert(peer, watched.generation, watched.deadline);
+}
+
+/**
+ * Stops watching a peer without reporting it as lost.
+ *
+ * @param peer - name of the peer
+ * @return false if the peer was not watched
+ */
+bool LivenessTracker::forget(const std::string &peer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // The wheel entry stays behind and is dropped when its slot comes up.
+    return peers.erase(peer) > 0;
+}
+
+void LivenessTracker::heard(const std::string &peer) {
+    heard(peer, timeSource.now());
+}
+
+/**
+ * Records a message from a peer, which pushes its deadline back by the timeout.
+ *
+ * @param peer - name of the peer, ignored if it is not watched
+ * @param now - time the message was received
+ */
+void LivenessTracker::heard(const std::string &peer, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<std::string, Peer>::iterator it = peers.find(peer);
+    if (it == peers.end()) {
+        return;
+    }
+    Peer &watched = it->second;
+
+    // A gap of n intervals means n - 1 messages went missing, anything under one and a half intervals is jitter.
+    if (watched.received > 0 && watched.expectedInterval.count() > 0) {
+        Clock::duration gap = now - watched.lastHeard;
+        Clock::duration interval = watched.expectedInterval;
+        if (gap > interval + interval / 2) {
+            watched.missed += (uint64_t) ((gap + interval / 2) / interval) - 1;
+        }
+    }
+    watched.received++;
+    watched.lastHeard = now;
+    watched.deadline = now + watched.timeout;
+}
+
+/**
+ * Records a round trip time measured to a peer.
+ *
+ * @param peer - name of the peer, ignored if it is not watched
+ * @param rtt - measured round trip time
+ */
+void LivenessTracker::recordRtt(const std::string &peer, std::chrono::microseconds rtt) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<std::string, Peer>::iterator it = peers.find(peer);
+    if (it == peers.end()) {
+        return;
+    }
+    Peer &watched = it->second;
+    watched.lastRttMicros = rtt.count();
+    watched.meanRttMicros = watched.meanRttMicros < 0 ? rtt.count() :
+                            watched.meanRttMicros + (rtt.count() - watched.meanRttMicros) / 8;
+}
+
+size_t LivenessTracker::tick() {
+    return tick(timeSource.now());
+}
+
+/**
+ * Advances the wheel to the given time and reports every peer whose deadline has passed.
+ *
+ * @param now - current time
+ * @return number of peers reported as lost
+ */
+size_t LivenessTracker::tick(Clock::time_point now) {
+    std::vector<std::pair<std::string, LossCallback>> lost;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Up to the tick at or after now, entries in it that are not due yet go to the next tick. That way the first
+        // call after a deadline reports it, instead of the first call after the tick the deadline was rounded up to.
+        uint64_t target = tickOf(now);
+
+        // After a long pause every slot is due once, visiting them more often would not find anything new.
+        if (target > processedTick + LIVENESS_WHEEL_SLOTS) {
+            processedTick = target - LIVENESS_WHEEL_SLOTS;
+        }
+
+        while (processedTick < target) {
+            processedTick++;
+            std::vector<std::pair<std::string, uint64_t>> entries;
+            entries.swap(wheel[processedTick % LIVENESS_WHEEL_SLOTS]);
+
+            for (size_t i = 0; i < entries.size(); i++) {
+                std::unordered_map<std::string, Peer>::iterator it = peers.find(entries[i].first);
+                if (it == peers.end() || it->second.generation != entries[i].second) {
+                    continue; // Forgotten or watched again since.
+                }
+                if (it->second.deadline <= now) {
+                    lost.push_back(std::make_pair(it->first, std::move(it->second.onLoss)));
+                    peers.erase(it);
+                } else {
+                    insert(entries[i].first, entries[i].second, it->second.deadline);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < lost.size(); i++) {
+        if (lost[i].second) {
+            lost[i].second(lost[i].first);
+        }
+    }
+    return lost.size();
+}
+
+bool LivenessTracker::metrics(const std::string &peer, PeerMetrics &out) {
+    return metrics(peer, out, timeSource.now());
+}
+
+/**
+ * @param peer - name of the peer
+ * @param out - receives the metrics of the peer
+ * @param now - current time, to compute how long the peer has been silent
+ * @return false if the peer is not watched
+ */
+bool LivenessTracker::metrics(const std::string &peer, PeerMetrics &out, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<std::string, Peer>::iterator it = peers.find(peer);
+    if (it == peers.end()) {
+        return false;
+    }
+    const Peer &watched = it->second;
+    out.received = watched.received;
+    out.missed = watched.missed;
+    out.lossRate = watched.received + watched.missed == 0 ? 0.0f :
+                   (float) watched.missed / (float) (watched.received + watched.missed);
+    out.lastRttMicros = watched.lastRttMicros;
+    out.meanRttMicros = watched.meanRttMicros;
+    out.silence = std::chrono::duration_cast<std::chrono::milliseconds>(now - watched.lastHeard);
+    return true;
+}
+
+std::vector<std::string> LivenessTracker::watchedPeers() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> names;
+    for (std::unordered_map<std::string, Peer>::iterator it = peers.begin(); it != peers.end(); ++it) {
+        names.push_back(it->first);
+    }
+    return names;
+}
+
+std::chrono::milliseconds LivenessTracker::resolution() const {
+    return tickLength;
+}
+
+/**
+ * @param time - point in time
+ * @return number of the first tick at or after the time
+ */
+uint64_t LivenessTracker::tickOf(Clock::time_point time) const {
+    if (time <= origin) {
+        return 0;
+    }
+    Clock::duration sinceOrigin = time - origin;
+    Clock::duration length = tickLength;
+    uint64_t ticks = (uint64_t) (sinceOrigin / length);
+    if (sinceOrigin % length != Clock::duration::zero()) {
+        ticks++;
+    }
+    return ticks;
+}
+
+/**
+ * Puts a wheel entry into the slot of the first tick at or after the deadline, at the earliest the next tick to be
+ * processed. Called with the lock held.
+ */
+void LivenessTracker::insert(const std::string &peer, uint64_t generation, Clock::time_point deadline) {
+    uint64_t due = tickOf(deadline);
+    if (due <= processedTick) {
+        due = processedTick + 1;
+    }
+    wheel[due % LIVENESS_WHEEL_SLOTS].push_back(std::make_pair(peer, generation));
+}
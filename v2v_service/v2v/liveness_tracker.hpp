@@ -0,0 +1,103 @@
+#ifndef V2V_LIVENESS_TRACKER_H
+#define V2V_LIVENESS_TRACKER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "time_source.hpp"
+
+// Number of slots in the timer wheel, the wheel turns once every LIVENESS_WHEEL_SLOTS ticks.
+static const size_t LIVENESS_WHEEL_SLOTS = 256;
+
+/**
+ * Link quality of a watched peer.
+ */
+struct PeerMetrics {
+    uint64_t received;
+    // Messages estimated to be lost from the gaps between received ones.
+    uint64_t missed;
+    float lossRate;
+    // Round trip times in microseconds, -1 until one has been measured. The mean is smoothed like TCP's SRTT.
+    int64_t lastRttMicros;
+    int64_t meanRttMicros;
+    std::chrono::milliseconds silence;
+};
+
+/**
+ * Detects peers that went silent with a hashed timer wheel.
+ *
+ * Every watched peer has a deadline, its timeout after the last message heard from it. Hearing from a peer only moves
+ * the deadline in its record, the wheel is not touched on the receive path. Each peer has a single entry in the wheel,
+ * in the slot of the tick its deadline was at when the entry was made. When that slot comes up, a peer whose deadline
+ * moved on is put back into the slot of its current deadline, and a peer whose deadline has passed is dropped and its
+ * loss callback fired. Ticking once per resolution therefore reports a loss at most one resolution after the deadline.
+ *
+ * Besides liveness the tracker keeps per peer metrics, a loss rate estimated from the gaps between messages that are
+ * expected at a fixed interval, and round trip times measured by the caller.
+ *
+ * Functions without a time argument take the current time from the tracker's TimeSource. All functions may be called
+ * from any thread. Loss callbacks run on the thread calling tick, without any lock held,
+ * so they may watch and forget peers.
+ */
+class LivenessTracker {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<void(const std::string &peer)> LossCallback;
+
+    explicit LivenessTracker(std::chrono::milliseconds resolution,
+                             const TimeSource &timeSource = TimeSource::system());
+
+    void watch(const std::string &peer, std::chrono::milliseconds timeout, std::chrono::milliseconds expectedInterval,
+               LossCallback onLoss);
+    void watch(const std::string &peer, std::chrono::milliseconds timeout, std::chrono::milliseconds expectedInterval,
+               LossCallback onLoss, Clock::time_point now);
+    bool forget(const std::string &peer);
+    void heard(const std::string &peer);
+    void heard(const std::string &peer, Clock::time_point now);
+    void recordRtt(const std::string &peer, std::chrono::microseconds rtt);
+
+    size_t tick();
+    size_t tick(Clock::time_point now);
+
+    bool metrics(const std::string &peer, PeerMetrics &out);
+    bool metrics(const std::string &peer, PeerMetrics &out, Clock::time_point now);
+    std::vector<std::string> watchedPeers();
+    std::chrono::milliseconds resolution() const;
+
+private:
+    struct Peer {
+        std::chrono::milliseconds timeout;
+        std::chrono::milliseconds expectedInterval;
+        LossCallback onLoss;
+        Clock::time_point lastHeard;
+        Clock::time_point deadline;
+        // Tells the wheel entry of this watch apart from ones left over by an earlier watch of the same peer.
+        uint64_t generation;
+
+        uint64_t received;
+        uint64_t missed;
+        int64_t lastRttMicros;
+        int64_t meanRttMicros;
+    };
+
+    uint64_t tickOf(Clock::time_point time) const;
+    void insert(const std::string &peer, uint64_t generation, Clock::time_point deadline);
+
+    const TimeSource &timeSource;
+    const std::chrono::milliseconds tickLength;
+    const Clock::time_point origin;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Peer> peers;
+    std::vector<std::vector<std::pair<std::string, uint64_t>>> wheel;
+    uint64_t processedTick;
+    uint64_t nextGeneration;
+};
+
+#endif // V2V_LIVENESS_TRACKER_H
@@ -0,0 +1,199 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#include "log.hpp"
+
+/**
+ * Implementation of the Logger, LogRateLimiter and LogLine classes as declared in log.hpp
+ */
+
+/**
+ * @return the logger of the process, its background thread is started on first use
+ */
+Logger &Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : reportedDrops(0), output(&std::cout), stopping(false) {
+    thread = std::thread(&Logger::run, this);
+}
+
+/**
+ * Stops the background thread and writes out whatever is still waiting.
+ */
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wakeUpMutex);
+        stopping = true;
+        wakeUp.notify_all();
+    }
+    thread.join();
+    drain();
+}
+
+/**
+ * Queues a line for the background thread, never blocks.
+ *
+ * @param entry - line to write
+ * @return false if the ring was full and the line was dropped
+ */
+bool Logger::submit(const LogEntry &entry) {
+    return ring.push(entry);
+}
+
+/**
+ * Writes out every line queued so far on the calling thread.
+ */
+void Logger::flush() {
+    drain();
+}
+
+/**
+ * Sends the log somewhere else than std::cout.
+ *
+ * @param stream - stream to write to from now on, has to outlive the logger or the next call
+ */
+void Logger::setOutput(std::ostream &stream) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    output->flush();
+    output = &stream;
+}
+
+/**
+ * @return number of lines dropped because the ring was full
+ */
+uint64_t Logger::dropped() const {
+    return ring.overflows();
+}
+
+/**
+ * Body of the background thread.
+ */
+void Logger::run() {
+    std::unique_lock<std::mutex> lock(wakeUpMutex);
+    while (!stopping) {
+        wakeUp.wait_for(lock, LOG_DRAIN_INTERVAL);
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+/**
+ * Writes out the queued lines and flushes the output once for all of them.
+ *
+ * @return number of lines written, including the note about dropped lines
+ */
+size_t Logger::drain() {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    size_t written = 0;
+    LogEntry entry;
+    while (ring.pop(entry)) {
+        output->write(entry.text, entry.length);
+        output->put('\n');
+        written++;
+    }
+
+    uint64_t drops = ring.overflows();
+    if (drops != reportedDrops) {
+        *output << "[LOG] " << (drops - reportedDrops) << " lines dropped" << '\n';
+        reportedDrops = drops;
+        written++;
+    }
+    if (written > 0) {
+        output->flush();
+    }
+    return written;
+}
+
+/**
+ * Constructor for the rate limiter.
+ *
+ * @param interval - shortest time between two lines
+ */
+LogRateLimiter::LogRateLimiter(std::chrono::milliseconds interval) :
+    interval(interval), nextAllowed(std::numeric_limits<int64_t>::min()), suppressed(0) {
+}
+
+/**
+ * @param now - current time
+ * @return -1 if the line has to be suppressed, otherwise the number of lines suppressed since the last one
+ */
+int64_t LogRateLimiter::allow(std::chrono::steady_clock::time_point now) {
+    int64_t ticks = now.time_since_epoch().count();
+    int64_t next = nextAllowed.load(std::memory_order_relaxed);
+    if (ticks < next ||
+        !nextAllowed.compare_exchange_strong(next, ticks + interval.count(), std::memory_order_relaxed)) {
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+    return suppressed.exchange(0, std::memory_order_relaxed);
+}
+
+/**
+ * Constructor for a log line.
+ *
+ * @param level - level of the line
+ * @param suppressed - lines suppressed by the rate limit of the statement since its previous line
+ */
+LogLine::LogLine(LogLevel level, int64_t suppressed) : suppressed(suppressed) {
+    entry.level = level;
+    entry.length = 0;
+}
+
+/**
+ * Hands the finished line to the logger.
+ */
+LogLine::~LogLine() {
+    if (suppressed > 0) {
+        *this << " (" << suppressed << " similar lines suppressed)";
+    }
+    Logger::instance().submit(entry);
+}
+
+LogLine &LogLine::operator<<(const char *text) {
+    return append(text, std::strlen(text));
+}
+
+LogLine &LogLine::operator<<(const std::string &text) {
+    return append(text.data(), text.size());
+}
+
+LogLine &LogLine::operator<<(char character) {
+    return append(&character, 1);
+}
+
+LogLine &LogLine::operator<<(bool value) {
+    return append(value ? "1" : "0", 1);
+}
+
+LogLine &LogLine::operator<<(double value) {
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%g", value);
+    return append(buffer, length > 0 ? (size_t) length : 0);
+}
+
+LogLine &LogLine::append(const char *text, size_t length) {
+    size_t room = LOG_LINE_SIZE - entry.length;
+    if (length > room) {
+        length = room;
+    }
+    std::memcpy(entry.text + entry.length, text, length);
+    entry.length += (uint16_t) length;
+    return *this;
+}
+
+LogLine &LogLine::appendSigned(long long value) {
+    char buffer[24];
+    int length = std::snprintf(buffer, sizeof(buffer), "%lld", value);
+    return append(buffer, (size_t) length);
+}
+
+LogLine &LogLine::appendUnsigned(unsigned long long value) {
+    char buffer[24];
+    int length = std::snprintf(buffer, sizeof(buffer), "%llu", value);
+    return append(buffer, (size_t) length);
+}
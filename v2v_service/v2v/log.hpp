@@ -0,0 +1,163 @@
+#ifndef V2V_LOG_H
+#define V2V_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "mpmc_queue.hpp"
+
+/*
+ * Lowest level that is compiled in, 0 = debug, 1 = info, 2 = warning, 3 = error. Statements below it compile to
+ * nothing, their arguments are not even evaluated.
+ */
+#ifndef V2V_LOG_LEVEL
+#define V2V_LOG_LEVEL 1
+#endif
+
+enum class LogLevel : uint8_t {
+    LOG_DEBUG = 0,
+    LOG_INFO = 1,
+    LOG_WARNING = 2,
+    LOG_ERROR = 3
+};
+
+// Longest line kept, longer lines are cut off.
+static const size_t LOG_LINE_SIZE = 160;
+
+// Lines that can wait for the background thread before new ones are dropped.
+static const size_t LOG_RING_SIZE = 512;
+
+// How often the background thread writes out waiting lines.
+static const std::chrono::milliseconds LOG_DRAIN_INTERVAL(20);
+
+struct LogEntry {
+    LogLevel level;
+    uint16_t length;
+    char text[LOG_LINE_SIZE];
+};
+
+/**
+ * Writes log lines from a lock-free in-memory ring on a background thread, so logging threads never wait for the
+ * terminal. Lines that do not fit in the ring are dropped and counted.
+ */
+class Logger {
+public:
+    static Logger &instance();
+
+    ~Logger();
+
+    bool submit(const LogEntry &entry);
+    void flush();
+    void setOutput(std::ostream &stream);
+
+    uint64_t dropped() const;
+
+private:
+    Logger();
+
+    void run();
+    size_t drain();
+
+    MpmcQueue<LogEntry, LOG_RING_SIZE> ring;
+    uint64_t reportedDrops;
+
+    // Serialises writing to the output between the background thread and flush.
+    std::mutex outputMutex;
+    std::ostream *output;
+
+    std::mutex wakeUpMutex;
+    std::condition_variable wakeUp;
+    bool stopping;
+    std::thread thread;
+};
+
+/**
+ * Limits a log statement to one line per interval, counting the lines it suppressed in between.
+ */
+class LogRateLimiter {
+public:
+    explicit LogRateLimiter(std::chrono::milliseconds interval);
+
+    int64_t allow(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+private:
+    const std::chrono::steady_clock::duration interval;
+    std::atomic<int64_t> nextAllowed;
+    std::atomic<uint32_t> suppressed;
+};
+
+/**
+ * One log line, built on the stack with operator<< and handed to the Logger when it goes out of scope. Numbers are
+ * formatted like the default std::ostream formatting.
+ */
+class LogLine {
+public:
+    explicit LogLine(LogLevel level, int64_t suppressed = 0);
+    ~LogLine();
+
+    LogLine(const LogLine &) = delete;
+    LogLine &operator=(const LogLine &) = delete;
+
+    LogLine &operator<<(const char *text);
+    LogLine &operator<<(const std::string &text);
+    LogLine &operator<<(char character);
+    LogLine &operator<<(bool value);
+    LogLine &operator<<(double value);
+
+    template <class T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, LogLine &>::type
+    operator<<(T value) {
+        return appendSigned((long long) value);
+    }
+
+    template <class T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, LogLine &>::type
+    operator<<(T value) {
+        return appendUnsigned((unsigned long long) value);
+    }
+
+    LogLine &operator<<(float value) {
+        return *this << (double) value;
+    }
+
+private:
+    LogLine &append(const char *text, size_t length);
+    LogLine &appendSigned(long long value);
+    LogLine &appendUnsigned(unsigned long long value);
+
+    LogEntry entry;
+    int64_t suppressed;
+};
+
+// Turns the whole statement into void so V2V_LOG fits into the conditional operator.
+struct LogVoidify {
+    void operator&(const LogLine &) {}
+};
+
+#define V2V_LOG_IS_ON(logLevel) (static_cast<int>(logLevel) >= V2V_LOG_LEVEL)
+
+/*
+ * Usage: V2V_LOG(INFO) << "Received " << count << " updates";
+ */
+#define V2V_LOG(level) \
+    !V2V_LOG_IS_ON(LogLevel::LOG_##level) ? (void) 0 : LogVoidify() & LogLine(LogLevel::LOG_##level)
+
+/*
+ * Same as V2V_LOG, but logs at most once per interval in milliseconds from this statement. The next line that gets
+ * through tells how many were suppressed. Each statement has its own limiter, a function local static of the lambda.
+ */
+#define V2V_LOG_EVERY(level, intervalMs) \
+    for (int64_t v2vLogSuppressed = !V2V_LOG_IS_ON(LogLevel::LOG_##level) ? -1 : []() -> LogRateLimiter & { \
+             static LogRateLimiter limiter((std::chrono::milliseconds(intervalMs))); \
+             return limiter; \
+         }().allow(); v2vLogSuppressed >= 0; v2vLogSuppressed = -1) \
+        LogLine(LogLevel::LOG_##level, v2vLogSuppressed)
+
+#endif // V2V_LOG_H
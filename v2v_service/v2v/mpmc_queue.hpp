@@ -0,0 +1,121 @@
+#ifndef V2V_MPMC_QUEUE_H
+#define V2V_MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "spsc_queue.hpp"
+
+/**
+ * Bounded, lock-free queue for any number of producer and consumer threads.
+ *
+ * Every slot carries a sequence number telling whether it is free for the producer of a given lap around the queue or
+ * filled for the consumer of that lap, so producers and consumers only contend on the index they advance. Like
+ * SpscQueue, a push on a full queue is rejected and counted instead of blocking.
+ *
+ * @tparam T - element type, has to be default constructible and assignable
+ * @tparam Capacity - maximum number of elements, has to be a power of two
+ */
+template <class T, size_t Capacity>
+class MpmcQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MpmcQueue capacity must be a power of two");
+
+public:
+    MpmcQueue() : enqueuePosition(0), overflowCount(0), dequeuePosition(0) {
+        for (size_t i = 0; i < Capacity; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    /**
+     * Any thread. Appends an element to the queue.
+     *
+     * @param item - element to append
+     * @return false if the queue was full, the element is then dropped and counted as an overflow
+     */
+    bool push(const T &item) {
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[position & (Capacity - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                overflowCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->item = item;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Any thread. Removes the oldest element from the queue.
+     *
+     * @param item - receives the removed element
+     * @return false if the queue was empty
+     */
+    bool pop(T &item) {
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[position & (Capacity - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+            if (difference == 0) {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        item = std::move(slot->item);
+        slot->sequence.store(position + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+    // Number of pushes rejected because the queue was full.
+    uint64_t overflows() const {
+        return overflowCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    // Shared by the producers.
+    std::atomic<size_t> enqueuePosition;
+    std::atomic<uint64_t> overflowCount;
+    char enqueuePadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(std::atomic<uint64_t>)];
+
+    // Shared by the consumers.
+    std::atomic<size_t> dequeuePosition;
+    char dequeuePadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+    Slot slots[Capacity];
+};
+
+#endif // V2V_MPMC_QUEUE_H
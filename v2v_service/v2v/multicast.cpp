@@ -0,0 +1,129 @@
+#include "multicast.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "log.hpp"
+
+/**
+ * Implementation of the MulticastReceiver class as declared in multicast.hpp
+ */
+
+/**
+ * Every leader sends to a group of its own in the organisation local scope, 239.255.0.0/16, made up of the last two
+ * bytes of its IP. Cars on one network differ in those.
+ *
+ * @param leaderIp - IP of the leader
+ * @return the leader's group, empty if the IP is not a valid IPv4 address
+ */
+std::string multicastGroupFor(const std::string &leaderIp) {
+    in_addr address;
+    if (inet_pton(AF_INET, leaderIp.c_str(), &address) != 1) {
+        return "";
+    }
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&address.s_addr);
+    return "239.255." + std::to_string(bytes[2]) + "." + std::to_string(bytes[3]);
+}
+
+/**
+ * Constructor for the multicast receiver, joins the group and starts the receiver thread.
+ *
+ * @param group - multicast group to join
+ * @param port - port the group is sent to
+ * @param interfaceIp - address of the interface to join on
+ * @param delegate - called with every datagram received, its sender as "ip:port" and the time it was received
+ */
+MulticastReceiver::MulticastReceiver(const std::string &group, uint16_t port, const std::string &interfaceIp,
+                                     Delegate delegate) :
+    groupIp(group), onDatagram(std::move(delegate)), running(false) {
+    socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket < 0) {
+        V2V_LOG(WARNING) << "Could not open a socket for " << group << ": " << std::strerror(errno);
+        return;
+    }
+
+    // Followers on the same host share the port.
+    int reuse = 1;
+    ::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Bound to the group, so datagrams to other groups on the same port are not received.
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = inet_addr(group.c_str());
+
+    ip_mreq membership;
+    std::memset(&membership, 0, sizeof(membership));
+    membership.imr_multiaddr.s_addr = address.sin_addr.s_addr;
+    membership.imr_interface.s_addr = inet_addr(interfaceIp.c_str());
+
+    if (::bind(socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::setsockopt(socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+        V2V_LOG(WARNING) << "Could not join " << group << ":" << port << " on " << interfaceIp << ": "
+                         << std::strerror(errno);
+        ::close(socket);
+        socket = -1;
+        return;
+    }
+
+    running = true;
+    receiver = std::thread(&MulticastReceiver::receive, this);
+}
+
+/**
+ * Destructor for the multicast receiver, stops the receiver thread and leaves the group.
+ */
+MulticastReceiver::~MulticastReceiver() {
+    running = false;
+    if (receiver.joinable()) {
+        receiver.join();
+    }
+    if (socket >= 0) {
+        // Closing the socket leaves the group.
+        ::close(socket);
+    }
+}
+
+/**
+ * @return false if the group could not be joined
+ */
+bool MulticastReceiver::isRunning() const {
+    return running;
+}
+
+const std::string &MulticastReceiver::group() const {
+    return groupIp;
+}
+
+/**
+ * Body of the receiver thread.
+ */
+void MulticastReceiver::receive() {
+    char buffer[65536];
+    while (running) {
+        pollfd readable = {socket, POLLIN, 0};
+        if (::poll(&readable, 1, static_cast<int>(MULTICAST_POLL_INTERVAL.count())) <= 0) {
+            continue;
+        }
+
+        sockaddr_in from;
+        socklen_t fromLength = sizeof(from);
+        ssize_t length = ::recvfrom(socket, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr *>(&from),
+                                    &fromLength);
+        if (length < 0) {
+            continue;
+        }
+        char senderIp[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &from.sin_addr, senderIp, sizeof(senderIp));
+        onDatagram(std::string(buffer, static_cast<size_t>(length)),
+                   std::string(senderIp) + ":" + std::to_string(ntohs(from.sin_port)),
+                   std::chrono::system_clock::now());
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef V2V_MULTICAST_H
+#define V2V_MULTICAST_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+// Port leaders send LeaderStatus messages to their multicast group on.
+static const uint16_t MULTICAST_PORT = 50002;
+
+// How often the receiver thread checks whether it should stop.
+static const std::chrono::milliseconds MULTICAST_POLL_INTERVAL(20);
+
+std::string multicastGroupFor(const std::string &leaderIp);
+
+/**
+ * Receives the datagrams sent to a UDP multicast group, on a thread of its own, like cluon::UDPReceiver does for
+ * unicast. The group is joined on the interface of the given address rather than wherever the routing table points,
+ * so a car and a test on the loopback interface both receive what their leader sends through the same interface.
+ *
+ * If the group cannot be joined nothing is received and isRunning returns false. The delegate is called on the
+ * receiver thread, destroying the receiver waits for a running call to return.
+ */
+class MulticastReceiver {
+public:
+    typedef std::function<void(std::string &&data, std::string &&sender,
+                               std::chrono::system_clock::time_point &&timestamp)> Delegate;
+
+    MulticastReceiver(const std::string &group, uint16_t port, const std::string &interfaceIp, Delegate delegate);
+    ~MulticastReceiver();
+
+    MulticastReceiver(const MulticastReceiver &) = delete;
+    MulticastReceiver &operator=(const MulticastReceiver &) = delete;
+
+    bool isRunning() const;
+    const std::string &group() const;
+
+private:
+    void receive();
+
+    const std::string groupIp;
+    const Delegate onDatagram;
+    int socket;
+    std::atomic<bool> running;
+    std::thread receiver;
+};
+
+#endif // V2V_MULTICAST_H
@@ -0,0 +1,52 @@
+#include "odometry.hpp"
+
+/**
+ * Implementation of the Odometry class as declared in odometry.hpp
+ */
+
+Odometry::Odometry(float calibration) : calibration(calibration) {
+    reset();
+}
+
+/**
+ * Speed of the car at a given pedal position according to the speed model. Reversing is not modelled.
+ *
+ * @param pedalPosition - pedal position as sent to the motor (0 - 1)
+ * @return speed in cm per second
+ */
+float Odometry::cmPerSecond(float pedalPosition) {
+    if (pedalPosition < MIN_MOVING_PEDAL_POSITION) {
+        return 0.0f;
+    }
+    return CM_PER_SECOND_AT_MIN_PEDAL + (pedalPosition - MIN_MOVING_PEDAL_POSITION) * CM_PER_SECOND_PER_PEDAL;
+}
+
+void Odometry::reset(float startDistance) {
+    totalDistance = startDistance;
+    unreportedDistance = 0.0f;
+}
+
+/**
+ * Integrates the distance driven at a pedal position over a period of time.
+ *
+ * @param pedalPosition - pedal position held during the period
+ * @param elapsed - length of the period
+ */
+void Odometry::advance(float pedalPosition, std::chrono::microseconds elapsed) {
+    float driven = cmPerSecond(pedalPosition) * calibration * (elapsed.count() / 1000000.0f);
+    totalDistance += driven;
+    unreportedDistance += driven;
+}
+
+/**
+ * @return distance in cm since the last reset
+ */
+float Odometry::distance() const {
+    return totalDistance;
+}
+
+uint8_t Odometry::takeDistanceTraveled() {
+    float whole = unreportedDistance < 255.0f ? (float) (uint8_t) unreportedDistance : 255.0f;
+    unreportedDistance -= whole;
+    return (uint8_t) whole;
+}
@@ -0,0 +1,38 @@
+#ifndef V2V_ODOMETRY_H
+#define V2V_ODOMETRY_H
+
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Speed model of the miniature car, measured on the track: at a pedal position of 15% the car covers 7 cm per 125 ms
+ * LeaderStatus interval and every additional percent adds roughly 1.2 cm. Below 15% the car does not move at all.
+ */
+static const float MIN_MOVING_PEDAL_POSITION = 0.15f;
+static const float CM_PER_SECOND_AT_MIN_PEDAL = 56.0f;
+static const float CM_PER_SECOND_PER_PEDAL = 960.0f;
+
+/**
+ * Dead reckoning of the distance a car has driven, integrated from its pedal position over time.
+ */
+class Odometry {
+public:
+    explicit Odometry(float calibration = 1.0f);
+
+    static float cmPerSecond(float pedalPosition);
+
+    void reset(float startDistance = 0.0f);
+    void advance(float pedalPosition, std::chrono::microseconds elapsed);
+    float distance() const;
+
+    // Whole centimetres driven since the last call, the remainder is carried over to the next one.
+    uint8_t takeDistanceTraveled();
+
+private:
+    // Scales the speed model for cars that are faster or slower than ours at the same pedal position.
+    float calibration;
+    float totalDistance;
+    float unreportedDistance;
+};
+
+#endif // V2V_ODOMETRY_H
@@ -0,0 +1,183 @@
+#include "peer_registry.hpp"
+
+/**
+ * Implementation of the PeerSnapshot and PeerRegistry classes as declared in peer_registry.hpp
+ */
+
+/**
+ * @param groupId - group id of the car
+ * @return the car, nullptr if no car with this group id is known
+ */
+const PeerEntry *PeerSnapshot::byGroupId(const std::string &groupId) const {
+    std::unordered_map<std::string, size_t>::const_iterator it = groupIndex.find(groupId);
+    return it == groupIndex.end() ? nullptr : &peers[it->second];
+}
+
+/**
+ * @param ip - IP of the car
+ * @return the car, nullptr if no car with this IP is known
+ */
+const PeerEntry *PeerSnapshot::byIp(const std::string &ip) const {
+    std::unordered_map<std::string, size_t>::const_iterator it = ipIndex.find(ip);
+    return it == ipIndex.end() ? nullptr : &peers[it->second];
+}
+
+const std::vector<PeerEntry> &PeerSnapshot::entries() const {
+    return peers;
+}
+
+size_t PeerSnapshot::size() const {
+    return peers.size();
+}
+
+bool PeerSnapshot::empty() const {
+    return peers.empty();
+}
+
+/**
+ * Constructor for the peer registry.
+ *
+ * @param ttl - time after its last announcement a car is forgotten
+ * @param timeSource - clock the functions without a time argument use
+ */
+PeerRegistry::PeerRegistry(std::chrono::milliseconds ttl, const TimeSource &timeSource) :
+    timeSource(timeSource), timeToLive(ttl), present(0) {
+    std::lock_guard<std::mutex> lock(mutex);
+    publish();
+}
+
+bool PeerRegistry::announce(const std::string &groupId, const std::string &ip, uint32_t capabilities) {
+    return announce(groupId, ip, capabilities, timeSource.now());
+}
+
+/**
+ * Records an announcement of a car.
+ *
+ * @param groupId - group id the car announced
+ * @param ip - IP the car announced
+ * @param capabilities - capability bits the car announced
+ * @param now - time of the announcement
+ * @return true if a new snapshot was published, because the car is new, moved to another IP or changed its
+ *         capabilities
+ */
+bool PeerRegistry::announce(const std::string &groupId, const std::string &ip, uint32_t capabilities,
+                            TimeSource::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    PeerId id = intern(groupId);
+    lastSeen[id].store(now.time_since_epoch().count(), std::memory_order_relaxed);
+
+    Slot &slot = slots[id];
+    if (slot.present && slot.ip == ip) {
+        if (slot.capabilities == capabilities) {
+            return false;
+        }
+        slot.capabilities = capabilities;
+        publish();
+        return true;
+    }
+
+    // A car that comes back under another group id replaces the one it announced before.
+    std::unordered_map<std::string, PeerId>::iterator owner = ipOwners.find(ip);
+    if (owner != ipOwners.end()) {
+        slots[owner->second].present = false;
+        present--;
+    }
+    if (slot.present) {
+        ipOwners.erase(slot.ip);
+    } else {
+        slot.present = true;
+        present++;
+    }
+    slot.ip = ip;
+    slot.capabilities = capabilities;
+    ipOwners[ip] = id;
+    publish();
+    return true;
+}
+
+size_t PeerRegistry::expire() {
+    return expire(timeSource.now());
+}
+
+/**
+ * Forgets every car that has not announced itself for the time to live.
+ *
+ * @param now - current time
+ * @return number of cars forgotten
+ */
+size_t PeerRegistry::expire(TimeSource::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int64_t cutoff = (now - timeToLive).time_since_epoch().count();
+
+    size_t expired = 0;
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i].present && lastSeen[i].load(std::memory_order_relaxed) < cutoff) {
+            ipOwners.erase(slots[i].ip);
+            slots[i].present = false;
+            present--;
+            expired++;
+        }
+    }
+    if (expired > 0) {
+        publish();
+    }
+    return expired;
+}
+
+/**
+ * @return the current cars, never nullptr
+ */
+std::shared_ptr<const PeerSnapshot> PeerRegistry::snapshot() const {
+    return std::atomic_load(&current);
+}
+
+/**
+ * @param peer - car from a snapshot of this registry
+ * @return time since the car last announced itself
+ */
+std::chrono::milliseconds PeerRegistry::age(const PeerEntry &peer) const {
+    TimeSource::time_point seen(TimeSource::duration(peer.lastSeen->load(std::memory_order_relaxed)));
+    return std::chrono::duration_cast<std::chrono::milliseconds>(timeSource.now() - seen);
+}
+
+std::chrono::milliseconds PeerRegistry::ttl() const {
+    return timeToLive;
+}
+
+/**
+ * Called with the lock held.
+ *
+ * @param groupId - group id to intern
+ * @return id of the group id, a new one if it was never seen before
+ */
+PeerId PeerRegistry::intern(const std::string &groupId) {
+    std::unordered_map<std::string, PeerId>::iterator it = interned.find(groupId);
+    if (it != interned.end()) {
+        return it->second;
+    }
+    PeerId id = (PeerId) slots.size();
+    interned.insert(std::make_pair(groupId, id));
+    slots.push_back(Slot{groupId, "", 0, false});
+    lastSeen.emplace_back(0);
+    return id;
+}
+
+/**
+ * Builds a snapshot of the cars present and makes it the current one. Called with the lock held.
+ */
+void PeerRegistry::publish() {
+    std::shared_ptr<PeerSnapshot> next = std::make_shared<PeerSnapshot>();
+    next->peers.reserve(present);
+    next->groupIndex.reserve(present);
+    next->ipIndex.reserve(present);
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (!slots[i].present) {
+            continue;
+        }
+        next->groupIndex[slots[i].groupId] = next->peers.size();
+        next->ipIndex[slots[i].ip] = next->peers.size();
+        next->peers.push_back(PeerEntry{(PeerId) i, slots[i].groupId, slots[i].ip, slots[i].capabilities,
+                                          &lastSeen[i]});
+    }
+    std::atomic_store(&current, std::shared_ptr<const PeerSnapshot>(next));
+}
@@ -0,0 +1,109 @@
+#ifndef V2V_PEER_REGISTRY_H
+#define V2V_PEER_REGISTRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "time_source.hpp"
+
+// Compact id a group id is interned to. Ids are handed out from 0 up and stay with their group id for good.
+typedef uint32_t PeerId;
+
+/**
+ * A car that announced its presence.
+ */
+struct PeerEntry {
+    PeerId id;
+    std::string groupId;
+    std::string ip;
+    // Capability bits the car announced, see AnnouncePresence in messages.odvd.
+    uint32_t capabilities;
+    // Monotonic time the car last announced itself, in steady_clock ticks. Owned by the registry, updated in place.
+    const std::atomic<int64_t> *lastSeen;
+};
+
+/**
+ * Immutable view of the registry at one point in time, with O(1) lookup by group id and by IP. A snapshot stays valid
+ * and unchanged for as long as it is held, however the registry changes in the meantime. Only the last seen times of
+ * its entries move on.
+ */
+class PeerSnapshot {
+public:
+    const PeerEntry *byGroupId(const std::string &groupId) const;
+    const PeerEntry *byIp(const std::string &ip) const;
+
+    const std::vector<PeerEntry> &entries() const;
+    size_t size() const;
+    bool empty() const;
+
+private:
+    friend class PeerRegistry;
+
+    std::vector<PeerEntry> peers;
+    std::unordered_map<std::string, size_t> groupIndex;
+    std::unordered_map<std::string, size_t> ipIndex;
+};
+
+/**
+ * The cars that announced their presence, each forgotten again once it has not announced itself for the time to live.
+ *
+ * Writers, announcements and expiry, serialise on a lock. Readers never take it, they load the current snapshot and
+ * look up whatever they need in it. An announcement of a known car at its known IP, by far the most common one, only
+ * refreshes its last seen time and does not publish a new snapshot, so the snapshot is only rebuilt when a car comes,
+ * moves to another IP, changes its capabilities or goes.
+ *
+ * All functions may be called from any thread.
+ */
+class PeerRegistry {
+public:
+    explicit PeerRegistry(std::chrono::milliseconds ttl, const TimeSource &timeSource = TimeSource::system());
+
+    PeerRegistry(const PeerRegistry &) = delete;
+    PeerRegistry &operator=(const PeerRegistry &) = delete;
+
+    bool announce(const std::string &groupId, const std::string &ip, uint32_t capabilities = 0);
+    bool announce(const std::string &groupId, const std::string &ip, uint32_t capabilities,
+                  TimeSource::time_point now);
+    size_t expire();
+    size_t expire(TimeSource::time_point now);
+
+    std::shared_ptr<const PeerSnapshot> snapshot() const;
+    std::chrono::milliseconds age(const PeerEntry &peer) const;
+
+    std::chrono::milliseconds ttl() const;
+
+private:
+    struct Slot {
+        std::string groupId;
+        std::string ip;
+        uint32_t capabilities;
+        bool present;
+    };
+
+    PeerId intern(const std::string &groupId);
+    void publish();
+
+    const TimeSource &timeSource;
+    const std::chrono::milliseconds timeToLive;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, PeerId> interned;
+    std::vector<Slot> slots;
+    // Car present at each IP.
+    std::unordered_map<std::string, PeerId> ipOwners;
+    // Indexed by PeerId. A deque, since growing it does not move the elements the snapshots point to.
+    std::deque<std::atomic<int64_t>> lastSeen;
+    size_t present;
+
+    // Only accessed through std::atomic_load and std::atomic_store.
+    std::shared_ptr<const PeerSnapshot> current;
+};
+
+#endif // V2V_PEER_REGISTRY_H
@@ -0,0 +1,234 @@
+#include "reorder_window.hpp"
+
+#include <cmath>
+
+/**
+ * Implementation of the ReorderWindow class as declared in reorder_window.hpp
+ */
+
+ReorderWindow::ReorderWindow() :
+    lostCount(0), reorderedCount(0), lateCount(0), duplicateCount(0), interpolatedCount(0) {
+    reset();
+}
+
+/**
+ * Takes in a received status.
+ *
+ * @param status - received LeaderStatus
+ * @param now - monotonic time it was received
+ * @param released - receives the statuses that are due, in order, room for REORDER_MAX_RELEASED
+ * @return number of statuses released, 0 if the status was held back or dropped
+ */
+size_t ReorderWindow::accept(const LeaderStatus &status, TimeSource::time_point now, LeaderStatus *released) {
+    uint32_t sequence = status.sequence();
+    if (sequence == 0) {
+        released[0] = status;
+        return 1;
+    }
+    if (next == 0) {
+        next = sequence;
+    }
+
+    int32_t ahead = static_cast<int32_t>(sequence - next);
+    if (ahead < 0) {
+        uint32_t behind = next - sequence;
+        if (behind <= REORDER_HISTORY) {
+            if ((seen >> (behind - 1)) & 1) {
+                duplicateCount++;
+            } else {
+                lateCount++;
+            }
+            return 0;
+        }
+        // The leader counts from 1 again, what we hold still came before.
+        size_t count = releaseHeld(true, released, 0);
+        next = sequence;
+        seen = 0;
+        return release(status, released, count);
+    }
+
+    if (ahead == 0) {
+        if (heldCount > 0) {
+            reorderedCount++;
+        }
+        size_t count = release(status, released, 0);
+        return releaseHeld(false, released, count);
+    }
+
+    if (ahead > static_cast<int32_t>(REORDER_DEPTH)) {
+        size_t count = releaseHeld(true, released, 0);
+        return release(status, released, count);
+    }
+
+    Held &held = slot(sequence);
+    if (held.used) {
+        duplicateCount++;
+        return 0;
+    }
+    held.used = true;
+    held.status = status;
+    held.since = now;
+    heldCount++;
+    if (heldCount == REORDER_DEPTH) {
+        return releaseHeld(true, released, 0);
+    }
+    return expire(now, released);
+}
+
+/**
+ * Gives up on the missing status once a held one has waited for REORDER_HOLD. To be called regularly, statuses are
+ * otherwise only released when the next one comes in.
+ *
+ * @param now - current monotonic time
+ * @param released - receives the statuses that are due, in order, room for REORDER_MAX_RELEASED
+ * @return number of statuses released
+ */
+size_t ReorderWindow::expire(TimeSource::time_point now, LeaderStatus *released) {
+    if (heldCount == 0) {
+        return 0;
+    }
+    TimeSource::time_point oldest = TimeSource::time_point::max();
+    for (const Held &held : window) {
+        if (held.used && held.since < oldest) {
+            oldest = held.since;
+        }
+    }
+    return now - oldest >= REORDER_HOLD ? releaseHeld(true, released, 0) : 0;
+}
+
+/**
+ * Starts over for a new session, forgetting what was held and the counters.
+ */
+void ReorderWindow::reset() {
+    next = 0;
+    last = LeaderStatus();
+    haveLast = false;
+    seen = 0;
+    for (Held &held : window) {
+        held.used = false;
+    }
+    heldCount = 0;
+    lostCount = 0;
+    reorderedCount = 0;
+    lateCount = 0;
+    duplicateCount = 0;
+    interpolatedCount = 0;
+}
+
+size_t ReorderWindow::held() const {
+    return heldCount;
+}
+
+/**
+ * @return number of statuses given up on
+ */
+uint64_t ReorderWindow::lost() const {
+    return lostCount;
+}
+
+/**
+ * @return number of statuses that arrived after a later one and were put back in order
+ */
+uint64_t ReorderWindow::reordered() const {
+    return reorderedCount;
+}
+
+/**
+ * @return number of statuses that arrived after they were given up on, they were dropped
+ */
+uint64_t ReorderWindow::late() const {
+    return lateCount;
+}
+
+uint64_t ReorderWindow::duplicates() const {
+    return duplicateCount;
+}
+
+/**
+ * @return number of statuses made up for lost ones
+ */
+uint64_t ReorderWindow::interpolated() const {
+    return interpolatedCount;
+}
+
+/**
+ * Makes up a status between two others. The distance traveled is the distance since the previous status, so it is
+ * interpolated like the speed rather than accumulated.
+ *
+ * @param from - status before the gap
+ * @param to - status after the gap
+ * @param sequence - sequence number of the made up status
+ * @param fraction - position in the gap, between 0 (from) and 1 (to)
+ * @return the made up status, without an echo
+ */
+LeaderStatus ReorderWindow::interpolate(const LeaderStatus &from, const LeaderStatus &to, uint32_t sequence,
+                                        double fraction) {
+    auto between = [fraction](uint64_t a, uint64_t b) {
+        return a + static_cast<uint64_t>(std::llround(static_cast<double>(static_cast<int64_t>(b - a)) * fraction));
+    };
+
+    LeaderStatus status;
+    status.timestamp(between(from.timestamp(), to.timestamp()));
+    status.speed(static_cast<float>(from.speed() + (to.speed() - from.speed()) * fraction));
+    status.steeringAngle(static_cast<float>(from.steeringAngle() + (to.steeringAngle() - from.steeringAngle()) *
+                                                                    fraction));
+    status.distanceTraveled(static_cast<uint8_t>(std::lround(from.distanceTraveled() +
+                                                             (to.distanceTraveled() - from.distanceTraveled()) *
+                                                             fraction)));
+    if (from.timestampMicros() != 0 && to.timestampMicros() != 0) {
+        status.timestampMicros(between(from.timestampMicros(), to.timestampMicros()));
+    }
+    status.sequence(sequence);
+    return status;
+}
+
+/**
+ * Releases a status, after the interpolated ones for the gap before it if it is short enough.
+ */
+size_t ReorderWindow::release(const LeaderStatus &status, LeaderStatus *released, size_t count) {
+    uint32_t gap = status.sequence() - next;
+    if (gap > 0) {
+        lostCount += gap;
+        if (gap <= REORDER_MAX_INTERPOLATED && haveLast) {
+            for (uint32_t i = 1; i <= gap; i++) {
+                released[count++] = interpolate(last, status, next + i - 1, static_cast<double>(i) / (gap + 1));
+            }
+            interpolatedCount += gap;
+        }
+    }
+
+    seen = gap + 1 >= 64 ? 0 : seen << (gap + 1);
+    seen |= 1;
+    released[count++] = status;
+    last = status;
+    haveLast = true;
+    next = status.sequence() + 1;
+    return count;
+}
+
+/**
+ * Releases the held statuses that are next in line, or all of them giving up on the ones missing in between.
+ */
+size_t ReorderWindow::releaseHeld(bool all, LeaderStatus *released, size_t count) {
+    uint32_t sequence = next;
+    for (size_t i = 0; i <= REORDER_DEPTH && heldCount > 0; i++, sequence++) {
+        Held &held = slot(sequence);
+        if (!held.used || held.status.sequence() != sequence) {
+            if (!all) {
+                break;
+            }
+            continue;
+        }
+        held.used = false;
+        heldCount--;
+        count = release(held.status, released, count);
+    }
+    return count;
+}
+
+/**
+ * Every status held is at most REORDER_DEPTH ahead of the next one, so they all have a slot of their own.
+ */
+ReorderWindow::Held &ReorderWindow::slot(uint32_t sequence) {
+    return window[sequence % (REORDER_DEPTH + 1)];
+}
@@ -0,0 +1,89 @@
+#ifndef V2V_REORDER_WINDOW_H
+#define V2V_REORDER_WINDOW_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "messages.hpp"
+
+#include "time_source.hpp"
+
+// Statuses ahead of a missing one that are held back waiting for it, and how long the first of them waits at most.
+static const size_t REORDER_DEPTH = 4;
+static const std::chrono::milliseconds REORDER_HOLD(30);
+
+// How often held statuses are checked for having waited long enough.
+static const std::chrono::milliseconds REORDER_TICK(10);
+
+// Gaps of up to this many lost statuses are filled in by interpolation, longer ones are left as they are.
+static const uint32_t REORDER_MAX_INTERPOLATED = 3;
+
+// Most statuses released at once: the held ones and the gaps before them span REORDER_DEPTH + 1 sequence numbers, then
+// comes the one that came in with the ones interpolated before it.
+static const size_t REORDER_MAX_RELEASED = REORDER_DEPTH + 2 + REORDER_MAX_INTERPOLATED;
+
+// Sequence numbers further back than this are taken for a leader that started counting over.
+static const uint32_t REORDER_HISTORY = 64;
+
+/**
+ * Puts the LeaderStatus stream of a leader back in order by the sequence numbers, see messages.odvd.
+ *
+ * A status that arrives ahead of a missing one is held back, until the missing one arrives, REORDER_DEPTH statuses
+ * are held or the first one was held for REORDER_HOLD. Then the missing one is given up on: if the gap is short the
+ * statuses in it are interpolated from their neighbours, and the held ones are released in order. Duplicates and
+ * statuses arriving after they were given up on are dropped, so nothing is ever released twice or out of order.
+ * Statuses without a sequence number, from cars of other groups, are released as they come.
+ *
+ * Not thread safe, apart from reading the counters.
+ */
+class ReorderWindow {
+public:
+    ReorderWindow();
+
+    size_t accept(const LeaderStatus &status, TimeSource::time_point now, LeaderStatus *released);
+    size_t expire(TimeSource::time_point now, LeaderStatus *released);
+    void reset();
+
+    size_t held() const;
+
+    uint64_t lost() const;
+    uint64_t reordered() const;
+    uint64_t late() const;
+    uint64_t duplicates() const;
+    uint64_t interpolated() const;
+
+    static LeaderStatus interpolate(const LeaderStatus &from, const LeaderStatus &to, uint32_t sequence,
+                                    double fraction);
+
+private:
+    struct Held {
+        bool used;
+        LeaderStatus status;
+        TimeSource::time_point since;
+    };
+
+    size_t release(const LeaderStatus &status, LeaderStatus *released, size_t count);
+    size_t releaseHeld(bool all, LeaderStatus *released, size_t count);
+    Held &slot(uint32_t sequence);
+
+    // Sequence number of the next status to release, 0 until the first one with a sequence number came in.
+    uint32_t next;
+    // Last status released, the starting point of interpolations.
+    LeaderStatus last;
+    bool haveLast;
+    // Bit i is set if next - 1 - i was received rather than interpolated or lost.
+    uint64_t seen;
+
+    Held window[REORDER_DEPTH + 1];
+    size_t heldCount;
+
+    std::atomic<uint64_t> lostCount;
+    std::atomic<uint64_t> reorderedCount;
+    std::atomic<uint64_t> lateCount;
+    std::atomic<uint64_t> duplicateCount;
+    std::atomic<uint64_t> interpolatedCount;
+};
+
+#endif // V2V_REORDER_WINDOW_H
@@ -0,0 +1,97 @@
+#include "replay_scheduler.hpp"
+
+/**
+ * Implementation of the ReplayScheduler class as declared in replay_scheduler.hpp
+ */
+
+/**
+ * Constructor for the replay scheduler.
+ *
+ * @param timeSource - monotonic clock the deadlines are on
+ */
+ReplayScheduler::ReplayScheduler(const TimeSource &timeSource) : timeSource(timeSource), leaderDriftPpm(0.0) {
+    reset();
+}
+
+/**
+ * Computes the deadline at which the next leader update should be actuated.
+ *
+ * @param leaderTimestamp - timestamp of the update in milliseconds as set by the leader, 0 if it has none
+ * @param extraDelay - delay added to this deadline and carried over to the ones after it
+ * @return absolute deadline on the monotonic clock
+ */
+ReplayScheduler::Clock::time_point ReplayScheduler::schedule(uint64_t leaderTimestamp,
+                                                             std::chrono::milliseconds extraDelay) {
+    Clock::time_point now = timeSource.now();
+    Clock::time_point deadline;
+
+    if (!anchored) {
+        // First update after a (re)start, give it the same head start every update used to get.
+        deadline = now + NOMINAL_UPDATE_SPACING;
+        anchored = true;
+    } else {
+        Clock::duration spacing = NOMINAL_UPDATE_SPACING;
+        if (leaderTimestamp != 0 && lastTimestamp != 0 && leaderTimestamp > lastTimestamp) {
+            std::chrono::milliseconds gap(leaderTimestamp - lastTimestamp);
+            if (gap >= MIN_UPDATE_SPACING && gap <= MAX_UPDATE_SPACING) {
+                // A leader clock that gains on ours measures gaps longer than they are on our clock.
+                spacing = gap;
+                spacing -= Clock::duration((Clock::duration::rep) ((double) spacing.count() * leaderDriftPpm * 1e-6));
+            }
+        }
+        deadline = lastDeadline + spacing;
+
+        // If we are more than one update behind, drift rather than replaying the backlog in a burst.
+        if (deadline + NOMINAL_UPDATE_SPACING < now) {
+            deadline = now;
+        }
+    }
+
+    deadline += extraDelay;
+    lastDeadline = deadline;
+    lastTimestamp = leaderTimestamp;
+    return deadline;
+}
+
+/**
+ * Sleeps until the given deadline and records how late we woke up.
+ *
+ * @param deadline - absolute deadline as returned by schedule
+ */
+void ReplayScheduler::waitUntil(Clock::time_point deadline) {
+    timeSource.sleepUntil(deadline);
+    recordActuation(deadline);
+}
+
+/**
+ * Records how late an update is actuated, for callers that wait for the deadline themselves.
+ *
+ * @param deadline - absolute deadline as returned by schedule
+ */
+void ReplayScheduler::recordActuation(Clock::time_point deadline) {
+    using namespace std::chrono;
+    actuationJitter.record(duration_cast<microseconds>(timeSource.now() - deadline).count());
+}
+
+/**
+ * Sets the drift of the leader clock against ours, applied to the spacing from the leader timestamps.
+ *
+ * @param ppm - microseconds per second the leader clock gains on ours, as estimated by ClockSync
+ */
+void ReplayScheduler::setLeaderClockDrift(double ppm) {
+    leaderDriftPpm = ppm;
+}
+
+/**
+ * Forgets the previous deadline, the next scheduled update is anchored to the current time. Used whenever the leader
+ * stops, since the pause should not be replayed.
+ */
+void ReplayScheduler::reset() {
+    anchored = false;
+    lastDeadline = Clock::time_point();
+    lastTimestamp = 0;
+}
+
+const LatencyHistogram &ReplayScheduler::jitter() const {
+    return actuationJitter;
+}
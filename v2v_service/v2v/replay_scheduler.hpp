@@ -0,0 +1,57 @@
+#ifndef V2V_REPLAY_SCHEDULER_H
+#define V2V_REPLAY_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+
+#include "histogram.hpp"
+#include "time_source.hpp"
+
+// Spacing used when the leader timestamps cannot be trusted, the protocol rate of LeaderStatus messages.
+static const std::chrono::milliseconds NOMINAL_UPDATE_SPACING(125);
+
+// Timestamp gaps outside of this range are not believed to be real inter-arrival times. Above the maximum the leader
+// most likely stopped sending for a while, below the minimum its timestamps are not in milliseconds.
+static const std::chrono::milliseconds MIN_UPDATE_SPACING(20);
+static const std::chrono::milliseconds MAX_UPDATE_SPACING(1000);
+
+/**
+ * Schedules the replay of leader updates at the same spacing the leader produced them with, taken from the leader's
+ * LeaderStatus timestamps.
+ *
+ * Every update gets an absolute deadline on the monotonic clock, computed from the deadline of the previous update
+ * plus the difference between the two leader timestamps. Since deadlines are absolute, the time spent actuating or
+ * oversleeping one update does not push back the ones after it.
+ *
+ * Time is taken from a TimeSource, so the scheduler can be run in simulated time. The leader timestamps are on the
+ * leader's clock, if its drift against ours is known the spacing is corrected for it, so the replay does not slowly
+ * run ahead of or behind the leader over a long session.
+ */
+class ReplayScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit ReplayScheduler(const TimeSource &timeSource = TimeSource::system());
+
+    Clock::time_point schedule(uint64_t leaderTimestamp,
+                               std::chrono::milliseconds extraDelay = std::chrono::milliseconds(0));
+    void waitUntil(Clock::time_point deadline);
+    void recordActuation(Clock::time_point deadline);
+    void setLeaderClockDrift(double ppm);
+    void reset();
+
+    // Lateness of the actual actuation compared to the scheduled deadline.
+    const LatencyHistogram &jitter() const;
+
+private:
+    const TimeSource &timeSource;
+
+    bool anchored;
+    Clock::time_point lastDeadline;
+    uint64_t lastTimestamp;
+    double leaderDriftPpm;
+
+    LatencyHistogram actuationJitter;
+};
+
+#endif // V2V_REPLAY_SCHEDULER_H
@@ -0,0 +1,291 @@
+#include "send_pool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "log.hpp"
+
+/**
+ * Implementation of the SendPool and PeerSendContext classes as declared in send_pool.hpp
+ */
+
+/**
+ * Constructor for a peer's send context.
+ *
+ * @param ip - IP of the peer
+ * @param port - port of the peer
+ */
+PeerSendContext::PeerSendContext(const std::string &ip, uint16_t port) : peerIp(ip), peerPort(port), errors(0) {
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = inet_addr(ip.c_str());
+
+    for (size_t i = 0; i < SEND_SLOTS; i++) {
+        buffers[i].reserve(MAX_FRAME_SIZE);
+        queued[i] = false;
+    }
+}
+
+const std::string &PeerSendContext::ip() const {
+    return peerIp;
+}
+
+uint16_t PeerSendContext::port() const {
+    return peerPort;
+}
+
+/**
+ * @return number of datagrams to this peer the kernel refused
+ */
+uint64_t PeerSendContext::sendErrors() const {
+    return errors;
+}
+
+/**
+ * Constructor for the send pool, opens the socket everything is sent through.
+ *
+ * @param poolCapacity - number of peer contexts kept
+ * @param connected - false to open no socket and drop everything instead of sending it
+ */
+SendPool::SendPool(size_t poolCapacity, bool connected) :
+    capacity(std::max(poolCapacity, static_cast<size_t>(1))), connected(connected), socket(-1), pending(0),
+    datagrams(0), calls(0), errors(0) {
+    if (connected) {
+        socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    }
+    if (connected && socket < 0) {
+        V2V_LOG(ERROR) << "Could not open the V2V send socket: " << std::strerror(errno);
+    }
+    contexts.reserve(capacity + 1);
+}
+
+SendPool::~SendPool() {
+    if (socket >= 0) {
+        ::close(socket);
+    }
+}
+
+/**
+ * Gets the send context of a peer, creating it if the peer is not in the pool. Creating a context evicts the least
+ * recently used one that nobody holds anymore if the pool is full. If every context is held the pool grows instead.
+ *
+ * @param ip - IP of the peer
+ * @param port - port of the peer
+ * @return the peer's context, the same one for as long as it stays in the pool
+ */
+std::shared_ptr<PeerSendContext> SendPool::acquire(const std::string &ip, uint16_t port) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < contexts.size(); i++) {
+        if (contexts[i]->peerIp == ip && contexts[i]->peerPort == port) {
+            std::rotate(contexts.begin(), contexts.begin() + i, contexts.begin() + i + 1);
+            return contexts.front();
+        }
+    }
+
+    if (contexts.size() >= capacity) {
+        // Queued datagrams hold their peer, so an unheld context never has anything left to send.
+        for (size_t i = contexts.size(); i > 0; i--) {
+            if (contexts[i - 1].use_count() == 1) {
+                contexts.erase(contexts.begin() + (i - 1));
+                break;
+            }
+        }
+    }
+    contexts.insert(contexts.begin(), std::make_shared<PeerSendContext>(ip, port));
+    return contexts.front();
+}
+
+size_t SendPool::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return contexts.size();
+}
+
+/**
+ * Picks the interface datagrams to multicast groups leave through, otherwise the routing table decides. Datagrams to a
+ * group are looped back to members on this host as well.
+ *
+ * @param ip - address of the interface
+ * @return false if the interface could not be used
+ */
+bool SendPool::setMulticastInterface(const std::string &ip) {
+    in_addr address;
+    address.s_addr = inet_addr(ip.c_str());
+    if (socket < 0 || ::setsockopt(socket, IPPROTO_IP, IP_MULTICAST_IF, &address, sizeof(address)) != 0) {
+        V2V_LOG(WARNING) << "Could not send multicast through " << ip << ": " << std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Sends from the given local address instead of one the kernel picks, so peers see the datagrams come from it. Meant
+ * for several services on the 127.0.0.x addresses of one machine, which tell each other apart by their addresses.
+ *
+ * @param ip - local address to send from
+ * @return false if the address could not be used
+ */
+bool SendPool::bindTo(const std::string &ip) {
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = inet_addr(ip.c_str());
+    if (socket < 0 || ::bind(socket, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0) {
+        V2V_LOG(WARNING) << "Could not send from " << ip << ": " << std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Queues a message that is already encoded, given as two parts that are sent back to back. Meant for a message sent to
+ * several peers, the part that is the same for all of them is encoded only once.
+ *
+ * @param peer - context from acquire
+ * @param id - message ID
+ * @param framing - header format the peer understands
+ * @param payload - first part of the protobuf encoded message
+ * @param payloadTail - rest of the protobuf encoded message, may be empty
+ */
+void SendPool::queueFrame(const std::shared_ptr<PeerSendContext> &peer, int32_t id, Framing framing,
+                          const std::string &payload, const std::string &payloadTail) {
+    size_t slot = slotOf(id);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (peer->queued[slot] || pending == SEND_BATCH_SIZE) {
+        flushLocked();
+    }
+    std::string &frame = peer->buffers[slot];
+    frame.clear();
+    frame.reserve(MAX_FRAME_SIZE);
+    frame.append(framing == Framing::BINARY ? BINARY_HEADER_SIZE : LEGACY_HEADER_SIZE, '\0');
+    frame.append(payload);
+    frame.append(payloadTail);
+    writeFrameHeader(framing, static_cast<uint16_t>(id), frame);
+    enqueueLocked(peer, slot);
+}
+
+/**
+ * Hands everything queued to the kernel.
+ *
+ * @return number of datagrams sent
+ */
+size_t SendPool::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return flushLocked();
+}
+
+uint64_t SendPool::datagramsSent() const {
+    return datagrams;
+}
+
+/**
+ * @return number of system calls made to send, lower than datagramsSent when datagrams were batched
+ */
+uint64_t SendPool::sendCalls() const {
+    return calls;
+}
+
+uint64_t SendPool::sendErrors() const {
+    return errors;
+}
+
+/**
+ * Maps a message ID to the buffer slot of its type.
+ */
+size_t SendPool::slotOf(int32_t id) {
+    if (id == LeaderStatus::ID()) return 0;
+    if (id == FollowerStatus::ID()) return 1;
+    if (id == FollowRequest::ID()) return 2;
+    if (id == FollowResponse::ID()) return 3;
+    if (id == StopFollow::ID()) return 4;
+    return 5;
+}
+
+/**
+ * Called with the lock held, after the frame was written to the slot.
+ */
+void SendPool::enqueueLocked(const std::shared_ptr<PeerSendContext> &peer, size_t slot) {
+    peer->queued[slot] = true;
+    pendingPeers[pending] = peer;
+    pendingSlots[pending] = slot;
+    pending++;
+}
+
+/**
+ * Called with the lock held. Sends what is queued, unless the pool is not connected, and empties the queue.
+ */
+size_t SendPool::flushLocked() {
+    size_t sent = connected ? sendLocked() : 0;
+
+    for (size_t i = 0; i < pending; i++) {
+        pendingPeers[i]->queued[pendingSlots[i]] = false;
+        pendingPeers[i].reset();
+    }
+    pending = 0;
+    datagrams += sent;
+    return sent;
+}
+
+/**
+ * Called with the lock held. A datagram the kernel refuses is counted as an error and skipped, the ones after it are
+ * still sent.
+ *
+ * @return number of datagrams sent
+ */
+size_t SendPool::sendLocked() {
+    size_t sent = 0;
+#ifdef __linux__
+    mmsghdr messages[SEND_BATCH_SIZE];
+    iovec payloads[SEND_BATCH_SIZE];
+    std::memset(messages, 0, sizeof(mmsghdr) * pending);
+    for (size_t i = 0; i < pending; i++) {
+        PeerSendContext &peer = *pendingPeers[i];
+        const std::string &frame = peer.buffers[pendingSlots[i]];
+        payloads[i].iov_base = const_cast<char *>(frame.data());
+        payloads[i].iov_len = frame.length();
+        messages[i].msg_hdr.msg_name = &peer.address;
+        messages[i].msg_hdr.msg_namelen = sizeof(peer.address);
+        messages[i].msg_hdr.msg_iov = &payloads[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t next = 0;
+    while (next < pending) {
+        int result = ::sendmmsg(socket, messages + next, static_cast<unsigned int>(pending - next), 0);
+        calls++;
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            // Only returned when the first datagram fails, the rest are tried again without it.
+            V2V_LOG_EVERY(WARNING, 1000) << "Could not send to " << pendingPeers[next]->peerIp << ": "
+                                         << std::strerror(errno);
+            pendingPeers[next]->errors++;
+            errors++;
+            next++;
+            continue;
+        }
+        next += static_cast<size_t>(result);
+        sent += static_cast<size_t>(result);
+    }
+#else
+    for (size_t i = 0; i < pending; i++) {
+        PeerSendContext &peer = *pendingPeers[i];
+        const std::string &frame = peer.buffers[pendingSlots[i]];
+        ssize_t result = ::sendto(socket, frame.data(), frame.length(), 0,
+                                  reinterpret_cast<const sockaddr *>(&peer.address), sizeof(peer.address));
+        calls++;
+        if (result < 0) {
+            V2V_LOG_EVERY(WARNING, 1000) << "Could not send to " << peer.peerIp << ": " << std::strerror(errno);
+            peer.errors++;
+            errors++;
+        } else {
+            sent++;
+        }
+    }
+#endif
+    return sent;
+}
@@ -0,0 +1,157 @@
+#ifndef V2V_SEND_POOL_H
+#define V2V_SEND_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+
+#include "framing.hpp"
+#include "messages.hpp"
+
+// Peers a send context is kept for. We only ever send to our leader and our followers directly, the rest of the pool
+// keeps the contexts of recent peers around for when they come back.
+static const size_t SEND_POOL_SIZE = 16;
+
+// Most datagrams handed to the kernel in one call, a fuller queue is flushed early.
+static const size_t SEND_BATCH_SIZE = 16;
+
+// One buffer per message type sent directly to a peer, plus one shared by every other type.
+static const size_t SEND_SLOTS = 6;
+
+/**
+ * Everything needed to send to one peer: its address and a preallocated frame buffer per message type. The buffers
+ * are reused for every message, so sending to a known peer does not allocate. A buffer holds its frame until the
+ * datagram is handed to the kernel, which is why every message type has its own, a queued LeaderStatus is not
+ * overwritten by a StopFollow queued after it.
+ *
+ * Contexts are handed out by a SendPool and only written to by it, under its lock.
+ */
+class PeerSendContext {
+public:
+    PeerSendContext(const std::string &ip, uint16_t port);
+
+    PeerSendContext(const PeerSendContext &) = delete;
+    PeerSendContext &operator=(const PeerSendContext &) = delete;
+
+    const std::string &ip() const;
+    uint16_t port() const;
+    uint64_t sendErrors() const;
+
+private:
+    friend class SendPool;
+
+    const std::string peerIp;
+    const uint16_t peerPort;
+    sockaddr_in address;
+
+    std::string buffers[SEND_SLOTS];
+    bool queued[SEND_SLOTS];
+
+    std::atomic<uint64_t> errors;
+};
+
+/**
+ * Sends V2V datagrams to our peers through a single UDP socket.
+ *
+ * Each peer gets a PeerSendContext, looked up by IP and port and kept in a small pool, least recently used first out,
+ * so following the same car again reuses its context instead of creating a new sender. Messages are encoded into the
+ * context's buffer and queued, flush hands everything queued to the kernel with one sendmmsg call. Status messages
+ * that are due at the same time, to one peer or several, thereby cost a single system call. send queues and flushes
+ * in one go, for messages that should not wait. A peer may also be a multicast group, datagrams to it leave through the
+ * interface set with setMulticastInterface. Datagrams leave from the address set with bindTo, if any. A pool that is
+ * not connected opens no socket and drops whatever is flushed, for running the service without a network.
+ *
+ * All functions may be called from any thread.
+ */
+class SendPool {
+public:
+    explicit SendPool(size_t capacity = SEND_POOL_SIZE, bool connected = true);
+    ~SendPool();
+
+    SendPool(const SendPool &) = delete;
+    SendPool &operator=(const SendPool &) = delete;
+
+    std::shared_ptr<PeerSendContext> acquire(const std::string &ip, uint16_t port);
+    size_t size();
+    bool setMulticastInterface(const std::string &ip);
+    bool bindTo(const std::string &ip);
+
+    template <class T>
+    void queue(const std::shared_ptr<PeerSendContext> &peer, T &msg, Framing framing);
+    template <class T>
+    bool send(const std::shared_ptr<PeerSendContext> &peer, T &msg, Framing framing);
+    void queueFrame(const std::shared_ptr<PeerSendContext> &peer, int32_t id, Framing framing,
+                    const std::string &payload, const std::string &payloadTail);
+    size_t flush();
+
+    uint64_t datagramsSent() const;
+    uint64_t sendCalls() const;
+    uint64_t sendErrors() const;
+
+private:
+    static size_t slotOf(int32_t id);
+    void enqueueLocked(const std::shared_ptr<PeerSendContext> &peer, size_t slot);
+    size_t flushLocked();
+    size_t sendLocked();
+
+    const size_t capacity;
+    const bool connected;
+    int socket;
+
+    std::mutex mutex;
+    // Most recently used first.
+    std::vector<std::shared_ptr<PeerSendContext>> contexts;
+
+    // Queued datagrams, each a peer and the slot its frame is in. Holding the peer keeps its buffers alive until sent.
+    std::shared_ptr<PeerSendContext> pendingPeers[SEND_BATCH_SIZE];
+    size_t pendingSlots[SEND_BATCH_SIZE];
+    size_t pending;
+
+    std::atomic<uint64_t> datagrams;
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> errors;
+};
+
+/**
+ * Encodes a message into the peer's buffer for its type and queues it, it goes out with the next flush. If a message
+ * of the same type is still queued for the peer, or the batch is full, what is queued is flushed first.
+ *
+ * @tparam T - generic message type
+ * @param peer - context from acquire
+ * @param msg - message to send
+ * @param framing - header format the peer understands
+ */
+template <class T>
+void SendPool::queue(const std::shared_ptr<PeerSendContext> &peer, T &msg, Framing framing) {
+    size_t slot = slotOf(T::ID());
+    std::lock_guard<std::mutex> lock(mutex);
+    if (peer->queued[slot] || pending == SEND_BATCH_SIZE) {
+        flushLocked();
+    }
+    encodeFrameInto(msg, framing, peer->buffers[slot]);
+    enqueueLocked(peer, slot);
+}
+
+/**
+ * Sends a message right away, together with anything queued before it.
+ *
+ * @tparam T - generic message type
+ * @param peer - context from acquire
+ * @param msg - message to send
+ * @param framing - header format the peer understands
+ * @return false if the message or anything queued before it could not be sent
+ */
+template <class T>
+bool SendPool::send(const std::shared_ptr<PeerSendContext> &peer, T &msg, Framing framing) {
+    uint64_t errorsBefore = errors;
+    queue(peer, msg, framing);
+    flush();
+    return errors == errorsBefore;
+}
+
+#endif // V2V_SEND_POOL_H
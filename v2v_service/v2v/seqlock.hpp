@@ -0,0 +1,90 @@
+#ifndef V2V_SEQLOCK_H
+#define V2V_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Sequence lock publishing a small value from one writer thread to any number of reader threads.
+ *
+ * The writer never waits: it makes the sequence number odd, writes the value and makes the sequence number even
+ * again. A reader copies the value out and retries if the sequence number was odd or changed in the meantime, so it
+ * only ever returns a value exactly as it was stored, never a mix of two stores.
+ *
+ * The value is kept in atomic words rather than a plain T so the copy a reader makes while a write is in progress
+ * (and then throws away) is not a data race. The words are ordered with release stores and acquire loads instead of
+ * fences, which ThreadSanitizer does not understand, so the lock is clean under it.
+ *
+ * @tparam T - value type, has to be trivially copyable
+ */
+template <class T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock values must be trivially copyable");
+
+public:
+    SeqLock() : sequence(0) {
+        store(T());
+    }
+
+    explicit SeqLock(const T &initial) : sequence(0) {
+        store(initial);
+    }
+
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    /**
+     * Writer only. Publishes a new value.
+     *
+     * @param value - value to publish
+     */
+    void store(const T &value) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        uint64_t current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+
+        // Release, so a reader that sees any of the new words also sees the odd sequence number before them.
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i].store(buffer[i], std::memory_order_release);
+        }
+        sequence.store(current + 2, std::memory_order_release);
+    }
+
+    /**
+     * Any thread. Takes a consistent copy of the latest value, retrying while a store is in progress.
+     *
+     * @return the latest published value
+     */
+    T load() const {
+        uint64_t buffer[WORDS];
+        uint64_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++) {
+                buffer[i] = words[i].load(std::memory_order_acquire);
+            }
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+    // Number of stores so far, including the initial value.
+    uint64_t version() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> words[WORDS];
+};
+
+#endif // V2V_SEQLOCK_H
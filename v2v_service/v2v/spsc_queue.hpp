@@ -0,0 +1,148 @@
+#ifndef V2V_SPSC_QUEUE_H
+#define V2V_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+static const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Bounded, lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * The producer owns the tail index and the consumer owns the head index, each on its own cache line so the two
+ * threads never write to the same line. A push on a full queue is rejected and counted as an overflow instead of
+ * blocking the producer, which in our case is the UDP receiver thread.
+ *
+ * @tparam T - element type, has to be default constructible and assignable
+ * @tparam Capacity - maximum number of elements, has to be a power of two
+ */
+template <class T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0), overflowCount(0), highWater(0) {}
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /**
+     * Producer only. Appends an element to the queue.
+     *
+     * @param item - element to append
+     * @return false if the queue was full, the element is then dropped and counted as an overflow
+     */
+    bool push(const T &item) {
+        return emplace(item);
+    }
+
+    bool push(T &&item) {
+        return emplace(std::move(item));
+    }
+
+    /**
+     * Producer only. Appends an element built from the given arguments, which are only moved or copied into the slot
+     * once.
+     *
+     * @param args - constructor arguments of the element
+     * @return false if the queue was full, the element is then dropped and counted as an overflow
+     */
+    template <class... Args>
+    bool emplace(Args &&... args) {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        size_t used = currentTail - head.load(std::memory_order_acquire);
+        if (used == Capacity) {
+            overflowCount.store(overflowCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        slots[currentTail & (Capacity - 1)] = T(std::forward<Args>(args)...);
+        tail.store(currentTail + 1, std::memory_order_release);
+
+        if (used + 1 > highWater.load(std::memory_order_relaxed)) {
+            highWater.store(used + 1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /**
+     * Consumer only. Removes the oldest element from the queue.
+     *
+     * @param item - receives the removed element
+     * @return false if the queue was empty
+     */
+    bool pop(T &item) {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = std::move(slots[currentHead & (Capacity - 1)]);
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer only. Gives access to the oldest element without removing it.
+     *
+     * @return the oldest element, nullptr if the queue is empty
+     */
+    T *front() {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[currentHead & (Capacity - 1)];
+    }
+
+    /**
+     * Consumer only, or the producer while the consumer is known to be idle, in which case it is the consumer as well.
+     * Drops every element currently in the queue.
+     */
+    void clear() {
+        head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    /**
+     * Number of elements in the queue. Only exact when called from the producer or consumer thread while the other
+     * one is idle, otherwise a snapshot.
+     */
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+    // Number of pushes rejected because the queue was full.
+    uint64_t overflows() const {
+        return overflowCount.load(std::memory_order_relaxed);
+    }
+
+    // Largest number of elements the queue has held at once.
+    size_t highWaterMark() const {
+        return highWater.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Consumer owned.
+    std::atomic<size_t> head;
+    char headPadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+    // Producer owned, including the statistics.
+    std::atomic<size_t> tail;
+    std::atomic<uint64_t> overflowCount;
+    std::atomic<size_t> highWater;
+    char tailPadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) * 2 - sizeof(std::atomic<uint64_t>)];
+
+    T slots[Capacity];
+};
+
+#endif // V2V_SPSC_QUEUE_H
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+#include "time_source.hpp"
+
+/**
+ * Implementation of the TimeSource, SystemTimeSource and ManualTimeSource classes as declared in time_source.hpp
+ */
+
+TimeSource &TimeSource::system() {
+    static SystemTimeSource source;
+    return source;
+}
+
+TimeSource::time_point SystemTimeSource::now() const {
+    return std::chrono::steady_clock::now();
+}
+
+int64_t SystemTimeSource::wallMicros() const {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+bool SystemTimeSource::waitUntil(std::unique_lock<std::mutex> &lock, std::condition_variable &signal,
+                                 time_point deadline, const std::function<bool()> &done) const {
+    if (deadline == time_point::max()) {
+        // wait_until would overflow converting the deadline to the clock of the condition variable.
+        signal.wait(lock, done);
+        return true;
+    }
+    return signal.wait_until(lock, deadline, done);
+}
+
+void SystemTimeSource::sleepUntil(time_point deadline) const {
+    std::this_thread::sleep_until(deadline);
+}
+
+/**
+ * Constructor for the manual time source.
+ *
+ * @param start - monotonic time to start at, far enough from zero that default constructed time points are in the past
+ * @param wallStartMicros - wall clock time to start at, in microseconds since the Unix epoch
+ */
+ManualTimeSource::ManualTimeSource(time_point start, int64_t wallStartMicros) :
+    start(start), wallStartMicros(wallStartMicros), elapsed(0), wallStepMicros(0), parks(0) {
+    for (size_t slot = 0; slot < MANUAL_TIME_MAX_PARKED; slot++) {
+        parkedDeadlines[slot] = time_point::min();
+        parkedGenerations[slot] = 0;
+        parkedChecks[slot] = 0;
+    }
+}
+
+TimeSource::time_point ManualTimeSource::now() const {
+    return start + duration(elapsed.load());
+}
+
+int64_t ManualTimeSource::wallMicros() const {
+    using namespace std::chrono;
+    return wallStartMicros + duration_cast<microseconds>(duration(elapsed.load())).count() + wallStepMicros.load();
+}
+
+bool ManualTimeSource::waitUntil(std::unique_lock<std::mutex> &lock, std::condition_variable &signal,
+                                 time_point deadline, const std::function<bool()> &done) const {
+    bool parkedHere = false;
+    size_t slot = 0;
+    bool result = true;
+    while (!done()) {
+        if (now() >= deadline) {
+            result = false;
+            break;
+        }
+        if (parkedHere) {
+            checked(slot);
+        } else {
+            slot = park(deadline);
+            parkedHere = true;
+        }
+        signal.wait_for(lock, MANUAL_TIME_POLL_INTERVAL);
+    }
+    if (parkedHere) {
+        unpark(slot);
+    }
+    return result;
+}
+
+void ManualTimeSource::sleepUntil(time_point deadline) const {
+    if (now() >= deadline) {
+        return;
+    }
+    size_t slot = park(deadline);
+    while (now() < deadline) {
+        checked(slot);
+        std::this_thread::sleep_for(MANUAL_TIME_POLL_INTERVAL);
+    }
+    unpark(slot);
+}
+
+/**
+ * Moves the monotonic and the wall clock forward.
+ *
+ * @param step - time to move forward by, negative steps are ignored since the monotonic clock never goes back
+ */
+void ManualTimeSource::advance(duration step) {
+    if (step > duration::zero()) {
+        elapsed.fetch_add(step.count());
+    }
+}
+
+/**
+ * Moves the monotonic and the wall clock forward to the given monotonic time, if it is not in the past already.
+ *
+ * @param time - monotonic time to move to
+ */
+void ManualTimeSource::advanceTo(time_point time) {
+    int64_t target = (time - start).count();
+    int64_t current = elapsed.load();
+    while (current < target && !elapsed.compare_exchange_weak(current, target)) {
+    }
+}
+
+/**
+ * Steps the wall clock only, like NTP correcting the system time. The monotonic clock is not affected.
+ *
+ * @param step - time to step the wall clock by, may be negative
+ */
+void ManualTimeSource::stepWallClock(std::chrono::microseconds step) {
+    wallStepMicros.fetch_add(step.count());
+}
+
+/**
+ * @return number of threads waiting on this time source
+ */
+size_t ManualTimeSource::parked() const {
+    std::lock_guard<std::mutex> lock(parkedMutex);
+    return static_cast<size_t>(std::count_if(std::begin(parkedDeadlines), std::end(parkedDeadlines),
+                                             [](time_point deadline) { return deadline != time_point::min(); }));
+}
+
+/**
+ * @return earliest deadline a thread waits for, time_point::max() if none does
+ */
+TimeSource::time_point ManualTimeSource::nextDeadline() const {
+    std::lock_guard<std::mutex> lock(parkedMutex);
+    time_point next = time_point::max();
+    for (time_point deadline : parkedDeadlines) {
+        if (deadline != time_point::min()) {
+            next = std::min(next, deadline);
+        }
+    }
+    return next;
+}
+
+/**
+ * Waits in real time for the threads waiting on this time source to catch up after it was advanced or they were
+ * signalled: until at least the given number of threads wait again, none of them for a deadline already passed, and
+ * each of them has checked what it waits for since settle was called. A check under way when settle is called may
+ * have looked before the advance or the signal, so threads that were waiting already have to check twice.
+ *
+ * @param threads - number of threads that wait whenever they have nothing to do
+ * @param timeout - real time to give up after, for a thread that went away or waits for something else
+ * @return false if the threads did not settle within the timeout
+ */
+bool ManualTimeSource::settle(size_t threads, std::chrono::milliseconds timeout) const {
+    std::chrono::steady_clock::time_point giveUp = std::chrono::steady_clock::now() + timeout;
+    uint64_t generations[MANUAL_TIME_MAX_PARKED];
+    uint64_t checks[MANUAL_TIME_MAX_PARKED];
+    {
+        std::lock_guard<std::mutex> lock(parkedMutex);
+        std::copy(std::begin(parkedGenerations), std::end(parkedGenerations), std::begin(generations));
+        std::copy(std::begin(parkedChecks), std::end(parkedChecks), std::begin(checks));
+    }
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(parkedMutex);
+            size_t waiting = 0;
+            bool caughtUp = true;
+            for (size_t slot = 0; slot < MANUAL_TIME_MAX_PARKED; slot++) {
+                if (parkedDeadlines[slot] == time_point::min()) {
+                    continue;
+                }
+                waiting++;
+                // A thread that parked since only made the check it parked after, which may be from before.
+                uint64_t required = parkedGenerations[slot] == generations[slot] ? checks[slot] + 2 : 1;
+                caughtUp = caughtUp && parkedChecks[slot] >= required && parkedDeadlines[slot] > now();
+            }
+            if (caughtUp && waiting >= threads) {
+                return true;
+            }
+        }
+        if (std::chrono::steady_clock::now() >= giveUp) {
+            return false;
+        }
+        std::this_thread::sleep_for(MANUAL_TIME_POLL_INTERVAL);
+    }
+}
+
+/*
+ * Takes a free slot for a thread about to wait, MANUAL_TIME_MAX_PARKED if there is none.
+ */
+size_t ManualTimeSource::park(time_point deadline) const {
+    std::lock_guard<std::mutex> lock(parkedMutex);
+    size_t slot = 0;
+    while (slot < MANUAL_TIME_MAX_PARKED && parkedDeadlines[slot] != time_point::min()) {
+        slot++;
+    }
+    if (slot < MANUAL_TIME_MAX_PARKED) {
+        parkedDeadlines[slot] = deadline;
+        parkedGenerations[slot] = ++parks;
+        parkedChecks[slot] = 0;
+    }
+    return slot;
+}
+
+/*
+ * Counts a check a parked thread made that found nothing to do yet.
+ */
+void ManualTimeSource::checked(size_t slot) const {
+    std::lock_guard<std::mutex> lock(parkedMutex);
+    if (slot < MANUAL_TIME_MAX_PARKED) {
+        parkedChecks[slot]++;
+    }
+}
+
+void ManualTimeSource::unpark(size_t slot) const {
+    std::lock_guard<std::mutex> lock(parkedMutex);
+    if (slot < MANUAL_TIME_MAX_PARKED) {
+        parkedDeadlines[slot] = time_point::min();
+    }
+}
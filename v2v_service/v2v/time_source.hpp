@@ -0,0 +1,131 @@
+#ifndef V2V_TIME_SOURCE_H
+#define V2V_TIME_SOURCE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+/**
+ * Where the V2V service gets the time from.
+ *
+ * Timeouts, liveness and scheduling use the monotonic clock, which never jumps when the system time is stepped by NTP
+ * and has at least microsecond resolution. The wall clock is only used for timestamps that leave the car, like the
+ * LeaderStatus timestamp, since the other car cannot make sense of our monotonic clock.
+ *
+ * Monotonic time points are steady_clock time points, so they mix with code that has not been moved onto a time source
+ * yet. All functions may be called from any thread.
+ */
+class TimeSource {
+public:
+    typedef std::chrono::steady_clock::time_point time_point;
+    typedef std::chrono::steady_clock::duration duration;
+
+    virtual ~TimeSource() {}
+
+    // Current time on the monotonic clock.
+    virtual time_point now() const = 0;
+
+    // Current wall clock time in microseconds since the Unix epoch.
+    virtual int64_t wallMicros() const = 0;
+
+    /**
+     * Blocks until the deadline on the monotonic clock has passed or done returns true, whichever comes first. Like
+     * std::condition_variable::wait_until, the lock has to be held and done is only called with it held.
+     *
+     * @param lock - held lock guarding what done checks
+     * @param signal - condition variable notified whenever done may have become true
+     * @param deadline - absolute deadline, time_point::max() to wait for done only
+     * @param done - condition to wait for
+     * @return the last result of done, false if the deadline passed first
+     */
+    virtual bool waitUntil(std::unique_lock<std::mutex> &lock, std::condition_variable &signal, time_point deadline,
+                           const std::function<bool()> &done) const = 0;
+
+    // Blocks until the deadline on the monotonic clock has passed.
+    virtual void sleepUntil(time_point deadline) const = 0;
+
+    // Wall clock time in milliseconds since the Unix epoch, the resolution of the timestamps on the wire.
+    uint64_t wallMillis() const {
+        return (uint64_t) (wallMicros() / 1000);
+    }
+
+    // The time source of the real system, used wherever none is given.
+    static TimeSource &system();
+};
+
+/**
+ * The real clocks, steady_clock for monotonic time and system_clock for wall clock time.
+ */
+class SystemTimeSource : public TimeSource {
+public:
+    time_point now() const override;
+    int64_t wallMicros() const override;
+    bool waitUntil(std::unique_lock<std::mutex> &lock, std::condition_variable &signal, time_point deadline,
+                   const std::function<bool()> &done) const override;
+    void sleepUntil(time_point deadline) const override;
+};
+
+// Real time between two checks of a thread waiting on a ManualTimeSource.
+static const std::chrono::microseconds MANUAL_TIME_POLL_INTERVAL(200);
+// Most threads a ManualTimeSource keeps track of at once, any more still wait but are not tracked.
+static const size_t MANUAL_TIME_MAX_PARKED = 16;
+
+/**
+ * A time source that only moves when it is told to, for testing timing logic in simulated time.
+ *
+ * Threads waiting on it keep waiting until the test advances the time past their deadline. They poll the simulated
+ * time every MANUAL_TIME_POLL_INTERVAL of real time, so a wait ends shortly after the advance that satisfies it. The
+ * wall clock follows the monotonic clock and can additionally be stepped on its own, like NTP would.
+ *
+ * The threads waiting are kept track of, so whoever drives the time can advance it to exactly the next deadline any of
+ * them waits for, and wait with settle for them to have reacted before advancing again. Every check a waiting thread
+ * makes is counted, so settle knows a thread has seen an advance or a signal rather than guessing from real time.
+ * Driven that way, what the threads do in simulated time does not depend on how fast the time is advanced in real time.
+ */
+class ManualTimeSource : public TimeSource {
+public:
+    explicit ManualTimeSource(time_point start = time_point(std::chrono::hours(1)),
+                              int64_t wallStartMicros = 1500000000000000);
+
+    time_point now() const override;
+    int64_t wallMicros() const override;
+    bool waitUntil(std::unique_lock<std::mutex> &lock, std::condition_variable &signal, time_point deadline,
+                   const std::function<bool()> &done) const override;
+    void sleepUntil(time_point deadline) const override;
+
+    void advance(duration step);
+    void advanceTo(time_point time);
+    void stepWallClock(std::chrono::microseconds step);
+
+    size_t parked() const;
+    time_point nextDeadline() const;
+    bool settle(size_t threads, std::chrono::milliseconds timeout) const;
+
+private:
+    size_t park(time_point deadline) const;
+    void checked(size_t slot) const;
+    void unpark(size_t slot) const;
+
+    const time_point start;
+    const int64_t wallStartMicros;
+
+    // Monotonic time passed since start in steady_clock ticks, and the sum of all wall clock steps.
+    std::atomic<int64_t> elapsed;
+    std::atomic<int64_t> wallStepMicros;
+
+    /*
+     * Deadline of each thread waiting, time_point::max() for those waiting for their condition only and
+     * time_point::min() for a free slot, which park of the slot it is and how many checks the thread made since it
+     * parked there that found nothing to do yet. A fixed number of slots, so waiting does not allocate.
+     */
+    mutable std::mutex parkedMutex;
+    mutable time_point parkedDeadlines[MANUAL_TIME_MAX_PARKED];
+    mutable uint64_t parkedGenerations[MANUAL_TIME_MAX_PARKED];
+    mutable uint64_t parkedChecks[MANUAL_TIME_MAX_PARKED];
+    mutable uint64_t parks;
+};
+
+#endif // V2V_TIME_SOURCE_H
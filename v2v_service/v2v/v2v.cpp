@@ -1,6 +1,9 @@
 #include <iostream>
+#include <arpa/inet.h>
 #include "v2v.hpp"
 #include <map>
+#include <functional>
+#include <random>
 
 /**
  * Implementation of the V2VService class as declared in v2v.hpp
@@ -11,16 +14,64 @@
  *
  * @param ip - IP address of the car running the service
  * @param groupId - ID of the car running the service
+ * @param offSteering - steering offset of the car
+ * @param source - clocks to run on, a ManualTimeSource runs the timing logic in simulated time
+ * @param networking - OFFLINE to open no channel or socket, V2V_ONLY for no OD4 channel, see Networking
  */
-V2VService::V2VService(std::string ip, std::string groupId, float offSteering) {
-    followerIp = "";
-    leaderIp = "";
+V2VService::V2VService(const std::string &ip, const std::string &groupId, float offSteering,
+                       const TimeSource &source, Networking networking) :
+    timeSource(source),
+    eventLoop(true, source),
+    liveness(LIVENESS_RESOLUTION, source),
+    peers(PEER_TTL, source),
+    announcer(ANNOUNCE_PERIOD, ANNOUNCE_MAX_PERIOD, ANNOUNCE_JITTER, ANNOUNCE_FAST_DELAY,
+              std::random_device()() ^ (uint32_t) std::hash<std::string>()(groupId)),
+    replayScheduler(source),
+    speedCommands(SPEED_DEADBAND),
+    steeringCommands(STEERING_DEADBAND),
+    sendPool(SEND_POOL_SIZE, networking != Networking::OFFLINE) {
     myIp = ip;
     myGroupId = groupId;
-    currentCarStatus.speed = 0;
-    currentCarStatus.steeringAngle = 0;
+    currentCarStatus.store(CarStatus{0, 0, timeSource.now()});
     steeringOffset = offSteering;
+    leaderFraming = Framing::LEGACY_HEX;
+    groupsResponseMode = GroupsResponseMode::BATCHED;
+    followMode = FollowMode::TIME;
+    leaderStatusMode = LeaderStatusMode::UNICAST;
+    announcementsSent = 0;
+    announcementsReceived = 0;
+    leaderStatusTask = 0;
+    followerStatusTask = 0;
+    leaderWindowTask = 0;
+    leaderSequence = 0;
+    isLeaderMoving = false;
+    followRequestSent = std::chrono::steady_clock::time_point();
+    lastLeaderStatus = std::chrono::steady_clock::time_point();
     
+    if (networking == Networking::LIVE) {
+        openChannels();
+        listen("0.0.0.0");
+    } else if (networking == Networking::V2V_ONLY) {
+        sendPool.bindTo(ip);
+        listen(ip);
+    }
+
+    // Statuses due in the same round of the event loop go out with a single system call.
+    eventLoop.setAfterTasks([this]() { sendPool.flush(); });
+    eventLoop.arm(PEER_EXPIRY_INTERVAL, [this]() { peers.expire(); });
+    eventLoop.arm(ANNOUNCE_TICK, [this]() {
+        if (announcer.due(timeSource.now())) {
+            announcePresence();
+        }
+    });
+    startAnnouncing();
+    followerThread = std::thread(&V2VService::runFollowerThread, this);
+} // end constructor
+
+/**
+ * Joins the OD4 channels, only done by a LIVE service.
+ */
+void V2VService::openChannels() {
     /*
      * The broadcast field contains a reference to the broadcast channel which is an OD4Session. This channel is where
      * AnnouncePresence messages will be received.
@@ -32,15 +83,23 @@ V2VService::V2VService(std::string ip, std::string groupId, float offSteering) {
             switch (envelope.dataType()) {
                 case ANNOUNCE_PRESENCE: {
                     AnnouncePresence ap = cluon::extractMessage<AnnouncePresence>(std::move(envelope));
-                    std::cout << "[BROADCAST] received 'AnnouncePresence' from '"
-                              << ap.vehicleIp() << "', GroupID '"
-                              << ap.groupId() << "'!" << std::endl;
 
                     // Filter out yourself from announcement
-                    if (ap.groupId() != myGroupId) {
-                        mapOfIps.insert(std::make_pair(ap.groupId(), ap.vehicleIp()));
-                        mapOfIds[ap.vehicleIp()] = ap.groupId(); // Map for being able to get a groupid
-                    }                                            // from an IP as well.
+                    if (ap.groupId() == myGroupId) {
+                        break;
+                    }
+                    announcementsReceived++;
+
+                    // Cars keep announcing themselves, only a car that is new, moved or changed is worth reporting,
+                    // and answering early so it learns about us as well.
+                    if (peers.announce(ap.groupId(), ap.vehicleIp(), ap.capabilities())) {
+                        V2V_LOG(INFO) << "[BROADCAST] received 'AnnouncePresence' from '"
+                                      << ap.vehicleIp() << "', GroupID '"
+                                      << ap.groupId() << "'!";
+                        announcer.peersChanged(timeSource.now());
+                    } else {
+                        V2V_LOG(DEBUG) << "[BROADCAST] received 'AnnouncePresence' from '" << ap.vehicleIp() << "'";
+                    }
 
                     break;
                 }
@@ -67,15 +126,17 @@ V2VService::V2VService(std::string ip, std::string groupId, float offSteering) {
                 case INTERNAL_FOLLOW_REQUEST: {
                     InternalFollowRequest msg = cluon::extractMessage<InternalFollowRequest>(std::move(envelope));
 
-                    // In case we already have a leader, we return an internal follow response with
-                    // a negative result code right away.
-                    if (leaderIp.empty()){
-                        followRequest(mapOfIps[msg.groupid()]);
+                    // In case we already have a leader or do not know the car, we return an internal follow
+                    // response with a negative result code right away.
+                    std::shared_ptr<const PeerSnapshot> known = peers.snapshot();
+                    const PeerEntry *target = known->byGroupId(msg.groupid());
+                    if (std::atomic_load(&toLeader) == nullptr && target != nullptr) {
+                        followRequest(target->ip);
                     } else {
-                        InternalFollowResponse msg;
-                        msg.groupid(msg.groupid());
-                        msg.status(0);
-                        internalBroadCast->send(msg);
+                        InternalFollowResponse response;
+                        response.groupid(msg.groupid());
+                        response.status(0);
+                        sendInternal(response);
                     }
 
                     break;
@@ -87,20 +148,12 @@ V2VService::V2VService(std::string ip, std::string groupId, float offSteering) {
 
                     InternalStopFollowResponse retmsg;
                     retmsg.groupid(msg.groupid());
-                    internalBroadCast->send(retmsg);
+                    sendInternal(retmsg);
 
                     break;
                 }
                 case INTERNAL_GET_ALL_GROUPS_REQUEST: {
-                    InternalGetAllGroupsRequest msg = cluon::extractMessage<InternalGetAllGroupsRequest>(std::move(envelope));
-
-                    // Iterate over the internal map of IPs and send the groupids back to the requester.
-                    std::map<std::string, std::string> ipMap = getMapOfIps();
-                    for(std::map<std::string, std::string>::iterator it = ipMap.begin(); it != ipMap.end(); ++it) {
-                        InternalGetAllGroupsResponse msg;
-                        msg.groupid(it->first);
-                        internalBroadCast->send(msg);
-                    }
+                    sendAllGroups();
                     break;
                 }
                 case INTERNAL_EMERGENCY_BRAKE: {
@@ -108,7 +161,7 @@ V2VService::V2VService(std::string ip, std::string groupId, float offSteering) {
                     // Terminate communication with any other vehicle.
                     stopFollow();
 
-                    std::cout << "received '" << msg.LongName() << std::endl;
+                    V2V_LOG(WARNING) << "received '" << msg.LongName();
                     break;
                 }
                 default: {
@@ -130,14 +183,22 @@ V2VService::V2VService(std::string ip, std::string groupId, float offSteering) {
             switch (envelope.dataType()) {
                 case PEDAL_POSITION_READING: {
                     PedalPositionReading msg = cluon::extractMessage<PedalPositionReading>(std::move(envelope));
-                    currentCarStatus.speed = msg.percent();
+
+                    // We are the only writer, so reading the status back and updating one field of it is safe.
+                    CarStatus status = currentCarStatus.load();
+                    status.speed = msg.percent();
+                    status.sampled = timeSource.now();
+                    currentCarStatus.store(status);
                     break;
                 }
                 case GROUND_STEERING_READING: {
                     GroundSteeringReading msg = cluon::extractMessage<GroundSteeringReading>(std::move(envelope));
-                    currentCarStatus.steeringAngle = msg.steeringAngle();
+                    CarStatus status = currentCarStatus.load();
+                    status.steeringAngle = msg.steeringAngle();
+                    status.sampled = timeSource.now();
+                    currentCarStatus.store(status);
 
-                    std::cout << "New steering: " << msg.steeringAngle() << std::endl;
+                    V2V_LOG(DEBUG) << "New steering: " << msg.steeringAngle();
 
                     break;
                 }
@@ -160,7 +221,7 @@ V2VService::V2VService(std::string ip, std::string groupId, float offSteering) {
                     //{
                     //	stopCar();
                     //    InternalEmergencyBrake stopped; 
-                    //    internalBroadCast->send(stopped);
+                    //    sendInternal(stopped);
                     //}
                     break;
                 }
@@ -170,120 +231,180 @@ V2VService::V2VService(std::string ip, std::string groupId, float offSteering) {
             } // end switch
         } // end lambda
     ); // end motorBroadcast declaration
+}
 
+/**
+ * Starts listening for other cars on DEFAULT_PORT.
+ *
+ * @param address - local address to listen on, 0.0.0.0 for all of them
+ */
+void V2VService::listen(const std::string &address) {
     /*
      * Each car declares an incoming UDPReceiver for messages directed at them specifically. This is where messages
      * such as FollowRequest, FollowResponse, StopFollow, etc. are received.
      */
     incoming = std::make_shared<cluon::UDPReceiver>(
-        "0.0.0.0",
+        address,
         DEFAULT_PORT,
         [this](std::string &&data, std::string &&sender, std::chrono::system_clock::time_point /*&&ts*/) noexcept {
-            std::pair<int16_t, std::string> msg = extract(data);
-
-            std::string senderIp = sender.substr(0, sender.find(":"));
-
-            switch (msg.first) {
-                case FOLLOW_REQUEST: {
-                    FollowRequest followRequest = decode<FollowRequest>(msg.second);
-                    std::cout << "[INCOMING] received '" << followRequest.LongName()
-                               << "' from '" << senderIp << "'!" << std::endl;
-                               
-                    // Propagate the message to internal for visualization
-                    internalBroadCast->send(followRequest);
-
-                    // After receiving a FollowRequest, check first if there is currently no car already following.
-                    if (followerIp.empty()) {
-                        followerIp = senderIp; // If no, add the requester to known follower slot and establish a
-                        // sending channel.
-                        toFollower = std::make_shared<cluon::UDPSender>(followerIp, DEFAULT_PORT);
-                        followResponse();
-
-                        startReportingToFollower();
-                    }
-                    break;
-                }
-                case FOLLOW_RESPONSE: {
-                    FollowResponse followResponse = decode<FollowResponse>(msg.second);
-                    std::cout << "[INCOMING] received '" << followResponse.LongName()
-                              << "' from '" << senderIp << "'!" << std::endl;
-                              
-                    internalBroadCast->send(followResponse);
-
-                    // Makes sure we do not accept any rogue responses.
-                    if (senderIp == leaderIp) {
-                        isLeaderMoving = false; // Until we receive the first leader status, we assume the leader is standstill.
-                        
-                        startReportingToLeader();
-                        
-                        startFollowing();
-
-                        InternalFollowResponse msg;
-                        msg.groupid(mapOfIds[senderIp]);
-                        msg.status(1);
-                        internalBroadCast->send(msg);
-                    }
-                    break;
-                }
-                case STOP_FOLLOW: {
-                    StopFollow stopFollow = decode<StopFollow>(msg.second);
-                    std::cout << "[INCOMING] received '" << stopFollow.LongName()
-                              << "' from '" << senderIp << "'!" << std::endl;
-                              
-                    internalBroadCast->send(stopFollow);
-
-                    // Clear either follower or leader slot, depending on current role.
-                    if (senderIp == followerIp) {
-                        followerIp = "";
-                        toFollower.reset();
-                        lastFollowerUpdate = 0;
-                    }
-                    else if (senderIp == leaderIp) {
-                        leaderIp = "";
-                        toLeader.reset();
-                        lastLeaderUpdate = 0;
-                        
-                        // If it was the leader who sent the stop follow, we should also stop our car.
-                        stopCar();
-                    }
-                    
-                    break;
-                }
-                case FOLLOWER_STATUS: {
-                    FollowerStatus followerStatus = decode<FollowerStatus>(msg.second);
-                    std::cout << "[INCOMING] received '" << followerStatus.LongName()
-                              << "' from '" << senderIp << "'!" << std::endl;
-                              
-                    internalBroadCast->send(followerStatus);
-
-                    // If we have a follower, update the last received time for follower status.
-                    if (!followerIp.empty()) {
-                        lastFollowerUpdate = getTime();
-                    }
+            receiveDatagram(data, sender.substr(0, sender.find(":")));
+        }
+    ); // end incoming declaration
+}
 
-                    break;
-                }
-                case LEADER_STATUS: {
-                    LeaderStatus leaderStatus = decode<LeaderStatus>(msg.second);
-                    std::cout << "[INCOMING] received '" << leaderStatus.LongName() <<
-                                 " - New speed = " << leaderStatus.speed() <<
-                                 " - New steering = " << leaderStatus.steeringAngle() << std::endl;
-                                 
-                    internalBroadCast->send(leaderStatus);
-
-                    // Only process the messages from the leader.
-                    if (senderIp == leaderIp) {
-                        processLeaderStatus(leaderStatus);
-                    }
-                    break;
+/**
+ * Handles a datagram another car sent us, as received on DEFAULT_PORT. Called by the receiver of a LIVE service, and
+ * for testing an OFFLINE one.
+ *
+ * @param data - the datagram
+ * @param senderIp - IP of the sending car
+ */
+void V2VService::receiveDatagram(const std::string &data, const std::string &senderIp) {
+    int64_t receivedMicros = timeSource.wallMicros();
+
+    // The payload view points into data, which stays alive for the whole call.
+    Frame msg = extractFrame(data);
+
+    switch (msg.id) {
+        case FOLLOW_REQUEST: {
+            FollowRequest followRequest = decodePayload<FollowRequest>(msg.payload);
+            V2V_LOG(INFO) << "[INCOMING] received '" << followRequest.LongName()
+                          << "' from '" << senderIp << "'!";
+                       
+            // Propagate the message to internal for visualization
+            sendInternal(followRequest, senderIp);
+
+            // Cars of other groups leave the framing field empty and keep getting the legacy header.
+            Framing framing = followRequest.framing() == static_cast<uint8_t>(Framing::BINARY) ?
+                              Framing::BINARY : Framing::LEGACY_HEX;
+            std::shared_ptr<Follower> follower = followers.add(senderIp,
+                                                               sendPool.acquire(senderIp, DEFAULT_PORT),
+                                                               framing);
+            if (follower == nullptr) {
+                V2V_LOG(WARNING) << "Already " << MAX_FOLLOWERS << " followers, ignoring '" << senderIp
+                                 << "'!";
+                break;
+            }
+            followResponse(senderIp);
+            startReportingToFollower(follower);
+            break;
+        }
+        case FOLLOW_RESPONSE: {
+            FollowResponse followResponse = decodePayload<FollowResponse>(msg.payload);
+            V2V_LOG(INFO) << "[INCOMING] received '" << followResponse.LongName()
+                          << "' from '" << senderIp << "'!";
+                      
+            sendInternal(followResponse, senderIp);
+
+            // Makes sure we do not accept any rogue responses.
+            if (isLeader(senderIp)) {
+                leaderFraming = followResponse.framing() == static_cast<uint8_t>(Framing::BINARY) ?
+                                Framing::BINARY : Framing::LEGACY_HEX;
+
+                isLeaderMoving = false; // Until we receive the first leader status, we assume the leader is standstill.
+                
+                startReportingToLeader();
+                liveness.recordRtt(LEADER_PEER, std::chrono::duration_cast<std::chrono::microseconds>(
+                    timeSource.now() - followRequestSent.load()));
+                
+                startFollowing();
+
+                // Leaders of other groups do not offer a multicast group, nor do ours unless asked to.
+                lastLeaderStatus = timeSource.now();
+                if (leaderStatusMode == LeaderStatusMode::MULTICAST && leaderFraming == Framing::BINARY &&
+                    !followResponse.multicastGroup().empty()) {
+                    joinLeaderGroup(followResponse.multicastGroup(), followResponse.multicastPort());
                 }
-                default: {
-                    break;
+
+                std::shared_ptr<const PeerSnapshot> known = peers.snapshot();
+                const PeerEntry *leader = known->byIp(senderIp);
+
+                InternalFollowResponse msg;
+                msg.groupid(leader != nullptr ? leader->groupId : "");
+                msg.status(1);
+                sendInternal(msg);
+            }
+            break;
+        }
+        case STOP_FOLLOW: {
+            StopFollow stopFollow = decodePayload<StopFollow>(msg.payload);
+            V2V_LOG(INFO) << "[INCOMING] received '" << stopFollow.LongName()
+                          << "' from '" << senderIp << "'!";
+                      
+            sendInternal(stopFollow, senderIp);
+
+            // Clear either follower or leader slot, depending on current role.
+            if (followers.find(senderIp) != nullptr) {
+                dropFollower(senderIp, false);
+            }
+            else if (isLeader(senderIp)) {
+                stopReportingToLeader();
+                leaveLeaderGroup();
+                endFollowing();
+                std::atomic_store(&toLeader, std::shared_ptr<PeerSendContext>());
+                leaderFraming = Framing::LEGACY_HEX;
+                
+                // If it was the leader who sent the stop follow, we should also stop our car.
+                stopCar();
+            }
+            
+            break;
+        }
+        case FOLLOWER_STATUS: {
+            FollowerStatus followerStatus = decodePayload<FollowerStatus>(msg.payload);
+            V2V_LOG(DEBUG) << "[INCOMING] received '" << followerStatus.LongName()
+                           << "' from '" << senderIp << "'!";
+                      
+            sendInternal(followerStatus, senderIp);
+
+            // If it is one of our followers, it is still alive.
+            std::shared_ptr<Follower> follower = followers.find(senderIp);
+            if (follower != nullptr) {
+                liveness.heard(follower->peer);
+                follower->clock.processFollowerStatus(followerStatus, receivedMicros);
+
+                bool joined = followerStatus.multicast() != 0;
+                if (follower->multicast.exchange(joined) != joined) {
+                    V2V_LOG(INFO) << "Follower '" << senderIp << "' "
+                                  << (joined ? "joined" : "left") << " the multicast group!";
                 }
-            } // end switch
-        } // end lambda
-    ); // end incoming declaration
-} // end constructor
+            }
+
+            break;
+        }
+        case LEADER_STATUS: {
+            receiveLeaderStatus(msg, senderIp, receivedMicros);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+/**
+ * Destructor for the V2V service class. Stops the follower thread and the event loop before the channels they use go
+ * away, then closes the channels so no callback can reach the service while it is being destroyed.
+ */
+V2VService::~V2VService() {
+    {
+        std::lock_guard<std::mutex> lock(followMutex);
+        shuttingDown = true;
+        followActive = false;
+        followSignal.notify_all();
+    }
+    if (followerThread.joinable()) {
+        followerThread.join();
+    }
+    eventLoop.stop();
+
+    leaveLeaderGroup();
+
+    incoming.reset();
+    broadcast.reset();
+    internalBroadCast.reset();
+    motorBroadcast.reset();
+}
 
 /**
  * This function sends an AnnouncePresence (id = 1001) message on the broadcast channel. It will contain information
@@ -293,112 +414,201 @@ void V2VService::announcePresence() {
     AnnouncePresence announcePresence;
     announcePresence.vehicleIp(myIp);
     announcePresence.groupId(myGroupId);
-    broadcast->send(announcePresence);
+    announcePresence.capabilities(CAPABILITY_BINARY_FRAMING | CAPABILITY_CLOCK_SYNC);
+    if (broadcast != nullptr) {
+        broadcast->send(announcePresence);
+    }
+    announcementsSent++;
+    announcer.sent(timeSource.now());
+}
+
+/**
+ * Announces our presence on a schedule from now on, with the given periods randomly jittered. The period backs off
+ * to the maximum while no new car shows up, see AnnounceScheduler.
+ *
+ * @param period - interval between announcements while cars come and go
+ * @param maxPeriod - interval the back off stops at, should stay well below PEER_TTL
+ */
+void V2VService::startAnnouncing(std::chrono::milliseconds period, std::chrono::milliseconds maxPeriod) {
+    announcer.setPeriod(period, maxPeriod);
+    announcer.start(timeSource.now());
+}
+
+/**
+ * Stops announcing automatically, announcePresence still announces on request.
+ */
+void V2VService::stopAnnouncing() {
+    announcer.stop();
+}
+
+uint64_t V2VService::getAnnouncementsSent() const {
+    return announcementsSent;
+}
+
+uint64_t V2VService::getAnnouncementsReceived() const {
+    return announcementsReceived;
 }
 
 /**
  * This function sends a FollowRequest (id = 1002) message to the IP address specified by the parameter vehicleIp. And
- * sets the current leaderIp field of the sending vehicle to that of the target of the request.
+ * makes the target of the request our leader, unless we already have one. We can follow a car while being followed
+ * ourselves, the convoy is then a chain, but not one of our own followers.
  *
  * @param vehicleIp - IP of the target for the FollowRequest
  */
-void V2VService::followRequest(std::string vehicleIp) {
-    if (!leaderIp.empty()) return;
-    leaderIp = vehicleIp;
-    toLeader = std::make_shared<cluon::UDPSender>(leaderIp, DEFAULT_PORT);
+void V2VService::followRequest(const std::string &vehicleIp) {
+    if (std::atomic_load(&toLeader) != nullptr || followers.find(vehicleIp) != nullptr) return;
+    std::shared_ptr<PeerSendContext> leader = sendPool.acquire(vehicleIp, DEFAULT_PORT);
+    std::shared_ptr<PeerSendContext> none;
+    if (!std::atomic_compare_exchange_strong(&toLeader, &none, leader)) return;
+    leaderFraming = Framing::LEGACY_HEX;
+
+    // The request itself always goes out with the legacy header since we do not know what the target understands yet,
+    // but it advertises that we accept binary framing.
     FollowRequest followRequest;
-    toLeader->send(encode(followRequest));
+    followRequest.framing(static_cast<uint8_t>(Framing::BINARY));
+    leaderClock.reset();
+    followRequestSent = timeSource.now();
+    sendPool.send(leader, followRequest, Framing::LEGACY_HEX);
     
-    internalBroadCast->send(followRequest);
+    sendInternal(followRequest);
 }
 
 /**
  * This function send a FollowResponse (id = 1003) message and is sent in response to a FollowRequest (id = 1002).
- * This message will contain the NTP server IP for time synchronization between the target and the senderIp.
+ * It advertises that we accept binary framing, which the follower will use from then on if it supports it as well,
+ * and the multicast group we send our statuses to if we multicast.
+ * Clocks are not synchronised through an NTP server, the follower estimates our clock offset from the status messages
+ * instead, see ClockSync.
+ *
+ * @param followerIp - IP of the follower that sent the FollowRequest
  */
-void V2VService::followResponse() {
-    if (followerIp.empty()) return;
+void V2VService::followResponse(const std::string &followerIp) {
+    std::shared_ptr<Follower> follower = followers.find(followerIp);
+    if (follower == nullptr) return;
     FollowResponse followResponse;
-    toFollower->send(encode(followResponse));
+    followResponse.framing(static_cast<uint8_t>(Framing::BINARY));
+    // Only our own cars know the multicast fields, and they all understand binary framing.
+    std::shared_ptr<PeerSendContext> group = followers.multicastGroup();
+    if (group != nullptr && follower->framing == Framing::BINARY) {
+        followResponse.multicastGroup(group->ip());
+        followResponse.multicastPort(group->port());
+    }
+    sendPool.send(follower->sender, followResponse, follower->framing);
     
-    internalBroadCast->send(followResponse);
+    sendInternal(followResponse);
 }
 
 /**
- * This function sends a StopFollow (id = 1004) request on the ip address of the parameter vehicleIp. If the IP address
- * is neither that of the follower nor the leader, this function ends without sending the request message.
- *
- * @param vehicleIp - IP of the target for the request
+ * This function sends a StopFollow (id = 1004) message to our leader and to every follower, ending all sessions.
  */
 void V2VService::stopFollow() {
+    // Nothing is reported or actuated for this session anymore.
+    stopReportingToLeader();
+    leaveLeaderGroup();
+    std::vector<std::shared_ptr<Follower>> dropped = stopReportingToFollowers();
+    endFollowing();
+
     // Clear comm channels
     StopFollow stopFollow;
-    if (leaderIp != "") {
-    	toLeader->send(encode(stopFollow));
-    	leaderIp = "";
-     	toLeader.reset();
+    std::shared_ptr<PeerSendContext> leader = std::atomic_exchange(&toLeader, std::shared_ptr<PeerSendContext>());
+    if (leader != nullptr) {
+        sendPool.queue(leader, stopFollow, leaderFraming);
+    }
+    for (const std::shared_ptr<Follower> &follower : dropped) {
+        sendPool.queue(follower->sender, stopFollow, follower->framing);
+    }
+    // Leader and followers are told at once.
+    sendPool.flush();
+
+    if (leader != nullptr) {
+     	leaderFraming = Framing::LEGACY_HEX;
      	
      	// If we want to stop following the leader, we need to stop our car.
      	stopCar();
     }
-    if (followerIp != "") {
-	    toFollower->send(encode(stopFollow));
-     	followerIp = "";
-     	toFollower.reset();
-    }
-    
-    // Clear timestamps
-    lastFollowerUpdate = 0;
-    lastLeaderUpdate = 0;
     
     isLeaderMoving = false;
     
-    internalBroadCast->send(stopFollow);
+    sendInternal(stopFollow);
 }
 
 /**
- * This function is designed to be the target of a pthread starting. It will take care of sending FollowerStatus
- * messages to the leading car as well as check that the leading car has been sending regular updates.
- *
- * @param v2v - the v2v service object reference from which this thread function will both take and get information from
- * @return N/A
+ * Event loop task sending FollowerStatus messages to the leading car.
  */
-void *sendFollowerStatuses(void *v2v) {
-    V2VService *v2vservice;
-    v2vservice = (V2VService *)v2v;
-    std::cout << "Send follower status thread started!" << std::endl;
-
-    using namespace std::chrono_literals;
-    while (!v2vservice->leaderIp.empty()) {        
+void V2VService::reportToLeader() {
+    // The group of our leader does not reach us, the status going out now asks for unicast again.
+    if (std::atomic_load(&leaderGroup) != nullptr &&
+        timeSource.now() - lastLeaderStatus.load() > MULTICAST_FALLBACK_TIMEOUT) {
+        V2V_LOG(WARNING) << "No leader status through the multicast group, falling back to unicast!";
+        leaveLeaderGroup();
+    }
+    queueFollowerStatus();
+}
 
-        // Since leader updates are more frequent than follower statuses,
-        // we disconnect after only two seconds of radio silence.
-        if ((v2vservice->getTime() - v2vservice->lastLeaderUpdate) > 1000) {
-            v2vservice->stopFollow();
-            break;
-        }
+/**
+ * This function arms the event loop task that will take care of sending statuses to the leading vehicle, and starts
+ * watching the leader for leader statuses.
+ */
+void V2VService::startReportingToLeader() {
+    stopReportingToLeader();
+    {
+        // The leader counts its statuses from 1 again for every session.
+        std::lock_guard<std::mutex> lock(leaderStatusMutex);
+        leaderWindow.reset();
+    }
+    watchPeer(LEADER_PEER, LEADER_TIMEOUT, LEADER_STATUS_INTERVAL, [this](const std::string &lost) {
+        V2V_LOG(WARNING) << "Lost the " << lost << ", stopping!";
+        stopFollow();
+    });
+    followerStatusTask = eventLoop.arm(FOLLOWER_STATUS_INTERVAL, [this]() { reportToLeader(); });
+    leaderWindowTask = eventLoop.arm(REORDER_TICK, [this]() { expireLeaderWindow(); });
+}
 
-        v2vservice->followerStatus();
-        std::this_thread::sleep_for(500ms);
+/**
+ * This function disarms the task sending statuses to the leading vehicle, if it is armed, and stops watching the
+ * leader.
+ */
+void V2VService::stopReportingToLeader() {
+    EventLoop::TaskId task = followerStatusTask.exchange(0);
+    if (task != 0) {
+        eventLoop.disarm(task);
+    }
+    task = leaderWindowTask.exchange(0);
+    if (task != 0) {
+        eventLoop.disarm(task);
     }
+    liveness.forget(LEADER_PEER);
+}
+
+/**
+ * Starts watching a peer.
+ *
+ * @param peer - LEADER_PEER or the peer name of a follower
+ * @param timeout - silence after which the peer is lost
+ * @param interval - interval the peer sends statuses at
+ * @param onLoss - called from the event loop if nothing is heard from the peer for the timeout
+ */
+void V2VService::watchPeer(const std::string &peer, std::chrono::milliseconds timeout,
+                           std::chrono::milliseconds interval, LivenessTracker::LossCallback onLoss) {
+    std::lock_guard<std::mutex> lock(livenessMutex);
+    liveness.watch(peer, timeout, interval, std::move(onLoss));
 
-    pthread_exit(NULL);
+    if (livenessTask == 0) {
+        livenessTask = eventLoop.arm(liveness.resolution(), [this]() { tickLiveness(); });
+    }
 }
 
 /**
- * This function starts the thread that will take care of sending statuses to the leading vehicle.
+ * Event loop task advancing the liveness tracker, disarms itself once no peer is watched anymore.
  */
-void V2VService::startReportingToLeader() {
-    // Get time before reporting was started to break connection in case no updates are received for over one second
-    lastLeaderUpdate = getTime();
+void V2VService::tickLiveness() {
+    liveness.tick();
 
-    int status;
-    pthread_t threadId;
-    status = pthread_create(&threadId, NULL, sendFollowerStatuses, (void *)this);
-    
-    // pthread_create returns 1 if an error occured.
-    if (status) {
-        std::cout << "Error creating update leader thread" << std::endl;
+    std::lock_guard<std::mutex> lock(livenessMutex);
+    if (liveness.watchedPeers().empty() && livenessTask != 0) {
+        eventLoop.disarm(livenessTask);
+        livenessTask = 0;
     }
 }
 
@@ -406,177 +616,443 @@ void V2VService::startReportingToLeader() {
  * This function sends a FollowerStatus (id = 3001) message on the leader channel.
  */
 void V2VService::followerStatus() {
-    if (leaderIp.empty()) return;
+    queueFollowerStatus();
+    sendPool.flush();
+}
+
+/**
+ * Queues a FollowerStatus (id = 3001) message for the leader, it goes out with the next flush of the send pool.
+ */
+void V2VService::queueFollowerStatus() {
+    std::shared_ptr<PeerSendContext> leader = std::atomic_load(&toLeader);
+    if (leader == nullptr) return;
     FollowerStatus followerStatus;
-    toLeader->send(encode(followerStatus));
+    leaderClock.stampFollowerStatus(followerStatus, timeSource.wallMicros());
+    followerStatus.multicast(std::atomic_load(&leaderGroup) != nullptr ? 1 : 0);
+    sendPool.queue(leader, followerStatus, leaderFraming);
     
-    internalBroadCast->send(followerStatus);
+    sendInternal(followerStatus);
 }
 
 /**
- * This function is designed to be the target of a pthread starting. It will take care of sending FollowerStatus
- * messages to the leading car as well as check that the leading car has been sending regular updates.
+ * Body of the follower thread. Waits for a follow session to start and runs the actuation for the follow mode the
+ * session was started with until it ends, for as long as the service exists.
+ */
+void V2VService::runFollowerThread() {
+    std::unique_lock<std::mutex> lock(followMutex);
+    while (true) {
+        followSignal.wait(lock, [this] { return shuttingDown || followActive; });
+        if (shuttingDown) {
+            break;
+        }
+        followerBusy = true;
+        FollowMode mode = sessionMode;
+        lock.unlock();
+
+        if (mode == FollowMode::DISTANCE) {
+            followLeaderTrail();
+        } else {
+            executeLeaderUpdates();
+        }
+
+        lock.lock();
+        followerBusy = false;
+        followSignal.notify_all();
+    }
+    followerBusy = false;
+    followSignal.notify_all();
+}
+
+/**
+ * @return true while a follow session is running
+ */
+bool V2VService::isFollowing() {
+    std::lock_guard<std::mutex> lock(followMutex);
+    return followActive && !shuttingDown;
+}
+
+/**
+ * Sleeps until the given deadline, but wakes up as soon as the follow session ends or, if given, wake returns true.
  *
- * @param v2v - the v2v service object reference from which this thread function will both take and get information from
- * @return N/A
+ * @param deadline - absolute deadline on the monotonic clock
+ * @param wake - checked with followMutex held whenever followSignal is notified, see wakeFollower
+ * @return false if the session ended
+ */
+bool V2VService::waitWhileFollowing(std::chrono::steady_clock::time_point deadline,
+                                    const std::function<bool()> &wake) {
+    std::unique_lock<std::mutex> lock(followMutex);
+    timeSource.waitUntil(lock, followSignal, deadline, [this, &wake] {
+        return shuttingDown || !followActive || (wake && wake());
+    });
+    return followActive && !shuttingDown;
+}
+
+/**
+ * Ends the current follow session, the follower thread leaves it at its next wake up.
+ */
+void V2VService::endFollowing() {
+    std::lock_guard<std::mutex> lock(followMutex);
+    followActive = false;
+    followSignal.notify_all();
+}
+
+/**
+ * Wakes up the follower thread if it waits for something to actuate. Taking followMutex orders the change it is woken
+ * up for before its check, so the wake up cannot fall between the check and the wait.
  */
-void *executeLeaderUpdates(void *v2v) {
-    V2VService *v2vservice;
-    v2vservice = (V2VService *)v2v;
+void V2VService::wakeFollower() {
+    std::lock_guard<std::mutex> lock(followMutex);
+    followSignal.notify_all();
+}
 
-    std::queue<std::pair<uint64_t, LeaderStatus>> *updateQueue;
-    updateQueue = v2vservice->getLeaderUpdates(); // Get reference to leader status update queue
-    std::cout << "Execute leader updates thread started!" << std::endl;
+/**
+ * Time based actuation, run on the follower thread for the length of a follow session. Replays queued leader updates
+ * with the same spacing as the leader timestamps.
+ */
+void V2VService::executeLeaderUpdates() {
+    V2V_LOG(INFO) << "Executing leader updates!";
 
-    std::pair<uint64_t, LeaderStatus> currentUpdate;
+    // Popped into in place, the update is only ever read through a reference.
+    LeaderUpdate currentUpdate;
+    const LeaderStatus &leaderStatus = currentUpdate.second;
     float lastSteering = 0;
-    LeaderStatus leaderStatus;
 
+    replayScheduler.reset();
 
     using namespace std::chrono_literals;
-    while (!v2vservice->leaderIp.empty()) {        
+    while (isFollowing()) {
 
         // If leader car is moving and the update queue is not empty...
-        if (v2vservice->isLeaderMoving && !updateQueue->empty()) {
+        if (isLeaderMoving && leaderUpdates.pop(currentUpdate)) {
             /*
-             * If leader is moving, pop the update queue and wait for the set time before actuating.
+             * If leader is moving, pop the update queue and wait until the update is due. Updates are replayed with
+             * the same spacing as the leader timestamps, against absolute deadlines so errors do not add up.
              */
-            currentUpdate = updateQueue->front();
-            updateQueue->pop();
-            std::chrono::milliseconds sleepTime(currentUpdate.first);
-            std::cout << "Sleeping for before executing queued update..." << std::endl;
-            std::this_thread::sleep_for(sleepTime);
-
-            std::cout << "Executing queued leader status!" << std::endl;
-            leaderStatus = currentUpdate.second;
-
-            // If we're evening out...
+            // If we're evening out, hold the previous steering a little longer.
+            std::chrono::milliseconds extraDelay = 0ms;
             if (leaderStatus.steeringAngle() == 0 && lastSteering > 0) {
-                std::this_thread::sleep_for(150ms);
+                extraDelay = 150ms;
             }
 
-            v2vservice->sendSpeed(leaderStatus.speed());
-            v2vservice->sendSteering(leaderStatus.steeringAngle());
+            replayScheduler.setLeaderClockDrift(leaderClock.driftPpm());
+            ReplayScheduler::Clock::time_point deadline = replayScheduler.schedule(currentUpdate.first, extraDelay);
+            V2V_LOG(DEBUG) << "Waiting before executing queued update...";
+            if (!waitWhileFollowing(deadline)) {
+                break;
+            }
+            replayScheduler.recordActuation(deadline);
+
+            V2V_LOG(DEBUG) << "Executing queued leader status!";
+            sendSpeed(leaderStatus.speed());
+            sendSteering(leaderStatus.steeringAngle());
 
             // Last executed steering
             lastSteering = leaderStatus.steeringAngle();
             
-        } else if (!v2vservice->isLeaderMoving) {
+        } else if (!isLeaderMoving) {
             /*
              * Necessary for a special case where during the above sleep the leader stops moving and we execute the
              * command towards the motor anyway. We should then fall into here and stop the car shortly thereafter.
+             * The pause is not part of what we replay, so the schedule starts over once the leader moves again.
+             *
+             * Then we sleep until the leader moves again, waking up to repeat the stop as often as the motor commands
+             * are kept alive anyway.
              */
-            v2vservice->stopCar();
-            std::this_thread::sleep_for(50ms);
+            replayScheduler.reset();
+            stopCar();
+            waitWhileFollowing(timeSource.now() + ACTUATION_KEEP_ALIVE, [this] { return isLeaderMoving.load(); });
+        } else {
+            // The leader moves but its next update has not arrived yet.
+            waitWhileFollowing(timeSource.now() + ACTUATION_KEEP_ALIVE, [this] {
+                return !isLeaderMoving || !leaderUpdates.empty();
+            });
         }
     }
+}
+
+/**
+ * Distance based actuation, run on the follower thread for the length of a follow session. Instead of replaying leader
+ * updates after a delay it steps along the leader's trail at a fixed rate and actuates whenever the trail yields a new
+ * command.
+ */
+void V2VService::followLeaderTrail() {
+    V2V_LOG(INFO) << "Following leader trail!";
 
-    pthread_exit(NULL);
+    using namespace std::chrono;
+    steady_clock::time_point deadline = timeSource.now();
+    steady_clock::time_point lastStep = deadline;
+    while (true) {
+        deadline += TRAIL_STEP_INTERVAL;
+        if (!waitWhileFollowing(deadline)) {
+            break;
+        }
+
+        // Step by the time that actually passed, a late wake up still moved the car the whole time.
+        steady_clock::time_point now = timeSource.now();
+        TrailCommand command = distanceTrail.step(duration_cast<microseconds>(now - lastStep));
+        lastStep = now;
+
+        // Unchanged commands are not sent again, see sendSpeed and sendSteering.
+        sendSpeed(command.speed);
+        sendSteering(command.steeringAngle);
+    }
 }
 
 /**
- * This function starts the thread that will take care of sending statuses to the leading vehicle.
+ * This function starts a follow session on the follower thread. Called from the UDP receiver thread when the leader
+ * accepted our FollowRequest.
  */
 void V2VService::startFollowing() {
-    lastLeaderUpdate = getTime();
-
-    // Empty the old queue since new following has been initialised.
-    std::queue<std::pair<uint64_t, LeaderStatus>> newQueue;
+    /*
+     * No leader status is processed while the session is prepared, so the pre fill below is the only producer of the
+     * leader update queue. Taken before followMutex, which processing a leader status takes to wake the follower.
+     */
+    std::lock_guard<std::mutex> leaderStatusLock(leaderStatusMutex);
+    std::unique_lock<std::mutex> lock(followMutex);
 
     /*
-     * This will prefill the leader status queue with updates to go the first 1 meter straight,
+     * A session that was never stopped is replaced by this one. Once the follower thread has left it, it is idle and
+     * we are both the only producer and the only consumer of the leader update queue, so the queue and the trail can
+     * be prepared here.
      */
-    std::cout << "Starting to pre fill update queue" << std::endl;
-    uint64_t time = getTime();
-    for (int i = 0; i < 9; i++) {
-        std::pair<uint64_t, LeaderStatus> initialUpdate;
-        LeaderStatus leaderStatus;
-        leaderStatus.speed(0.15);
-        leaderStatus.steeringAngle(0.0);
+    followActive = false;
+    followSignal.notify_all();
+    followSignal.wait(lock, [this] { return !followerBusy; });
+    if (shuttingDown) {
+        return;
+    }
+    sessionMode = followMode;
+    {
+        // Whatever drove the car before us, the first command of the session goes out.
+        std::lock_guard<std::mutex> actuationLock(actuationMutex);
+        speedCommands.reset();
+        steeringCommands.reset();
+    }
 
-        initialUpdate.first = 125; // Standard delay
-        initialUpdate.second = leaderStatus;
+    if (sessionMode == FollowMode::DISTANCE) {
+        // We start one follow distance behind the leader on its trail, no pre fill is needed since the trail will lead
+        // us straight up to the leader's first point.
+        distanceTrail.reset(-FOLLOW_DISTANCE_CM);
+    } else {
+        // Empty the old queue since new following has been initialised.
+        leaderUpdates.clear();
+
+        /*
+         * This will prefill the leader status queue with updates to go the first 1 meter straight.
+         *
+         * Other car                    Our car
+         *     |  <-- Follow Request ----  |
+         *     |  --- Follow Response -->  |
+         * < Starts sending >     < Start listening >
+         *     |                           |
+         *
+         * Leader statuses are held off by leaderStatusMutex meanwhile, so no leader status can end up in the middle
+         * of the pre fill updates and make the car turn slightly during ramp-up.
+         */
+        V2V_LOG(DEBUG) << "Starting to pre fill update queue";
+        TimeSource::time_point started = timeSource.now();
+        for (int i = 0; i < 9; i++) {
+            LeaderUpdate initialUpdate;
+            LeaderStatus leaderStatus;
+            leaderStatus.speed(0.15);
+            leaderStatus.steeringAngle(0.0);
+
+            initialUpdate.first = 0; // No timestamp, replayed with the standard delay
+            initialUpdate.second = std::move(leaderStatus);
+
+            leaderUpdates.push(std::move(initialUpdate));
+        }
+        V2V_LOG(DEBUG) << "Pre fill took " << std::chrono::duration_cast<std::chrono::microseconds>(
+                              timeSource.now() - started).count() << "us";
+    }
+
+    followActive = true;
+    followSignal.notify_all();
+}
+
+/**
+ * Event loop task sending LeaderStatus messages to the following cars.
+ */
+void V2VService::reportToFollowers() {
+    // Get sensor data
+    CarStatus status = getCurrentCarStatus();
+
+    // Send sensor data
+    queueLeaderStatus(
+        status.speed,
+        status.steeringAngle
+    );
+}
 
-        newQueue.push(initialUpdate);
+/**
+ * This function starts watching a new follower for follower statuses and, if it is the first one, arms the event loop
+ * task that will take care of sending current car statuses to the following vehicles. A follower that lost track of
+ * us and asked again is watched anew.
+ *
+ * @param follower - follower that was just added to the group
+ */
+void V2VService::startReportingToFollower(const std::shared_ptr<Follower> &follower) {
+    std::string followerIp = follower->ip;
+    watchPeer(follower->peer, FOLLOWER_TIMEOUT, FOLLOWER_STATUS_INTERVAL,
+              [this, followerIp](const std::string &lost) {
+                  V2V_LOG(WARNING) << "Lost the " << lost << ", dropping it!";
+                  dropFollower(followerIp, true);
+              });
+
+    std::lock_guard<std::mutex> lock(followersMutex);
+    if (leaderStatusTask == 0) {
+        {
+            // Distance traveled is reported relative to where we were when the first follower joined.
+            std::lock_guard<std::mutex> reportLock(leaderReportMutex);
+            leaderOdometry.reset();
+            leaderSequence = 0;
+            lastReportedSpeed = 0.0f;
+            lastLeaderStatusSent = timeSource.now();
+        }
+        leaderStatusTask = eventLoop.arm(LEADER_STATUS_INTERVAL, [this]() { reportToFollowers(); });
     }
-    std::cout << "Pre fill took " << (getTime() - time) << "ms" << std::endl;
-    /*
-     * Perform swap here to avoid problem where leader statuses get filled simultaneously, that's because the sequence
-     * looks like this:
-     *
-     * Other car                    Our car
-     *     |  <-- Follow Request ----  |
-     *     |  --- Follow Response -->  |
-     * < Starts sending >     < Start listening >
-     *     |                           |
-     *
-     * If we do not swap the queues here, we could get interfering leader statuses during the pre fill which will be
-     * erroneously inserted in the middle of the "pre fill" updates, meaning the car could suddenly turn slightly
-     * during ramp-up. Swapping here makes sure that even if we received some updates during pre fill, they will be
-     * ignored. Trade off, but should not mean losing more than 1 update in the absolute worst case.
-     */
-    std::swap(leaderUpdates, newQueue);
+}
 
-    int status;
-    pthread_t threadId;
-    status = pthread_create(&threadId, NULL, executeLeaderUpdates, (void *)this);
-    
-    // pthread_create returns 1 if an error occured.
-    if (status) {
-        std::cout << "Error creating update leader thread" << std::endl;
+/**
+ * This function removes every follower, disarms the task sending statuses to the following vehicles and stops
+ * watching them.
+ *
+ * @return the removed followers
+ */
+std::vector<std::shared_ptr<Follower>> V2VService::stopReportingToFollowers() {
+    std::lock_guard<std::mutex> lock(followersMutex);
+    std::vector<std::shared_ptr<Follower>> dropped = followers.clear();
+    EventLoop::TaskId task = leaderStatusTask.exchange(0);
+    if (task != 0) {
+        eventLoop.disarm(task);
+    }
+    for (const std::shared_ptr<Follower> &follower : dropped) {
+        liveness.forget(follower->peer);
     }
+    return dropped;
 }
 
 /**
- * This function is designed to be the target of a pthread starting. It will take care of sending LeaderStatus messages
- * to the following car as well as check that the following car has been sending regular updates.
+ * Ends the session with one follower, the others keep following. The task sending statuses is disarmed along with the
+ * last follower.
  *
- * @param v2v - the v2v service object reference from which this thread function will both take and get information from
- * @return N/A
+ * @param followerIp - IP of the follower
+ * @param notify - true to send the follower a StopFollow, false if it ended the session itself
  */
-void *sendLeaderStatuses(void *v2v) {
-    V2VService *v2vservice;
-    v2vservice = (V2VService *)v2v;
-    std::cout << "Update follower thread started!" << std::endl;
-    
-    using namespace std::chrono_literals;
-    while (!v2vservice->followerIp.empty()) {   // Report as long as we have a follower
-    
-        // If no update has been received from follower for more than two seconds, disconnect
-        if ((v2vservice->getTime() - v2vservice->lastFollowerUpdate) > 2000) {
-            v2vservice->stopFollow();
-            break;
+void V2VService::dropFollower(const std::string &followerIp, bool notify) {
+    std::shared_ptr<Follower> follower;
+    {
+        std::lock_guard<std::mutex> lock(followersMutex);
+        follower = followers.remove(followerIp);
+        if (follower == nullptr) {
+            return;
+        }
+        if (followers.empty()) {
+            EventLoop::TaskId task = leaderStatusTask.exchange(0);
+            if (task != 0) {
+                eventLoop.disarm(task);
+            }
         }
-        
-        // Get sensor data
-        CarStatus *currentCarStatus = v2vservice->getCurrentCarStatus();
-        
-        // Send sensor data
-        v2vservice->leaderStatus(
-            currentCarStatus->speed,
-            currentCarStatus->steeringAngle
-        );
-        // Message frequency according to protocol.
-        std::this_thread::sleep_for(125ms);
     }
-    
-    pthread_exit(NULL);
+    liveness.forget(follower->peer);
+
+    if (notify) {
+        StopFollow stopFollow;
+        sendPool.send(follower->sender, stopFollow, follower->framing);
+    }
 }
 
 /**
- * This function starts the thread that will take care of sending current car statuses to the following vehicle.
+ * Handles a LeaderStatus received through unicast or our leader's multicast group. Statuses from other cars are only
+ * relayed to the internal channel.
+ *
+ * @param msg - received frame
+ * @param senderIp - IP of the sending car
+ * @param receivedMicros - our wall clock when it was received
  */
-void V2VService::startReportingToFollower() {
-    // Get time before reporting was started to break connection in case no updates are received for over two seconds
-    lastFollowerUpdate = getTime();
+void V2VService::receiveLeaderStatus(const Frame &msg, const std::string &senderIp, int64_t receivedMicros) {
+    // The one message arriving at a steady rate, decoded without any heap allocation.
+    LeaderStatus leaderStatus;
+    if (!decodeLeaderStatus(msg.payload, leaderStatus)) {
+        V2V_LOG_EVERY(WARNING, 1000) << "Malformed LeaderStatus from '" << senderIp << "'!";
+        return;
+    }
+    V2V_LOG(DEBUG) << "[INCOMING] received '" << leaderStatus.LongName() <<
+                      " - New speed = " << leaderStatus.speed() <<
+                      " - New steering = " << leaderStatus.steeringAngle();
 
-    int status;
-    pthread_t threadId;
-    status = pthread_create(&threadId, NULL, sendLeaderStatuses, (void *)this);
-    
-    // pthread_create returns 1 if an error occured.
-    if (status) {
-        std::cout << "Error creating update follower thread" << std::endl;
+    sendInternal(leaderStatus, senderIp);
+
+    // Only process the messages from the leader.
+    if (!isLeader(senderIp)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(leaderStatusMutex);
+    lastLeaderStatus = timeSource.now();
+
+    // A status multicast to several followers may echo another one of them.
+    if (!leaderClock.echoesOurs(leaderStatus)) {
+        leaderStatus.echoSentMicros(0);
+        leaderStatus.echoReceivedMicros(0);
+    }
+    // Every exchange also gives the round trip time to the leader, without its holding time.
+    ClockSample sample;
+    if (leaderClock.processLeaderStatus(leaderStatus, receivedMicros, &sample)) {
+        liveness.recordRtt(LEADER_PEER, std::chrono::microseconds(sample.delayMicros));
+    }
+
+    // Lost, duplicated or reordered datagrams are never actuated out of order.
+    LeaderStatus released[REORDER_MAX_RELEASED];
+    size_t count = leaderWindow.accept(leaderStatus, timeSource.now(), released);
+    for (size_t i = 0; i < count; i++) {
+        processLeaderStatusLocked(released[i]);
+    }
+}
+
+/**
+ * Event loop task releasing leader statuses held back for a missing one that did not come in time.
+ */
+void V2VService::expireLeaderWindow() {
+    std::lock_guard<std::mutex> lock(leaderStatusMutex);
+    LeaderStatus released[REORDER_MAX_RELEASED];
+    size_t count = leaderWindow.expire(timeSource.now(), released);
+    for (size_t i = 0; i < count; i++) {
+        processLeaderStatusLocked(released[i]);
+    }
+}
+
+/**
+ * Joins the multicast group our leader offered in its FollowResponse. Our FollowerStatus messages tell the leader,
+ * which then stops sending us statuses through unicast. If the group cannot be joined we stay with unicast.
+ *
+ * @param group - multicast group of the leader
+ * @param port - port the leader sends to
+ */
+void V2VService::joinLeaderGroup(const std::string &group, uint16_t port) {
+    std::shared_ptr<MulticastReceiver> receiver = std::make_shared<MulticastReceiver>(group, port, myIp,
+        [this](std::string &&data, std::string &&sender, std::chrono::system_clock::time_point &&) noexcept {
+            int64_t receivedMicros = timeSource.wallMicros();
+            Frame msg = extractFrame(data);
+            if (msg.id == LEADER_STATUS) {
+                receiveLeaderStatus(msg, sender.substr(0, sender.find(":")), receivedMicros);
+            }
+        });
+    if (!receiver->isRunning()) {
+        V2V_LOG(WARNING) << "Could not join the multicast group of the leader, staying with unicast!";
+        return;
+    }
+    V2V_LOG(INFO) << "Joined multicast group " << group << ":" << port << " of the leader!";
+    std::atomic_store(&leaderGroup, receiver);
+}
+
+/**
+ * Leaves our leader's multicast group, if we joined one. Never called from the group's own receiver thread, which
+ * leaving waits for.
+ */
+void V2VService::leaveLeaderGroup() {
+    std::shared_ptr<MulticastReceiver> left = std::atomic_exchange(&leaderGroup, std::shared_ptr<MulticastReceiver>());
+    if (left != nullptr) {
+        V2V_LOG(INFO) << "Left multicast group " << left->group() << " of the leader!";
     }
 }
 
@@ -586,8 +1062,30 @@ void V2VService::startReportingToFollower() {
  *
  * @param leaderStatusUpdate - latest status update from leading vehicle to process
  */
-void V2VService::processLeaderStatus(LeaderStatus leaderStatusUpdate) {
+void V2VService::processLeaderStatus(const LeaderStatus &leaderStatusUpdate) {
+    std::lock_guard<std::mutex> lock(leaderStatusMutex);
+    processLeaderStatusLocked(leaderStatusUpdate);
+}
+
+/**
+ * Same as processLeaderStatus, called with leaderStatusMutex held.
+ */
+void V2VService::processLeaderStatusLocked(const LeaderStatus &leaderStatusUpdate) {
     float speed = leaderStatusUpdate.speed();
+
+    // The mode of the session the follower thread runs, not the one the next session starts in.
+    if (sessionMode == FollowMode::DISTANCE) {
+        /*
+         * In distance mode every status goes on the trail, including standstill ones since they tell us where the
+         * leader stopped. The follower stops by itself once it reaches that point.
+         */
+        isLeaderMoving = speed != 0;
+        if (!distanceTrail.record(leaderStatusUpdate.distanceTraveled(), speed, leaderStatusUpdate.steeringAngle())) {
+            V2V_LOG_EVERY(WARNING, 1000) << "Distance trail full, dropping update!";
+        }
+        liveness.heard(LEADER_PEER);
+        return;
+    }
     
     if (speed == 0) { // Maybe add a higher lower bound since car does not move until 15~ percent?
         /* 
@@ -600,22 +1098,14 @@ void V2VService::processLeaderStatus(LeaderStatus leaderStatusUpdate) {
     } else {
         isLeaderMoving = true; // This is to make sure we only move when the leader does.
     
-        std::pair<uint64_t, LeaderStatus> update;
-    
-        if (lastLeaderUpdate == 0) { // If the last leader update was not registered yet for 
-                                     // some reason, use the default time delay.
-            update.first = 125;
-        } else {
-            // Actual time between updates
-            //update.first = getTime() - lastLeaderUpdate;
-            update.first = 125;
+        // The leader timestamp is what the replay spacing is computed from.
+        if (!leaderUpdates.emplace(leaderStatusUpdate.timestamp(), leaderStatusUpdate)) {
+            V2V_LOG_EVERY(WARNING, 1000) << "Leader update queue full, dropping update!";
         }
-        
-        update.second = leaderStatusUpdate;
-        leaderUpdates.push(update);
     }
+    wakeFollower();
     
-    lastLeaderUpdate = getTime(); 
+    liveness.heard(LEADER_PEER);
 }
 
 /**
@@ -623,13 +1113,22 @@ void V2VService::processLeaderStatus(LeaderStatus leaderStatusUpdate) {
  */
 void V2VService::stopCar() {
 
-    if (currentCarStatus.speed > 0) {
+    if (getCurrentCarStatus().speed > 0) {
         sendSteering(0.0);
         sendSpeed(0.0);
     }
 }
 
+/**
+ * Sends a steering angle to the motor, unless it is too close to the one sent before, see ActuationCoalescer.
+ *
+ * @param steering - steering angle to send
+ */
 void V2VService::sendSteering(float steering) {
+    std::lock_guard<std::mutex> lock(actuationMutex);
+    if (!steeringCommands.shouldSend(steering, timeSource.now())) {
+        return;
+    }
     opendlv::proxy::GroundSteeringReading steeringMsg;
 
     // Two different offsets exist, the offset that is set with the object constructor is for going straight, the second
@@ -640,20 +1139,49 @@ void V2VService::sendSteering(float steering) {
     } else {
         steeringMsg.steeringAngle(steering * 2);
     }
-    motorBroadcast->send(steeringMsg);
+    if (motorBroadcast != nullptr) {
+        motorBroadcast->send(steeringMsg);
+    }
+    if (actuationObserver) {
+        actuationObserver(steeringMsg.ID(), steeringMsg.steeringAngle());
+    }
 }
 
+/**
+ * Sends a pedal position to the motor, unless it is too close to the one sent before, see ActuationCoalescer.
+ *
+ * @param speed - pedal position to send
+ */
 void V2VService::sendSpeed(float speed) {
+    std::lock_guard<std::mutex> lock(actuationMutex);
+    if (!speedCommands.shouldSend(speed, timeSource.now())) {
+        return;
+    }
     opendlv::proxy::PedalPositionReading speedMsg;
 
     // Offset only applies for speeds > 0.
     if (speed == 0) {
         speedMsg.percent(speed);
-        motorBroadcast->send(speedMsg);
     } else {
         speedMsg.percent(speed + (speedOffset));
+    }
+    if (motorBroadcast != nullptr) {
         motorBroadcast->send(speedMsg);
     }
+    if (actuationObserver) {
+        actuationObserver(speedMsg.ID(), speedMsg.percent());
+    }
+}
+
+/**
+ * Sets what is told about every motor command sent, with the id of its message type and its value, on the thread
+ * sending it. Meant for replaying recorded sessions and testing, the motor itself only listens to the motor channel.
+ *
+ * @param observer - called with every command, nullptr for none
+ */
+void V2VService::setActuationObserver(const std::function<void(int32_t dataType, float value)> &observer) {
+    std::lock_guard<std::mutex> lock(actuationMutex);
+    actuationObserver = observer;
 }
 
 /**
@@ -661,155 +1189,362 @@ void V2VService::sendSpeed(float speed) {
  *
  * @param speed - current pedal position
  * @param steeringAngle - current steering angle
- * @param distanceTraveled - distance traveled since last sending a leader status message
  */
 void V2VService::leaderStatus(float speed, float steeringAngle) {
-    uint8_t distanceTraveled = 0;
-
-    if (speed == 0.15) {
-        distanceTraveled = 7;
-    } else if (speed > 0.15 && speed < 0.17) {
-        distanceTraveled = 9;
-    } else if (speed > 0.17 && speed < 0.18) {
-        distanceTraveled = 11;
-    } else if (speed > 0.18 && speed <= 0.20) {
-        distanceTraveled = 13;
-    }
+    queueLeaderStatus(speed, steeringAngle);
+    sendPool.flush();
+}
 
-    if (followerIp.empty()) return;
+/**
+ * Queues a LeaderStatus (id = 2001) message for every follower, it goes out with the next flush of the send pool.
+ *
+ * The distance traveled since the previous LeaderStatus is estimated from the speed model in odometry.hpp, assuming
+ * the speed of the previous LeaderStatus was held since then.
+ *
+ * @param speed - current pedal position
+ * @param steeringAngle - current steering angle
+ */
+void V2VService::queueLeaderStatus(float speed, float steeringAngle) {
+    using namespace std::chrono;
     LeaderStatus leaderStatus;
+    {
+        std::lock_guard<std::mutex> reportLock(leaderReportMutex);
+        steady_clock::time_point now = timeSource.now();
+        microseconds elapsed = duration_cast<microseconds>(now - lastLeaderStatusSent);
+        lastLeaderStatusSent = now;
+
+        // Manually sent or the first status after a pause, count it as a single interval at the protocol rate.
+        if (elapsed > 2 * NOMINAL_UPDATE_SPACING) {
+            elapsed = NOMINAL_UPDATE_SPACING;
+        }
+        // The distance since the previous status was driven at the speed we reported back then.
+        leaderOdometry.advance(lastReportedSpeed, elapsed);
+        lastReportedSpeed = speed;
+        leaderStatus.distanceTraveled(leaderOdometry.takeDistanceTraveled());
+
+        if (followers.empty()) return;
+        leaderStatus.sequence(++leaderSequence);
+    }
     leaderStatus.timestamp(getTime());
     leaderStatus.speed(speed);
     leaderStatus.steeringAngle(steeringAngle);
-    leaderStatus.distanceTraveled(distanceTraveled);
-    toFollower->send(encode(leaderStatus));
+    followers.fanOut(sendPool, leaderStatus, timeSource.wallMicros());
     
-    internalBroadCast->send(leaderStatus);
+    sendInternal(leaderStatus);
+}
+
+/**
+ * @return IPs of the cars following us, in the order they joined
+ */
+std::vector<std::string> V2VService::getFollowerIps() {
+    std::vector<std::string> ips;
+    for (const std::shared_ptr<Follower> &follower : followers.followers()) {
+        ips.push_back(follower->ip);
+    }
+    return ips;
 }
 
 /**
- * This functions gets a map containing IP addresses of cars & their groupIds as they announced presence in the network.
+ * Gets the cars that announced their presence in the network and have not expired since. The snapshot does not change
+ * while it is held, so it can be looked up in as often as needed without copying.
  *
- * @return mapOfIps - a map containing the IP addresses and the groupIds of all cars that have announced their presence.
+ * @return IP addresses and groupIds of the known cars
  */
-std::map<std::string, std::string> V2VService::getMapOfIps() {
-    return mapOfIps;
+std::shared_ptr<const PeerSnapshot> V2VService::getPeers() const {
+    return peers.snapshot();
 }
 
 /**
- * Getter for the currentCarStatus field.
+ * @return IP of our leader, empty while we have none
+ */
+std::string V2VService::getLeaderIp() const {
+    std::shared_ptr<PeerSendContext> leader = std::atomic_load(&toLeader);
+    return leader != nullptr ? leader->ip() : std::string();
+}
+
+/**
+ * @param ip - IP of a car
+ * @return true if it is our leader
+ */
+bool V2VService::isLeader(const std::string &ip) const {
+    std::shared_ptr<PeerSendContext> leader = std::atomic_load(&toLeader);
+    return leader != nullptr && leader->ip() == ip;
+}
+
+/**
+ * Getter for the currentCarStatus field, safe to call from any thread.
  *
- * @return currentCarStatus - the car's current status in terms of speed, steering etc.
+ * @return currentCarStatus - consistent snapshot of the car's current status in terms of speed, steering etc.
  */
-CarStatus *V2VService::getCurrentCarStatus() {
-    return &currentCarStatus;
+CarStatus V2VService::getCurrentCarStatus() const {
+    return currentCarStatus.load();
 }
 
-std::queue<std::pair<uint64_t, LeaderStatus>> *V2VService::getLeaderUpdates() {
-    return &leaderUpdates;
+/**
+ * The threads of the service that wait on its time source whenever they have nothing to do, for settling a
+ * ManualTimeSource on: the event loop, and the follower thread while following.
+ *
+ * @return number of threads waiting on the time source once the service is idle
+ */
+size_t V2VService::getTimedThreads() {
+    return isFollowing() ? 2 : 1;
 }
 
 /**
- * Setter for the currentCarStatus field.
+ * Takes the oldest queued leader update, only to be called from the follower thread.
+ *
+ * @param update - receives the oldest queued update
+ * @return false if there was no queued update
+ */
+bool V2VService::popLeaderUpdate(LeaderUpdate &update) {
+    return leaderUpdates.pop(update);
+}
+
+/**
+ * @return number of leader updates dropped because the queue was full
+ */
+uint64_t V2VService::getLeaderUpdateOverflows() const {
+    return leaderUpdates.overflows();
+}
+
+/**
+ * @return largest number of leader updates that have been waiting in the queue at once
+ */
+size_t V2VService::getLeaderUpdateHighWaterMark() const {
+    return leaderUpdates.highWaterMark();
+}
+
+/**
+ * Selects how leader updates are replayed. Takes effect the next time following starts.
+ *
+ * @param mode - TIME to replay updates after a delay, DISTANCE to replay them at the spot the leader was at
+ */
+void V2VService::setFollowMode(FollowMode mode) {
+    followMode = mode;
+}
+
+FollowMode V2VService::getFollowMode() const {
+    return followMode;
+}
+
+/**
+ * Selects how get all groups requests are answered, BATCHED unless set otherwise.
+ *
+ * @param mode - BATCHED for InternalGetAllGroupsBatch pages, PER_CAR for one InternalGetAllGroupsResponse per car
+ */
+void V2VService::setGroupsResponseMode(GroupsResponseMode mode) {
+    groupsResponseMode = mode;
+}
+
+GroupsResponseMode V2VService::getGroupsResponseMode() const {
+    return groupsResponseMode;
+}
+
+/**
+ * Selects how LeaderStatus messages reach our followers, UNICAST unless set otherwise. With MULTICAST we send to the
+ * group picked from our IP, through the interface of our IP, and join the groups our leaders offer.
+ *
+ * @param mode - UNICAST or MULTICAST
+ */
+void V2VService::setLeaderStatusMode(LeaderStatusMode mode) {
+    leaderStatusMode = mode;
+    if (mode == LeaderStatusMode::UNICAST) {
+        followers.setMulticastGroup(nullptr);
+        leaveLeaderGroup();
+        return;
+    }
+
+    std::string group = multicastGroupFor(myIp);
+    if (group.empty() || !sendPool.setMulticastInterface(myIp)) {
+        V2V_LOG(WARNING) << "Cannot multicast from '" << myIp << "', reporting to followers through unicast!";
+        return;
+    }
+    // Held by the follower group, so the pool never evicts it.
+    followers.setMulticastGroup(sendPool.acquire(group, MULTICAST_PORT));
+}
+
+LeaderStatusMode V2VService::getLeaderStatusMode() const {
+    return leaderStatusMode;
+}
+
+/**
+ * @return the trail followed in distance mode, only to be stepped by the follower thread
+ */
+DistanceTrail &V2VService::getDistanceTrail() {
+    return distanceTrail;
+}
+
+/**
+ * @return the scheduler that replays leader updates, including its actuation jitter histogram
+ */
+ReplayScheduler &V2VService::getReplayScheduler() {
+    return replayScheduler;
+}
+
+/**
+ * Setter for the currentCarStatus field. The status has a single writer, so this must not be called while readings
+ * are coming in on the motor channel.
  *
  * @param newCarStatus - new car status to override current car status
  * @return newCurrentCarStatus - the new status of the car
  */
-CarStatus *V2VService::setCurrentCarStatus(struct CarStatus *newCarStatus) {
-    currentCarStatus.speed = newCarStatus->speed;
-    currentCarStatus.steeringAngle = newCarStatus->steeringAngle;
-    return &currentCarStatus;
+CarStatus V2VService::setCurrentCarStatus(const CarStatus &newCarStatus) {
+    currentCarStatus.store(newCarStatus);
+    return newCarStatus;
 }
 
 /**
  * A simple printout containing information about the V2VService object state.
  */
 void V2VService::healthCheck() {
-    std::map<std::string, std::string> ipMap = getMapOfIps();
-    CarStatus *status = getCurrentCarStatus();
+    std::shared_ptr<const PeerSnapshot> known = peers.snapshot();
+    CarStatus status = getCurrentCarStatus();
     std::cout << "V2VService health check" << std::endl;
     std::cout << "--------------------------------------" << std::endl;
     std::cout << "GroupID : " << myGroupId << " IP-address : " << myIp << std::endl;
     std::cout << "--------------------------------------" << std::endl;
     std::cout << "Current Time (ms) : " << getTime() << std::endl;
-    std::cout << "Current speed (%) : " << status->speed << std::endl;
-    std::cout << "Current angle (%) : " << status->steeringAngle << std::endl;
+    std::cout << "Current speed (%) : " << status.speed << std::endl;
+    std::cout << "Current angle (%) : " << status.steeringAngle << std::endl;
+    std::cout << "Status age (ms)   : " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                              timeSource.now() - status.sampled).count() << std::endl;
     std::cout << "--------------------------------------" << std::endl;
-    std::cout << "Follower          : " << followerIp << std::endl;
-    std::cout << "Leader            : " << leaderIp << std::endl;
+    std::vector<std::shared_ptr<Follower>> following = followers.followers();
+    std::cout << "Followers         : " << following.size() << " of at most " << MAX_FOLLOWERS << std::endl;
+    for (const std::shared_ptr<Follower> &follower : following) {
+        std::cout << "  " << follower->ip << (follower->framing == Framing::BINARY ? " (binary" : " (legacy")
+                  << (follower->multicast ? ", multicast)" : ")") << std::endl;
+        printPeerMetrics(follower->peer, follower->ip);
+    }
+    std::shared_ptr<PeerSendContext> group = followers.multicastGroup();
+    std::cout << "Multicast group   : " << (group != nullptr ? group->ip() : "none") << std::endl;
+    std::shared_ptr<MulticastReceiver> joined = std::atomic_load(&leaderGroup);
+    std::string leaderIp = getLeaderIp();
+    std::cout << "Leader            : " << leaderIp << (joined != nullptr ? " (multicast " + joined->group() + ")" : "")
+              << std::endl;
+    printPeerMetrics(LEADER_PEER, leaderIp);
+    if (!leaderIp.empty() && leaderClock.synced()) {
+        std::cout << "    clock offset " << leaderClock.offsetMicros(timeSource.wallMicros()) << " us, drift "
+                  << leaderClock.driftPpm() << " ppm" << std::endl;
+    }
+    std::cout << "Leader statuses   : lost " << leaderWindow.lost() << " (" << leaderWindow.interpolated()
+              << " interpolated), reordered " << leaderWindow.reordered() << ", late " << leaderWindow.late()
+              << ", duplicates " << leaderWindow.duplicates() << std::endl;
+    leaderClock.latency().print(std::cout, "One way latency   ");
+    std::cout << "Queued updates    : " << leaderUpdates.size() << " (high water mark "
+              << getLeaderUpdateHighWaterMark() << ", overflows " << getLeaderUpdateOverflows() << ")" << std::endl;
+    replayScheduler.jitter().print(std::cout, "Actuation jitter  ");
+    std::cout << "Motor commands    : speed sent " << speedCommands.sent() << ", suppressed "
+              << speedCommands.suppressed() << "; steering sent " << steeringCommands.sent() << ", suppressed "
+              << steeringCommands.suppressed() << std::endl;
+    std::cout << "Follow mode       : " << (followMode == FollowMode::DISTANCE ? "distance" : "time") << std::endl;
+    if (followMode == FollowMode::DISTANCE) {
+        std::cout << "Trail (cm)        : leader " << distanceTrail.leaderDistance() << " follower "
+                  << distanceTrail.followerDistance() << " (" << distanceTrail.pointsAhead() << " points ahead)"
+                  << std::endl;
+    }
     std::cout << "--------------------------------------" << std::endl;
-    std::cout << "Announced         : " << followerIp << std::endl;
-    for(std::map<std::string, std::string>::iterator it = ipMap.begin(); it != ipMap.end(); ++it) {
-        std::cout << "    Group " << it->first << " - IP " << it->second << std::endl;
+    std::cout << "Announcements     : sent " << getAnnouncementsSent() << ", received " << getAnnouncementsReceived();
+    if (announcer.nextAnnouncement() == TimeSource::time_point::max()) {
+        std::cout << ", automatic announcing off" << std::endl;
+    } else {
+        std::cout << ", next in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         announcer.nextAnnouncement() - timeSource.now()).count()
+                  << " ms (period " << announcer.interval().count() << " ms)" << std::endl;
+    }
+    std::cout << "Announced         : " << known->size() << " cars" << std::endl;
+    std::cout << "Sent datagrams    : " << sendPool.datagramsSent() << " in " << sendPool.sendCalls() << " calls, "
+              << sendPool.sendErrors() << " errors" << std::endl;
+    for (size_t i = 0; i < known->size(); i++) {
+        const PeerEntry &peer = known->entries()[i];
+        std::cout << "    Group " << peer.groupId << " - IP " << peer.ip << " (seen " << peers.age(peer).count()
+                  << " ms ago)" << std::endl;
     }
     std::cout << "--------------------------------------" << std::endl;
 }
 
 /**
- * Gets the current time.
+ * Answers a get all groups request with the cars that announced themselves and have not expired. Only called from the
+ * internal channel callback.
+ */
+void V2VService::sendAllGroups() {
+    std::shared_ptr<const PeerSnapshot> known = peers.snapshot();
+
+    if (groupsResponseMode == GroupsResponseMode::PER_CAR) {
+        for (const PeerEntry &peer : known->entries()) {
+            InternalGetAllGroupsResponse msg;
+            msg.groupid(peer.groupId);
+            sendInternal(msg);
+        }
+        return;
+    }
+
+    std::vector<GroupListEntry> groups;
+    groups.reserve(known->size());
+    for (const PeerEntry &peer : known->entries()) {
+        groups.push_back(GroupListEntry{peer.groupId, peer.ip, (uint32_t) peers.age(peer).count(), peer.capabilities});
+    }
+    for (InternalGetAllGroupsBatch &page : packGroupList(groups, ++lastGroupListBatch)) {
+        sendInternal(page);
+    }
+}
+
+/**
+ * Prints the link metrics of a watched peer as part of the health check.
  *
- * @return current time in seconds
+ * @param peer - LEADER_PEER or the peer name of a follower
+ * @param ip - IP of the peer
  */
-uint64_t V2VService::getTime() {
-    using namespace std::chrono;
-    
-    milliseconds ms = duration_cast<milliseconds>(
-        system_clock::now().time_since_epoch()
-    );
-    return (uint64_t) ms.count();
+void V2VService::printPeerMetrics(const std::string &peer, const std::string &ip) {
+    PeerMetrics metrics;
+    if (ip.empty() || !liveness.metrics(peer, metrics)) {
+        return;
+    }
+    std::cout << "    received " << metrics.received << ", lost " << metrics.missed << " ("
+              << metrics.lossRate * 100.0f << "%), silent for " << metrics.silence.count() << " ms, RTT ";
+    if (metrics.meanRttMicros < 0) {
+        std::cout << "unknown" << std::endl;
+    } else {
+        std::cout << metrics.meanRttMicros << " us (last " << metrics.lastRttMicros << " us)" << std::endl;
+    }
 }
 
 /**
- * The extraction function is used to extract the message ID and message data into a pair.
+ * Gets the current wall clock time, for timestamps sent to other cars. Anything measuring time on this car uses the
+ * monotonic clock of the time source instead, which does not jump when NTP steps the system time.
  *
- * @param data - message data to extract header and data from
- * @return pair consisting of the message ID (extracted from the header) and the message data
+ * @return current wall clock time in milliseconds since the Unix epoch
  */
-std::pair<int16_t, std::string> V2VService::extract(std::string data) {
-    if (data.length() < 10) return std::pair<int16_t, std::string>(-1, "");
-    unsigned int id, len;
-    std::stringstream ssId(data.substr(0, 4));
-    std::stringstream ssLen(data.substr(4, 10));
-    ssId >> std::hex >> id;
-    ssLen >> std::hex >> len;
-    return std::pair<int16_t, std::string> (
-            data.length() -10 == len ? id : -1,
-            data.substr(10, data.length() -10)
-    );
-};
+uint64_t V2VService::getTime() const {
+    return timeSource.wallMillis();
+}
 
 /**
- * Generic encode function used to encode a message before it is sent.
+ * The sender stamp of the messages from a car when relayed to the internal channel.
  *
- * @tparam T - generic message type
- * @param msg - message to encode
- * @return encoded message
+ * @param ip - IP of the car
+ * @return its IPv4 address in network byte order, OWN_SENDER_STAMP if it is not a valid one
  */
-template <class T>
-std::string V2VService::encode(T msg) {
-    cluon::ToProtoVisitor v;
-    msg.accept(v);
-    std::stringstream buff;
-    buff << std::hex << std::setfill('0')
-         << std::setw(4) << msg.ID()
-         << std::setw(6) << v.encodedData().length()
-         << v.encodedData();
-    return buff.str();
+uint32_t senderStampOf(const std::string &ip) {
+    in_addr address;
+    if (inet_pton(AF_INET, ip.c_str(), &address) != 1) {
+        return OWN_SENDER_STAMP;
+    }
+    return address.s_addr;
 }
 
 /**
- * Generic decode function used to decode an incoming message.
+ * The car a message relayed to the internal channel came from.
  *
- * @tparam T - generic message type
- * @param data - encoded message data
- * @return decoded message
+ * @param senderStamp - sender stamp of the message
+ * @return IP of the car, empty for OWN_SENDER_STAMP
  */
-template <class T>
-T V2VService::decode(std::string data) {
-    std::stringstream buff(data);
-    cluon::FromProtoVisitor v;
-    v.decodeFrom(buff);
-    T tmp = T();
-    tmp.accept(v);
-    return tmp;
+std::string senderIpOf(uint32_t senderStamp) {
+    if (senderStamp == OWN_SENDER_STAMP) {
+        return "";
+    }
+    in_addr address;
+    address.s_addr = senderStamp;
+    char ip[INET_ADDRSTRLEN];
+    return inet_ntop(AF_INET, &address, ip, sizeof(ip)) != nullptr ? ip : "";
 }
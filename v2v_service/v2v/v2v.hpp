@@ -5,11 +5,13 @@
 #include <cstdint>
 #include <sys/time.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <map>
-#include <queue>
+#include <mutex>
 #include <string>
-
-#include <pthread.h>
+#include <thread>
 
 #include "cluon/OD4Session.hpp"
 #include "cluon/UDPSender.hpp"
@@ -18,6 +20,25 @@
 
 #include "messages.hpp"
 
+#include "framing.hpp"
+#include "spsc_queue.hpp"
+#include "replay_scheduler.hpp"
+#include "distance_trail.hpp"
+#include "odometry.hpp"
+#include "event_loop.hpp"
+#include "seqlock.hpp"
+#include "liveness_tracker.hpp"
+#include "log.hpp"
+#include "time_source.hpp"
+#include "clock_sync.hpp"
+#include "peer_registry.hpp"
+#include "group_list.hpp"
+#include "announce_scheduler.hpp"
+#include "send_pool.hpp"
+#include "follower_group.hpp"
+#include "multicast.hpp"
+#include "reorder_window.hpp"
+#include "actuation_coalescer.hpp"
 
 // V2V external
 static const int BROADCAST_CHANNEL = 250;
@@ -41,6 +62,7 @@ static const int INTERNAL_GET_ALL_GROUPS_REQUEST = 4004;
 static const int INTERNAL_GET_ALL_GROUPS_RESPONSE = 4005;
 static const int INTERNAL_EMERGENCY_BRAKE = 4006;
 static const int INTERNAL_ANNOUNCE_PRESENCE = 4007;
+static const int INTERNAL_GET_ALL_GROUPS_BATCH = 4008;
  
 // Motor Proxy
 static const int MOTOR_BROADCAST_CHANNEL = 180;
@@ -51,66 +73,321 @@ static const int GROUND_STEERING_READING = 1045;
 // Ultrasonic reading
 static const int DISTANCE_READING = 1039;
 
+// Message frequencies according to protocol.
+static const std::chrono::milliseconds LEADER_STATUS_INTERVAL(125);
+static const std::chrono::milliseconds FOLLOWER_STATUS_INTERVAL(500);
+
+/*
+ * Silence after which a peer is lost. Leader updates are more frequent than follower statuses, so the leader is given
+ * up on sooner. Losses are detected at most LIVENESS_RESOLUTION after the timeout.
+ */
+static const std::chrono::milliseconds LEADER_TIMEOUT(1000);
+static const std::chrono::milliseconds FOLLOWER_TIMEOUT(2000);
+static const std::chrono::milliseconds LIVENESS_RESOLUTION(10);
+
+/*
+ * A follower that joined its leader's multicast group and hears nothing for this long leaves it again, and asks for
+ * unicast with the FollowerStatus going out right after. Well within LEADER_TIMEOUT, so the session survives.
+ */
+static const std::chrono::milliseconds MULTICAST_FALLBACK_TIMEOUT(250);
+
+// Capability bits of AnnouncePresence.
+static const uint32_t CAPABILITY_BINARY_FRAMING = 1;
+static const uint32_t CAPABILITY_CLOCK_SYNC = 2;
+
+// Cars that have not announced themselves for PEER_TTL are forgotten, checked every PEER_EXPIRY_INTERVAL.
+static const std::chrono::milliseconds PEER_TTL(60000);
+static const std::chrono::milliseconds PEER_EXPIRY_INTERVAL(1000);
+
+// How often the event loop checks whether we are due to announce our presence.
+static const std::chrono::milliseconds ANNOUNCE_TICK(50);
+
+// Name of our leader in the liveness tracker, followers are watched under their Follower::peer name.
+static const char *const LEADER_PEER = "leader";
 
+/*
+ * Sender stamp of the messages we relay to the internal channel. Those another car sent us carry its IPv4 address, see
+ * senderStampOf, those we send ourselves carry OWN_SENDER_STAMP. A recording of the internal channel thereby tells
+ * which car each message came from, or that it went out from us.
+ */
+static const uint32_t OWN_SENDER_STAMP = 0;
+
+uint32_t senderStampOf(const std::string &ip);
+std::string senderIpOf(uint32_t senderStamp);
+
+
+/**
+ * Speed and steering angle of our car as last read from the motor channel, together with the time of the newer of
+ * the two readings on the monotonic clock.
+ */
 struct CarStatus {
     float speed;
     float steeringAngle;
+    std::chrono::steady_clock::time_point sampled;
+};
+
+// Room for 32 seconds of leader updates at the protocol rate of 8 Hz.
+static const size_t LEADER_UPDATE_QUEUE_SIZE = 256;
+
+// A queued leader status together with the leader timestamp (ms) to replay it by, 0 for the standard delay.
+typedef std::pair<uint64_t, LeaderStatus> LeaderUpdate;
+
+/*
+ * TIME replays every leader update a fixed delay after the leader sent it. DISTANCE replays it once we have driven as
+ * far as the leader had when sending it, see DistanceTrail.
+ */
+enum class FollowMode {
+    TIME,
+    DISTANCE
+};
+
+/*
+ * BATCHED answers a get all groups request with InternalGetAllGroupsBatch pages. PER_CAR sends one
+ * InternalGetAllGroupsResponse per car, for remote controls that do not know the batched response.
+ */
+enum class GroupsResponseMode {
+    BATCHED,
+    PER_CAR
+};
+
+/*
+ * UNICAST sends every follower its own LeaderStatus. MULTICAST offers our followers a multicast group as well, see
+ * FollowResponse, and joins the group a leader offers us. Either side falls back to unicast when multicast fails.
+ */
+enum class LeaderStatusMode {
+    UNICAST,
+    MULTICAST
+};
+
+/*
+ * LIVE joins the OD4 channels, listens on DEFAULT_PORT and sends to other cars. OFFLINE opens no channel or socket,
+ * for replaying recorded sessions and testing: datagrams only come in through receiveDatagram, nothing goes out and
+ * motor commands only reach the actuation observer. The car status then only changes through setCurrentCarStatus.
+ * V2V_ONLY talks to other cars like LIVE, but listens and sends on its own IP only and joins no OD4 channel, so several
+ * services run side by side on the 127.0.0.x addresses of one machine, as in a convoy benchmark. Motor commands and
+ * the car status are then the same as OFFLINE.
+ */
+enum class Networking {
+    LIVE,
+    OFFLINE,
+    V2V_ONLY
 };
 
 
 class V2VService {
 public:
-    V2VService(std::string ip, std::string groupId, float offSteering);
+    V2VService(const std::string &ip, const std::string &groupId, float offSteering,
+               const TimeSource &timeSource = TimeSource::system(), Networking networking = Networking::LIVE);
+    ~V2VService();
 
     // V2V message functions
     void announcePresence();
-    void followRequest(std::string vehicleIp);
-    void followResponse();
+    void followRequest(const std::string &vehicleIp);
+    void followResponse(const std::string &followerIp);
     void stopFollow();
     void stopCar();
 
     // Leading
-    void startReportingToFollower();
+    void startReportingToFollower(const std::shared_ptr<Follower> &follower);
     void leaderStatus(float speed, float steeringAngle);
     
     // Following
-    void processLeaderStatus(LeaderStatus leaderStatusUpdate);
+    void processLeaderStatus(const LeaderStatus &leaderStatusUpdate);
     void startReportingToLeader();
     void followerStatus();
     void startFollowing();
+    bool isFollowing();
     
     // Testing
     void healthCheck();
+    void receiveDatagram(const std::string &data, const std::string &senderIp);
+    size_t getTimedThreads();
     
+    // Announcing our presence automatically, on by default
+    void startAnnouncing(std::chrono::milliseconds period = ANNOUNCE_PERIOD,
+                         std::chrono::milliseconds maxPeriod = ANNOUNCE_MAX_PERIOD);
+    void stopAnnouncing();
+    uint64_t getAnnouncementsSent() const;
+    uint64_t getAnnouncementsReceived() const;
+
     // Utility
-    std::map<std::string, std::string> getMapOfIps();
+    std::shared_ptr<const PeerSnapshot> getPeers() const;
+    std::string getLeaderIp() const;
+    std::vector<std::string> getFollowerIps();
     
-    static uint64_t getTime();
+    uint64_t getTime() const;
 
-    CarStatus *getCurrentCarStatus();
-    CarStatus *setCurrentCarStatus(struct CarStatus *newCarStatus);
+    CarStatus getCurrentCarStatus() const;
+    CarStatus setCurrentCarStatus(const CarStatus &newCarStatus);
     
-    std::queue<std::pair<uint64_t, LeaderStatus>> *getLeaderUpdates();
+    bool popLeaderUpdate(LeaderUpdate &update);
+    uint64_t getLeaderUpdateOverflows() const;
+    size_t getLeaderUpdateHighWaterMark() const;
+    ReplayScheduler &getReplayScheduler();
+    DistanceTrail &getDistanceTrail();
+
+    void setFollowMode(FollowMode mode);
+    FollowMode getFollowMode() const;
+    void setGroupsResponseMode(GroupsResponseMode mode);
+    GroupsResponseMode getGroupsResponseMode() const;
+    void setLeaderStatusMode(LeaderStatusMode mode);
+    LeaderStatusMode getLeaderStatusMode() const;
     
-    bool isLeaderMoving;
+    std::atomic<bool> isLeaderMoving;
     
     void sendSteering(float steering);
     void sendSpeed(float speed);
+    void setActuationObserver(const std::function<void(int32_t dataType, float value)> &observer);
 
-    // V2V public status fields 
-    std::string leaderIp;
-    std::string followerIp;
-
-    uint64_t lastFollowerUpdate;
-    uint64_t lastLeaderUpdate;
-    
 private:
-    std::queue<std::pair<uint64_t, LeaderStatus>> leaderUpdates;
+    /*
+     * Every timeout, delay and schedule is on the monotonic clock of the time source, only the timestamps sent to
+     * other cars are on its wall clock. Declared first since the members below are constructed with it.
+     */
+    const TimeSource &timeSource;
+
+    void openChannels();
+    void listen(const std::string &address);
 
-    CarStatus currentCarStatus;
+    // Sends to the internal channel, nothing while OFFLINE.
+    template <class T>
+    void sendInternal(T &msg) {
+        if (internalBroadCast != nullptr) {
+            internalBroadCast->send(msg);
+        }
+    }
+
+    // Relays a message another car sent us to the internal channel, stamped with the car it came from.
+    template <class T>
+    void sendInternal(T &msg, const std::string &senderIp) {
+        if (internalBroadCast != nullptr) {
+            internalBroadCast->send(msg, cluon::data::TimeStamp(), senderStampOf(senderIp));
+        }
+    }
+
+    // Run on the event loop while we have a leader or followers.
+    void reportToLeader();
+    void reportToFollowers();
+    void queueLeaderStatus(float speed, float steeringAngle);
+    void queueFollowerStatus();
+    void stopReportingToLeader();
+    std::vector<std::shared_ptr<Follower>> stopReportingToFollowers();
+    void dropFollower(const std::string &followerIp, bool notify);
+
+    // Leader statuses, through unicast or our leader's multicast group.
+    bool isLeader(const std::string &ip) const;
+    void receiveLeaderStatus(const Frame &msg, const std::string &senderIp, int64_t receivedMicros);
+    void processLeaderStatusLocked(const LeaderStatus &leaderStatusUpdate);
+    void joinLeaderGroup(const std::string &group, uint16_t port);
+    void leaveLeaderGroup();
+    void expireLeaderWindow();
+
+    // Liveness of the leader and the followers.
+    void watchPeer(const std::string &peer, std::chrono::milliseconds timeout, std::chrono::milliseconds interval,
+                   LivenessTracker::LossCallback onLoss);
+    void tickLiveness();
+    void printPeerMetrics(const std::string &peer, const std::string &ip);
+
+    // Run on the follower thread while following.
+    void runFollowerThread();
+    void executeLeaderUpdates();
+    void followLeaderTrail();
+    bool waitWhileFollowing(std::chrono::steady_clock::time_point deadline,
+                            const std::function<bool()> &wake = nullptr);
+    void endFollowing();
+    void wakeFollower();
+
+    /*
+     * Periodic status messages are sent from the event loop. The tasks are armed when a session with a leader or the
+     * first follower starts and disarmed when it or the last follower ends, 0 while there is none.
+     */
+    EventLoop eventLoop;
+    std::atomic<EventLoop::TaskId> leaderStatusTask;
+    std::atomic<EventLoop::TaskId> followerStatusTask;
+    std::atomic<EventLoop::TaskId> leaderWindowTask;
+
+    /*
+     * Peers are watched while we report to them. The tracker's wheel is ticked from the event loop, the tick task is
+     * only armed while a peer is watched. livenessMutex keeps arming and disarming it in step with the watched peers.
+     */
+    LivenessTracker liveness;
+    std::mutex livenessMutex;
+    EventLoop::TaskId livenessTask = 0;
+
+    // When our last FollowRequest went out, the FollowResponse to it gives the round trip time to the leader.
+    std::atomic<std::chrono::steady_clock::time_point> followRequestSent;
+
+    /*
+     * Offset of the leader's wall clock against ours, estimated from the status messages we exchange with it. Towards
+     * our followers we only play the leader's part, stamping and echoing with each follower's own ClockSync, the
+     * followers do the estimation.
+     */
+    ClockSync leaderClock;
+
+    /*
+     * The cars following us, each watched on its own. followersMutex keeps the leader status task armed in step with
+     * the group being non-empty.
+     */
+    FollowerGroup followers;
+    std::mutex followersMutex;
+
+    // Cars that announced their presence, expired from the event loop.
+    PeerRegistry peers;
+    AnnounceScheduler announcer;
+    std::atomic<uint64_t> announcementsSent;
+    std::atomic<uint64_t> announcementsReceived;
+    std::atomic<GroupsResponseMode> groupsResponseMode;
+    uint32_t lastGroupListBatch = 0;
 
-    std::map<std::string, std::string> mapOfIps;
-    std::map<std::string, std::string> mapOfIds;
+    void sendAllGroups();
+
+    /*
+     * The follower thread lives as long as the service. It sleeps until a follow session starts, then actuates leader
+     * updates until the session ends. followerBusy is set while it is inside a session, startFollowing waits for it to
+     * clear before preparing the next one. Guarded by followMutex. While there is nothing to actuate the thread waits on
+     * followSignal as well, processLeaderStatus signals it when that changes. sessionMode is the follow mode of the
+     * session, startFollowing sets it with leaderStatusMutex held as well, which is what processLeaderStatus reads it
+     * under.
+     */
+    std::thread followerThread;
+    std::mutex followMutex;
+    std::condition_variable followSignal;
+    bool followActive = false;
+    bool followerBusy = false;
+    bool shuttingDown = false;
+    FollowMode sessionMode = FollowMode::TIME;
+
+    /*
+     * Leader updates are pushed with leaderStatusMutex held only, one at a time (processLeaderStatus and the pre fill
+     * in startFollowing), and popped by the follower thread only. startFollowing also clears the queue, while the
+     * follower thread is idle.
+     */
+    SpscQueue<LeaderUpdate, LEADER_UPDATE_QUEUE_SIZE> leaderUpdates;
+
+    // Only used by the follower thread.
+    ReplayScheduler replayScheduler;
+
+    // The mode the next session starts in, set from any thread.
+    std::atomic<FollowMode> followMode;
+    DistanceTrail distanceTrail;
+
+    /*
+     * Our own odometry while leading, the source of the distanceTraveled field, and what it is advanced from. Statuses
+     * are sent from the event loop and from whoever calls leaderStatus, and the first follower joining resets them, so
+     * all of it is guarded by leaderReportMutex. Taken after followersMutex.
+     */
+    std::mutex leaderReportMutex;
+    Odometry leaderOdometry;
+    // Sequence number of the last LeaderStatus sent, counted from the first follower joining.
+    uint32_t leaderSequence;
+    float lastReportedSpeed = 0.0f;
+    std::chrono::steady_clock::time_point lastLeaderStatusSent;
+
+    /*
+     * Written by the motor channel thread only, or through setCurrentCarStatus while OFFLINE, read from everywhere.
+     * Readers always get a speed and steering angle that were current together.
+     */
+    SeqLock<CarStatus> currentCarStatus;
 
     float sensorRange[5];
     int index;
@@ -118,6 +395,16 @@ private:
     float speedOffset = 0.0;
     float steeringOffset;
 
+    /*
+     * Commands only go out to the motor when they changed or are due again, actuationMutex keeps the follower thread
+     * and the UDP receiver thread from deciding for the same command at once.
+     */
+    std::mutex actuationMutex;
+    ActuationCoalescer speedCommands;
+    ActuationCoalescer steeringCommands;
+    // Told about every command sent, under actuationMutex.
+    std::function<void(int32_t dataType, float value)> actuationObserver;
+
     std::string myIp;
     std::string myGroupId;
     
@@ -126,14 +413,32 @@ private:
     std::shared_ptr<cluon::OD4Session>  broadcast;
     
     std::shared_ptr<cluon::UDPReceiver> incoming;
-    std::shared_ptr<cluon::UDPSender>   toLeader;
-    std::shared_ptr<cluon::UDPSender>   toFollower;
 
-    static std::pair<int16_t, std::string> extract(std::string data);
-    template <class T>
-    static std::string encode(T msg);
-    template <class T>
-    static T decode(std::string data);
+    /*
+     * Datagrams to the leader and the followers go through the send pool. Statuses queued by the event loop tasks go
+     * out together once the tasks of a round have run. The leader's context is swapped from several threads, it is
+     * only ever accessed through the std::atomic_ functions, null while there is no leader. It is also where the IP
+     * of our leader is kept, so whoever reads it gets the leader as a whole.
+     */
+    SendPool sendPool;
+    std::shared_ptr<PeerSendContext> toLeader;
+
+    // Framing negotiated with the leader, legacy hex until it has advertised binary framing. Followers keep their own.
+    std::atomic<Framing> leaderFraming;
+
+    /*
+     * The multicast group of our leader, null while we have not joined one. Only ever accessed through
+     * std::atomic_load and std::atomic_store, like toLeader. Leader statuses come in on its thread and on the unicast
+     * receiver thread, leaderStatusMutex has them processed one at a time so the update queue keeps a single producer.
+     * startFollowing holds it while it prepares the queue.
+     */
+    std::atomic<LeaderStatusMode> leaderStatusMode;
+    std::shared_ptr<MulticastReceiver> leaderGroup;
+    std::mutex leaderStatusMutex;
+    std::atomic<std::chrono::steady_clock::time_point> lastLeaderStatus;
+
+    // Leader statuses are processed in the order the leader sent them, guarded by leaderStatusMutex.
+    ReorderWindow leaderWindow;
 };
 
 #endif // V2V_PROTOCOL_H
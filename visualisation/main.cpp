@@ -1,21 +1,99 @@
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <map>
 #include <fstream>
 #include <string>
 
+#include "visualisation/headless.hpp"
 #include "visualisation/visualisation.hpp"
 
+/**
+ * Main file of the visualisation microservice. Relays the messages of the car to the channel the viewer listens to, or
+ * with --headless relays synthetic traffic for a while and reports how that went.
+ *
+ * Options, all of them optional, are given as --name=value:
+ *   --cid       channel to relay to, the one the viewer listens to (182)
+ *   --relay     messages to relay per channel, see RelayTable::parse, for example "181:2001,3001;180:*"
+ *   --decimate  how often to relay them per type, see parseDecimationRules, for example "1041:latest:100", empty to
+ *               relay every message
+ *   --headless  seconds to relay synthetic traffic for instead of relaying for good
+ *   --rate      messages per second of synthetic traffic (1000)
+ */
 
 using namespace std;
-int main(int /*argc*/, char** /*argv*/) {
-   
-    shared_ptr<VIZService> vizService = make_shared<VIZService>("192.168.43.212", "7");
-		
+
+static const char *const OPTIONS[] = {"cid", "relay", "decimate", "headless", "rate"};
+
+static void usage(const char *name) {
+    cerr << "Usage: " << name << " [--cid=182] [--relay=channel:type,type;channel:*] "
+         << "[--decimate=type:all|interval|latest|aggregate:ms;...] [--headless=seconds] [--rate=1000]" << endl;
+}
+
+/*
+ * Reads a positive number no larger than max, false if the text is anything else.
+ */
+static bool parsePositive(const string &text, long max, long &value) {
+    char *end;
+    value = strtol(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0' && value > 0 && value <= max;
+}
+
+int main(int argc, char** argv) {
+    map<string, string> options;
+    for (int i = 1; i < argc; i++) {
+        string argument(argv[i]);
+        size_t equals = argument.find('=');
+        string name = argument.substr(0, equals).substr(argument.compare(0, 2, "--") == 0 ? 2 : 0);
+        if (argument.compare(0, 2, "--") != 0 || equals == string::npos ||
+            find(begin(OPTIONS), end(OPTIONS), name) == end(OPTIONS)) {
+            usage(argv[0]);
+            return 1;
+        }
+        options[name] = argument.substr(equals + 1);
+    }
+
+    long channel = VISUALIZATION_CHANNEL;
+    RelayTable relayTable(DEFAULT_RELAY_ROUTES);
+    vector<DecimationRule> decimationRules = defaultDecimationRules();
+    long seconds = 0;
+    long rate = 1000;
+    if ((options.count("cid") && !parsePositive(options["cid"], UINT16_MAX, channel)) ||
+        (options.count("relay") && !RelayTable::parse(options["relay"], relayTable)) ||
+        (options.count("decimate") && !parseDecimationRules(options["decimate"], decimationRules)) ||
+        (options.count("headless") && !parsePositive(options["headless"], 24 * 3600, seconds)) ||
+        (options.count("rate") && !parsePositive(options["rate"], 1000000, rate))) {
+        usage(argv[0]);
+        return 1;
+    }
+    cout << "Relaying " << relayTable.toString() << " to channel " << channel << ", decimating "
+         << toString(decimationRules) << endl;
+
+    if (seconds > 0) {
+        cout << "Headless, " << rate << " messages per second for " << seconds << " s" << endl;
+        HeadlessReport report = runHeadless(relayTable, decimationRules, static_cast<uint16_t>(channel),
+                                            static_cast<int>(rate), chrono::seconds(seconds));
+        if (report.sent == 0) {
+            cerr << "None of the synthetic traffic is on a channel in the relay table" << endl;
+            return 1;
+        }
+        cout << "Sent " << report.sent << " (" << (double) report.sent / report.seconds << "/s), delivered "
+             << report.delivered << " (" << (double) report.delivered / report.seconds << "/s) and "
+             << report.aggregates << " aggregates" << endl;
+        cout << "Filtered " << report.filtered << ", decimated " << report.decimated << ", dropped "
+             << report.dropped << endl;
+        cout << "Relay latency p50 " << report.p50Millis << " ms, p99 " << report.p99Millis << " ms" << endl;
+        return 0;
+    }
+
+    shared_ptr<VIZService> vizService = make_shared<VIZService>(relayTable, decimationRules,
+                                                                static_cast<uint16_t>(channel));
+
     using namespace std::chrono_literals;
-    while (true) {        
+    while (true) {
         // delay
         std::this_thread::sleep_for(500ms);
-    		
+
 
 
 	}
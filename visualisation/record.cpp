@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "recorder/recorder.hpp"
+#include "visualisation/visualisation.hpp"
+
+/**
+ * Main file of the recorder microservice. Records everything on the motor, internal, visualisation and V2V channels to
+ * a recording, see recorder/recording.hpp, or with --info describes a recording.
+ *
+ * Options, all of them optional, are given as --name=value:
+ *   --out   the recording to create (recording-<seconds since the epoch>.g7r)
+ *   --info  a recording to describe instead of recording
+ */
+
+using namespace std;
+
+static const uint16_t RECORDED_CHANNELS[] = {
+    MOTOR_BROADCAST_CHANNEL, INTERNAL_BROADCAST_CHANNEL, VISUALIZATION_CHANNEL, BROADCAST_CHANNEL
+};
+// How often the recorder tells how it is doing.
+static const chrono::seconds RECORDER_REPORT_PERIOD(10);
+
+static int describe(const string &path) {
+    RecordingReader reader;
+    if (!reader.open(path)) {
+        cerr << "Could not read the recording " << path << endl;
+        return 1;
+    }
+    map<uint16_t, uint64_t> perChannel;
+    map<int32_t, uint64_t> perType;
+    RecordView record;
+    while (reader.next(record)) {
+        perChannel[record.header.channel]++;
+        perType[record.header.dataType]++;
+    }
+    cout << path << ": " << reader.records() << " records in " << reader.chunks() << " chunks" << endl;
+    if (reader.chunks() > 0) {
+        int64_t first = reader.chunk(0).firstMicros;
+        int64_t last = reader.chunk(reader.chunks() - 1).lastMicros;
+        cout << "From " << first << " to " << last << " us since the epoch, " << (double) (last - first) / 1000000.0
+             << " s" << endl;
+    }
+    for (const auto &channel : perChannel) {
+        cout << "Channel " << channel.first << ": " << channel.second << endl;
+    }
+    for (const auto &type : perType) {
+        cout << "Type " << type.first << ": " << type.second << endl;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    map<string, string> options;
+    for (int i = 1; i < argc; i++) {
+        string argument(argv[i]);
+        size_t equals = argument.find('=');
+        if (argument.compare(0, 2, "--") != 0 || equals == string::npos ||
+            (argument.substr(2, equals - 2) != "out" && argument.substr(2, equals - 2) != "info")) {
+            cerr << "Usage: " << argv[0] << " [--out=recording.g7r] [--info=recording.g7r]" << endl;
+            return 1;
+        }
+        options[argument.substr(2, equals - 2)] = argument.substr(equals + 1);
+    }
+    if (options.count("info")) {
+        return describe(options["info"]);
+    }
+
+    string path = options.count("out") ? options["out"] : "recording-" + to_string(time(nullptr)) + ".g7r";
+    Recorder recorder(path, vector<uint16_t>(begin(RECORDED_CHANNELS), end(RECORDED_CHANNELS)));
+    if (!recorder.isRecording()) {
+        return 1;
+    }
+    cout << "Recording channels 180, 181, 182 and 250 to " << path << endl;
+
+    while (true) {
+        this_thread::sleep_for(RECORDER_REPORT_PERIOD);
+        cout << "Recorded " << recorder.getRecorded() << ", dropped " << recorder.getDropped() << ", written "
+             << recorder.getChunksWritten() << " chunks of " << recorder.getBytesWritten() << " bytes" << endl;
+    }
+}
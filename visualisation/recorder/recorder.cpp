@@ -0,0 +1,266 @@
+#include "recorder.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/**
+ * Implementation of the Recorder class as declared in recorder.hpp
+ */
+
+static int64_t microsOf(const cluon::data::TimeStamp &stamp) {
+    return stamp.seconds() * 1000000LL + stamp.microseconds();
+}
+
+/**
+ * Constructor for the Recorder, creates the recording and starts recording right away.
+ *
+ * @param path - the recording, which must not exist yet
+ * @param channels - the channels to record
+ */
+Recorder::Recorder(const std::string &path, const std::vector<uint16_t> &channels) :
+    buffers(RECORDER_BUFFERS), filling(nullptr), stopping(false),
+    recorded(0), dropped(0), chunksWritten(0), bytesWritten(0) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+    RecordingHeader header = {};
+    std::memcpy(header.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    header.version = RECORDING_VERSION;
+    if (fd < 0 || ::write(fd, &header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+        std::cerr << "Could not create the recording " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+        return;
+    }
+
+    // Everything a chunk can hold is allocated here, so filling a chunk never reallocates it.
+    for (Buffer &buffer : buffers) {
+        buffer.records.reserve(RECORDER_CHUNK_BYTES);
+        buffer.index.reserve(RECORDER_CHUNK_BYTES / sizeof(RecordHeader) / RECORD_INDEX_STRIDE + 1);
+        freeBuffers.push_back(&buffer);
+    }
+    fullBuffers.reserve(RECORDER_BUFFERS);
+    filling = freeBuffers.back();
+    freeBuffers.pop_back();
+    writer = std::thread(&Recorder::write, this);
+
+    for (uint16_t channel : channels) {
+        sources.push_back(std::make_shared<cluon::OD4Session>(
+            channel,
+            [this, channel](cluon::data::Envelope &&envelope) noexcept {
+                record(channel, envelope);
+            }));
+    }
+}
+
+/**
+ * Destructor for the Recorder, stops the sessions and writes what was recorded before returning.
+ */
+Recorder::~Recorder() {
+    sources.clear();
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        stopping = true;
+    }
+    bufferSignal.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+/**
+ * @return false if the recording could not be created
+ */
+bool Recorder::isRecording() const {
+    return fd >= 0;
+}
+
+/**
+ * Copies an envelope into the chunk being filled, handing the chunk to the writer once full. Never waits for the disk.
+ *
+ * The envelope only hands out a copy of its payload, which allocates. It is taken before bufferMutex, so the lock is
+ * only ever held for copying into a chunk that has room already.
+ *
+ * @param channel - channel the envelope was received on
+ * @param envelope - the envelope
+ */
+void Recorder::record(uint16_t channel, const cluon::data::Envelope &envelope) {
+    const std::string data = envelope.serializedData();
+    size_t bytes = sizeof(RecordHeader) + data.size();
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    if (filling != nullptr && filling->records.size() + bytes > RECORDER_CHUNK_BYTES) {
+        seal();
+    }
+    if (filling == nullptr || bytes > RECORDER_CHUNK_BYTES) {
+        dropped++;
+        return;
+    }
+
+    // Timed under the lock, so the records of a recording are in the order of their time.
+    RecordHeader header = {};
+    header.receivedMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header.sentMicros = microsOf(envelope.sent());
+    header.sampleMicros = microsOf(envelope.sampleTimeStamp());
+    header.dataType = envelope.dataType();
+    header.senderStamp = envelope.senderStamp();
+    header.channel = channel;
+    header.length = static_cast<uint32_t>(data.size());
+
+    ChunkHeader &chunk = filling->header;
+    if (chunk.records == 0) {
+        chunk.firstMicros = header.receivedMicros;
+    }
+    if (chunk.records % RECORD_INDEX_STRIDE == 0) {
+        filling->index.push_back(IndexEntry{header.receivedMicros, static_cast<uint32_t>(filling->records.size()), 0});
+    }
+    chunk.records++;
+    chunk.lastMicros = header.receivedMicros;
+
+    const char *headerBytes = reinterpret_cast<const char *>(&header);
+    filling->records.insert(filling->records.end(), headerBytes, headerBytes + sizeof(header));
+    filling->records.insert(filling->records.end(), data.begin(), data.end());
+    recorded++;
+}
+
+/**
+ * Hands the chunk being filled to the writer and takes a free one, if there is any. Called with bufferMutex held.
+ */
+void Recorder::seal() {
+    if (filling == nullptr || filling->header.records == 0) {
+        return;
+    }
+    fullBuffers.push_back(filling);
+    filling = nullptr;
+    if (!freeBuffers.empty()) {
+        filling = freeBuffers.back();
+        freeBuffers.pop_back();
+    }
+    bufferSignal.notify_all();
+}
+
+/**
+ * The writer thread. Writes full chunks as they come and the chunk being filled once it is RECORDER_FLUSH_PERIOD old,
+ * so a recording is never more than about that much behind.
+ */
+void Recorder::write() {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    while (true) {
+        bufferSignal.wait_for(lock, RECORDER_FLUSH_PERIOD, [this]() {
+            return !fullBuffers.empty() || stopping;
+        });
+        if (fullBuffers.empty()) {
+            seal();
+        }
+        if (stopping) {
+            seal();
+        }
+        if (fullBuffers.empty()) {
+            if (stopping) {
+                return;
+            }
+            continue;
+        }
+
+        Buffer *buffer = fullBuffers.front();
+        fullBuffers.erase(fullBuffers.begin());
+        lock.unlock();
+        if (!writeChunk(*buffer)) {
+            dropped += buffer->header.records;
+        }
+        buffer->header = ChunkHeader();
+        buffer->records.clear();
+        buffer->index.clear();
+        lock.lock();
+
+        if (filling == nullptr) {
+            filling = buffer;
+        } else {
+            freeBuffers.push_back(buffer);
+        }
+    }
+}
+
+/**
+ * Appends a chunk to the recording and syncs it to disk.
+ *
+ * @param buffer - the chunk
+ * @return false if the chunk could not be written whole
+ */
+bool Recorder::writeChunk(Buffer &buffer) {
+    buffer.header.magic = CHUNK_MAGIC;
+    buffer.header.recordBytes = static_cast<uint32_t>(buffer.records.size());
+    buffer.header.indexEntries = static_cast<uint32_t>(buffer.index.size());
+
+    iovec parts[3];
+    parts[0].iov_base = &buffer.header;
+    parts[0].iov_len = sizeof(ChunkHeader);
+    parts[1].iov_base = buffer.records.data();
+    parts[1].iov_len = buffer.records.size();
+    parts[2].iov_base = buffer.index.data();
+    parts[2].iov_len = buffer.index.size() * sizeof(IndexEntry);
+    size_t total = parts[0].iov_len + parts[1].iov_len + parts[2].iov_len;
+
+    size_t written = 0;
+    int part = 0;
+    while (written < total) {
+        ssize_t result = writev(fd, parts + part, 3 - part);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            std::cerr << "Could not write to the recording: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        written += static_cast<size_t>(result);
+        // Skip what went out of the parts, a write can stop anywhere.
+        size_t left = static_cast<size_t>(result);
+        while (part < 3 && left >= parts[part].iov_len) {
+            left -= parts[part].iov_len;
+            part++;
+        }
+        if (part < 3) {
+            parts[part].iov_base = static_cast<char *>(parts[part].iov_base) + left;
+            parts[part].iov_len -= left;
+        }
+    }
+    fdatasync(fd);
+    chunksWritten++;
+    bytesWritten += total;
+    return true;
+}
+
+/**
+ * @return number of envelopes recorded, whether written yet or not
+ */
+uint64_t Recorder::getRecorded() const {
+    return recorded;
+}
+
+/**
+ * @return number of envelopes not recorded, for lack of a free buffer or because writing them failed
+ */
+uint64_t Recorder::getDropped() const {
+    return dropped;
+}
+
+/**
+ * @return number of chunks written to the recording
+ */
+uint64_t Recorder::getChunksWritten() const {
+    return chunksWritten;
+}
+
+/**
+ * @return number of bytes written to the recording, without its header
+ */
+uint64_t Recorder::getBytesWritten() const {
+    return bytesWritten;
+}
@@ -0,0 +1,78 @@
+#ifndef VISUALISATION_RECORDER
+#define VISUALISATION_RECORDER
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cluon/OD4Session.hpp"
+#include "cluon/Envelope.hpp"
+
+#include "recording.hpp"
+
+// Records of a chunk, a chunk is written in one go once full and otherwise about every RECORDER_FLUSH_PERIOD.
+static const size_t RECORDER_CHUNK_BYTES = 256 * 1024;
+// Chunks filled or waiting to be written, records are dropped when they are all full.
+static const size_t RECORDER_BUFFERS = 8;
+static const std::chrono::milliseconds RECORDER_FLUSH_PERIOD(1000);
+
+/**
+ * Records every envelope received on a set of channels to a recording, see recording.hpp.
+ *
+ * The sessions only copy the envelopes into chunk buffers allocated up front, a writer thread of its own writes the
+ * full chunks to disk and syncs them. Nothing the sessions do waits for the disk, if the writer falls behind for longer
+ * than the buffers last the records that do not fit are dropped and counted.
+ */
+class Recorder {
+public:
+    Recorder(const std::string &path, const std::vector<uint16_t> &channels);
+    ~Recorder();
+
+    bool isRecording() const;
+    void record(uint16_t channel, const cluon::data::Envelope &envelope);
+
+    uint64_t getRecorded() const;
+    uint64_t getDropped() const;
+    uint64_t getChunksWritten() const;
+    uint64_t getBytesWritten() const;
+
+private:
+    struct Buffer {
+        ChunkHeader header;
+        std::vector<char> records;
+        std::vector<IndexEntry> index;
+    };
+
+    void seal();
+    void write();
+    bool writeChunk(Buffer &buffer);
+
+    int fd;
+
+    // Buffers are handed from the sessions to the writer and back under bufferMutex.
+    std::vector<Buffer> buffers;
+    std::mutex bufferMutex;
+    std::condition_variable bufferSignal;
+    Buffer *filling;
+    std::vector<Buffer *> freeBuffers;
+    std::vector<Buffer *> fullBuffers;
+    bool stopping;
+
+    std::atomic<uint64_t> recorded;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> chunksWritten;
+    std::atomic<uint64_t> bytesWritten;
+
+    std::thread writer;
+    // One session per channel, declared last so they stop before what they record to goes away.
+    std::vector<std::shared_ptr<cluon::OD4Session>> sources;
+};
+
+#endif // VISUALISATION_RECORDER
@@ -0,0 +1,170 @@
+#include "recording.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Implementation of the RecordingReader class as declared in recording.hpp
+ */
+
+/**
+ * Constructor for a reader with no recording open.
+ */
+RecordingReader::RecordingReader() :
+    mapped(nullptr), mappedBytes(0), recordCount(0), chunkAt(0), offsetAt(0) {}
+
+RecordingReader::~RecordingReader() {
+    close();
+}
+
+/**
+ * Opens a recording, taking in the chunks up to the first one that is cut short or malformed.
+ *
+ * @param path - the recording
+ * @return false if the file cannot be read or is not a recording
+ */
+bool RecordingReader::open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(RecordingHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void *address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    mapped = static_cast<const char *>(address);
+    mappedBytes = static_cast<size_t>(status.st_size);
+
+    RecordingHeader header;
+    std::memcpy(&header, mapped, sizeof(header));
+    if (std::memcmp(header.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0 ||
+        header.version != RECORDING_VERSION) {
+        close();
+        return false;
+    }
+
+    size_t offset = sizeof(RecordingHeader);
+    while (mappedBytes - offset >= sizeof(ChunkHeader)) {
+        Chunk chunk;
+        std::memcpy(&chunk.header, mapped + offset, sizeof(ChunkHeader));
+        size_t bytes = sizeof(ChunkHeader) + chunk.header.recordBytes +
+                       static_cast<size_t>(chunk.header.indexEntries) * sizeof(IndexEntry);
+        if (chunk.header.magic != CHUNK_MAGIC || bytes > mappedBytes - offset) {
+            break;
+        }
+        chunk.records = mapped + offset + sizeof(ChunkHeader);
+        chunk.index = chunk.records + chunk.header.recordBytes;
+        chunkList.push_back(chunk);
+        recordCount += chunk.header.records;
+        offset += bytes;
+    }
+    return true;
+}
+
+/**
+ * @return number of complete chunks in the recording
+ */
+size_t RecordingReader::chunks() const {
+    return chunkList.size();
+}
+
+/**
+ * @param index - which chunk, below chunks()
+ * @return its header
+ */
+const ChunkHeader &RecordingReader::chunk(size_t index) const {
+    return chunkList[index].header;
+}
+
+/**
+ * @return number of records in the complete chunks
+ */
+uint64_t RecordingReader::records() const {
+    return recordCount;
+}
+
+/**
+ * Reads the next record.
+ *
+ * @param record - receives the record
+ * @return false at the end of the recording, or where a record does not fit its chunk
+ */
+bool RecordingReader::next(RecordView &record) {
+    while (chunkAt < chunkList.size()) {
+        const Chunk &chunk = chunkList[chunkAt];
+        if (chunk.header.recordBytes - offsetAt >= sizeof(RecordHeader)) {
+            std::memcpy(&record.header, chunk.records + offsetAt, sizeof(RecordHeader));
+            if (record.header.length > chunk.header.recordBytes - offsetAt - sizeof(RecordHeader)) {
+                return false;
+            }
+            record.data = chunk.records + offsetAt + sizeof(RecordHeader);
+            offsetAt += static_cast<uint32_t>(sizeof(RecordHeader) + record.header.length);
+            return true;
+        }
+        chunkAt++;
+        offsetAt = 0;
+    }
+    return false;
+}
+
+/**
+ * Moves to the first record received at or after a time, going by the chunk headers and the index of the chunk the
+ * time falls in.
+ *
+ * @param micros - the time, in microseconds since the epoch
+ */
+void RecordingReader::seek(int64_t micros) {
+    chunkAt = 0;
+    offsetAt = 0;
+    while (chunkAt < chunkList.size() && chunkList[chunkAt].header.lastMicros < micros) {
+        chunkAt++;
+    }
+    if (chunkAt == chunkList.size()) {
+        return;
+    }
+    const Chunk &chunk = chunkList[chunkAt];
+    for (uint32_t i = 0; i < chunk.header.indexEntries; i++) {
+        IndexEntry entry;
+        std::memcpy(&entry, chunk.index + i * sizeof(IndexEntry), sizeof(IndexEntry));
+        if (entry.receivedMicros >= micros) {
+            break;
+        }
+        offsetAt = entry.offset;
+    }
+
+    // Within a stride of the record looked for, the rest is a short walk.
+    size_t startChunk = chunkAt;
+    uint32_t start = offsetAt;
+    RecordView record;
+    while (next(record) && chunkAt == startChunk) {
+        if (record.header.receivedMicros >= micros) {
+            offsetAt = start;
+            return;
+        }
+        start = offsetAt;
+    }
+    chunkAt = startChunk + 1;
+    offsetAt = 0;
+}
+
+void RecordingReader::close() {
+    if (mapped != nullptr) {
+        munmap(const_cast<char *>(mapped), mappedBytes);
+    }
+    mapped = nullptr;
+    mappedBytes = 0;
+    chunkList.clear();
+    recordCount = 0;
+    chunkAt = 0;
+    offsetAt = 0;
+}
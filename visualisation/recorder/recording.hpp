@@ -0,0 +1,111 @@
+#ifndef VISUALISATION_RECORDING
+#define VISUALISATION_RECORDING
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * A recording is a file header followed by chunks, appended one at a time and never written to again. A chunk is a
+ * chunk header, its records back to back and an index of the time of every RECORD_INDEX_STRIDE-th record with where it
+ * starts, so a reader can find a point in time without going through every record. Everything is stored in the byte
+ * order of the machine that recorded, little endian on the Pi as on a PC. A chunk cut short, by a crash or power loss,
+ * is where the recording ends.
+ *
+ * The replay tool of the V2V service reads recordings with this file as well.
+ */
+static const char RECORDING_MAGIC[8] = {'G', '7', 'R', 'E', 'C', 'O', 'R', 'D'};
+static const uint32_t RECORDING_VERSION = 1;
+static const uint32_t CHUNK_MAGIC = 0x4b4e4843; // "CHNK"
+static const uint32_t RECORD_INDEX_STRIDE = 64;
+
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct ChunkHeader {
+    uint32_t magic;
+    uint32_t records;
+    uint32_t recordBytes;
+    uint32_t indexEntries;
+    // Times the first and last record of the chunk were received, in microseconds since the epoch.
+    int64_t firstMicros;
+    int64_t lastMicros;
+};
+
+/*
+ * Followed by the length bytes of the serialized message.
+ */
+struct RecordHeader {
+    int64_t receivedMicros;
+    int64_t sentMicros;
+    int64_t sampleMicros;
+    int32_t dataType;
+    uint32_t senderStamp;
+    uint16_t channel;
+    uint16_t reserved;
+    uint32_t length;
+};
+
+struct IndexEntry {
+    int64_t receivedMicros;
+    // Where the record starts, counted from the first record of the chunk.
+    uint32_t offset;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(RecordingHeader) == 16, "RecordingHeader is stored as is");
+static_assert(sizeof(ChunkHeader) == 32, "ChunkHeader is stored as is");
+static_assert(sizeof(RecordHeader) == 40, "RecordHeader is stored as is");
+static_assert(sizeof(IndexEntry) == 16, "IndexEntry is stored as is");
+
+/**
+ * A record read from a recording, its data pointing into the mapped file.
+ */
+struct RecordView {
+    RecordHeader header;
+    const char *data;
+};
+
+/**
+ * Reads a recording by mapping it into memory, going through its records in the order they were recorded.
+ *
+ * Not thread safe.
+ */
+class RecordingReader {
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    bool open(const std::string &path);
+
+    size_t chunks() const;
+    const ChunkHeader &chunk(size_t index) const;
+    uint64_t records() const;
+
+    bool next(RecordView &record);
+    void seek(int64_t micros);
+
+private:
+    struct Chunk {
+        ChunkHeader header;
+        const char *records;
+        const char *index;
+    };
+
+    void close();
+
+    const char *mapped;
+    size_t mappedBytes;
+    std::vector<Chunk> chunkList;
+    uint64_t recordCount;
+
+    // Position of next, the chunk and the offset into its records.
+    size_t chunkAt;
+    uint32_t offsetAt;
+};
+
+#endif // VISUALISATION_RECORDING
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "recorder/recorder.hpp"
+#include "visualisation/headless.hpp"
+
+/**
+ * What recording costs the sessions at a fixed rate, and whether the writer keeps up.
+ *
+ * A synthetic mix of the messages a car produces is handed to Recorder::record at the given rate, as the sessions
+ * would, while the writer thread writes to the given file, so run it on the disk that is recorded to, the SD card of
+ * the car. The time each call takes is measured, and once done the recording is read back and checked to hold every
+ * message that was not dropped.
+ *
+ * Usage: recorder_benchmark <recording to create> [messages per second] [seconds]
+ */
+int main(int argc, char **argv) {
+    int rate = argc > 2 ? std::atoi(argv[2]) : 1000;
+    int seconds = argc > 3 ? std::atoi(argv[3]) : 30;
+    if (argc < 2 || rate <= 0 || seconds <= 0) {
+        std::cerr << "Usage: " << argv[0] << " <recording to create> [messages per second] [seconds]" << std::endl;
+        return 1;
+    }
+    std::vector<std::pair<uint16_t, cluon::data::Envelope>> mix = syntheticTraffic();
+
+    using namespace std::chrono;
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<size_t>(rate * seconds));
+    uint64_t recorded, dropped;
+    steady_clock::time_point stop;
+    {
+        Recorder recorder(argv[1], std::vector<uint16_t>());
+        if (!recorder.isRecording()) {
+            return 1;
+        }
+        nanoseconds interval(1000000000LL / rate);
+        steady_clock::time_point next = steady_clock::now();
+        for (int i = 0; i < rate * seconds; i++) {
+            next += interval;
+            std::this_thread::sleep_until(next);
+            const std::pair<uint16_t, cluon::data::Envelope> &message = mix[static_cast<size_t>(i) % mix.size()];
+
+            steady_clock::time_point start = steady_clock::now();
+            recorder.record(message.first, message.second);
+            latencies.push_back(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+        }
+        recorded = recorder.getRecorded();
+        dropped = recorder.getDropped();
+        stop = steady_clock::now();
+    }
+    // Going out of scope the recorder wrote what was left.
+    double stopMillis = duration_cast<duration<double, std::milli>>(steady_clock::now() - stop).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << rate << " messages per second for " << seconds << " s: record p50 "
+              << (double) latencies[latencies.size() / 2] / 1000.0 << " us, p99 "
+              << (double) latencies[latencies.size() * 99 / 100] / 1000.0 << " us, max "
+              << (double) latencies.back() / 1000.0 << " us" << std::endl;
+    std::cout << "Recorded " << recorded << ", dropped " << dropped << ", stopped in " << stopMillis << " ms"
+              << std::endl;
+
+    RecordingReader reader;
+    if (!reader.open(argv[1])) {
+        std::cerr << "Could not read back " << argv[1] << std::endl;
+        return 1;
+    }
+    uint64_t read = 0;
+    RecordView record;
+    while (reader.next(record)) {
+        read++;
+    }
+    std::cout << "Read back " << read << " records in " << reader.chunks() << " chunks" << std::endl;
+    return read == recorded ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "visualisation/headless.hpp"
+#include "visualisation/visualisation.hpp"
+
+/**
+ * Cost per message of the visualisation relay at a fixed input rate.
+ *
+ * A synthetic mix of the messages a car produces is handed to the relay at the given rate, as if received on their
+ * channels. Each message is relayed twice, in separate runs: by VIZService::relay, which forwards the envelope as it
+ * is, and by the decode and encode again per type the service did before, kept here as the baseline. The CPU time of
+ * the relaying thread and the time the call takes are measured per message. The messages go out on the visualisation
+ * channel for real, so nothing else should be using channels 180, 181, 182 and 250 meanwhile.
+ *
+ * Usage: relay_benchmark [messages per second] [seconds]
+ */
+
+struct Sample {
+    int64_t cpuNanos;
+    int64_t wallNanos;
+};
+
+/*
+ * The switch VIZService relayed with before, decoding every message and encoding it again.
+ */
+static void legacyRelay(cluon::OD4Session &visualisation, cluon::data::Envelope &&envelope) {
+    using namespace opendlv::proxy;
+    switch (envelope.dataType()) {
+        case ANNOUNCE_PRESENCE: {
+            AnnouncePresence msg = cluon::extractMessage<AnnouncePresence>(std::move(envelope));
+            visualisation.send(msg);
+            break;
+        }
+        case LEADER_STATUS: {
+            LeaderStatus msg = cluon::extractMessage<LeaderStatus>(std::move(envelope));
+            visualisation.send(msg);
+            break;
+        }
+        case FOLLOWER_STATUS: {
+            FollowerStatus msg = cluon::extractMessage<FollowerStatus>(std::move(envelope));
+            visualisation.send(msg);
+            break;
+        }
+        case DISTANCE_READING: {
+            DistanceReading msg = cluon::extractMessage<DistanceReading>(std::move(envelope));
+            visualisation.send(msg);
+            break;
+        }
+        case PEDAL_POSITION_READING: {
+            PedalPositionReading msg = cluon::extractMessage<PedalPositionReading>(std::move(envelope));
+            visualisation.send(msg);
+            break;
+        }
+        case GROUND_STEERING_READING: {
+            GroundSteeringReading msg = cluon::extractMessage<GroundSteeringReading>(std::move(envelope));
+            visualisation.send(msg);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static int64_t threadCpuNanos() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Hands the mix to the relay at the given rate, measuring every call.
+ */
+template <class F>
+static std::vector<Sample> run(const std::vector<std::pair<uint16_t, cluon::data::Envelope>> &mix, int rate,
+                               int seconds, F relay) {
+    using namespace std::chrono;
+    std::vector<Sample> samples;
+    samples.reserve(static_cast<size_t>(rate * seconds));
+    nanoseconds interval(1000000000LL / rate);
+    steady_clock::time_point next = steady_clock::now();
+    for (int i = 0; i < rate * seconds; i++) {
+        next += interval;
+        std::this_thread::sleep_until(next);
+
+        // Copied outside of the measurement, the relay gets the envelope the session would hand it.
+        const std::pair<uint16_t, cluon::data::Envelope> &message = mix[static_cast<size_t>(i) % mix.size()];
+        cluon::data::Envelope envelope = message.second;
+
+        int64_t cpu = threadCpuNanos();
+        steady_clock::time_point start = steady_clock::now();
+        relay(message.first, std::move(envelope));
+        int64_t wall = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+        samples.push_back(Sample{threadCpuNanos() - cpu, wall});
+    }
+    return samples;
+}
+
+static void report(const std::string &title, std::vector<Sample> samples, double *meanCpu, double *meanWall) {
+    double cpu = 0.0;
+    double wall = 0.0;
+    for (const Sample &sample : samples) {
+        cpu += (double) sample.cpuNanos;
+        wall += (double) sample.wallNanos;
+    }
+    *meanCpu = cpu / (double) samples.size() / 1000.0;
+    *meanWall = wall / (double) samples.size() / 1000.0;
+
+    std::sort(samples.begin(), samples.end(), [](const Sample &a, const Sample &b) {
+        return a.wallNanos < b.wallNanos;
+    });
+    std::cout << title << ": CPU " << *meanCpu << " us, latency mean " << *meanWall << " us, p50 "
+              << (double) samples[samples.size() / 2].wallNanos / 1000.0 << " us, p99 "
+              << (double) samples[samples.size() * 99 / 100].wallNanos / 1000.0 << " us per message" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    int rate = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int seconds = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (rate <= 0 || seconds <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [messages per second] [seconds]" << std::endl;
+        return 1;
+    }
+    std::vector<std::pair<uint16_t, cluon::data::Envelope>> mix = syntheticTraffic();
+
+    // Nothing decimated, every message is relayed in both runs.
+    std::vector<DecimationRule> noDecimation;
+    VIZService vizService(RelayTable(DEFAULT_RELAY_ROUTES), noDecimation);
+    cluon::OD4Session visualisation(VISUALIZATION_CHANNEL);
+
+    std::cout << rate << " messages per second for " << seconds << " s" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    double legacyCpu, legacyWall, passCpu, passWall;
+    report("decode and encode", run(mix, rate, seconds, [&visualisation](uint16_t, cluon::data::Envelope &&envelope) {
+        legacyRelay(visualisation, std::move(envelope));
+    }), &legacyCpu, &legacyWall);
+    report("pass through     ", run(mix, rate, seconds, [&vizService](uint16_t channel,
+                                                                    cluon::data::Envelope &&envelope) {
+        vizService.relay(channel, std::move(envelope));
+    }), &passCpu, &passWall);
+    std::cout << "Saved per message: " << legacyCpu - passCpu << " us CPU, " << legacyWall - passWall
+              << " us latency (" << vizService.getRelayed() << " relayed, " << vizService.getFiltered()
+              << " filtered)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include "decimator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#include "cluon/ToProtoVisitor.hpp"
+#include "messages.hpp"
+
+/**
+ * Implementation of the Decimator class as declared in decimator.hpp
+ */
+
+static const char *const DECIMATION_NAMES[] = {"all", "interval", "latest", "aggregate"};
+
+/*
+ * The reading AGGREGATE works on, false if the type has none.
+ */
+static bool readingOf(const cluon::data::Envelope &envelope, float *value) {
+    using namespace opendlv::proxy;
+    int32_t dataType = envelope.dataType();
+    if (dataType == PedalPositionReading::ID()) {
+        *value = cluon::extractMessage<PedalPositionReading>(cluon::data::Envelope(envelope)).percent();
+    } else if (dataType == GroundSteeringReading::ID()) {
+        *value = cluon::extractMessage<GroundSteeringReading>(cluon::data::Envelope(envelope)).steeringAngle();
+    } else if (dataType == DistanceReading::ID()) {
+        *value = cluon::extractMessage<DistanceReading>(cluon::data::Envelope(envelope)).distance();
+    } else if (dataType == LeaderStatus::ID()) {
+        *value = cluon::extractMessage<LeaderStatus>(cluon::data::Envelope(envelope)).speed();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool hasReading(int32_t dataType) {
+    using namespace opendlv::proxy;
+    return dataType == PedalPositionReading::ID() || dataType == GroundSteeringReading::ID() ||
+           dataType == DistanceReading::ID() || dataType == LeaderStatus::ID();
+}
+
+/**
+ * Reads rules from a list separated by ';' of "<message id>:<mode>:<interval ms>", the mode being one of all, interval,
+ * latest and aggregate. all takes no interval, for example "1041:latest:100;1039:aggregate:250;1001:all".
+ *
+ * @param spec - the list
+ * @param rules - receives the rules, left as they were if the list is malformed
+ * @return false if the list is malformed
+ */
+bool parseDecimationRules(const std::string &spec, std::vector<DecimationRule> &rules) {
+    std::vector<DecimationRule> parsed;
+    std::istringstream entries(spec);
+    std::string entry;
+    while (std::getline(entries, entry, ';')) {
+        if (entry.empty()) {
+            continue;
+        }
+        std::istringstream fields(entry);
+        std::string dataType, mode, interval;
+        std::getline(fields, dataType, ':');
+        std::getline(fields, mode, ':');
+        std::getline(fields, interval, ':');
+
+        char *end;
+        DecimationRule rule;
+        long id = std::strtol(dataType.c_str(), &end, 10);
+        if (dataType.empty() || *end != '\0' || id < 0 || id > INT32_MAX) {
+            return false;
+        }
+        rule.dataType = static_cast<int32_t>(id);
+
+        const char *const *name = std::find(std::begin(DECIMATION_NAMES), std::end(DECIMATION_NAMES), mode);
+        if (name == std::end(DECIMATION_NAMES)) {
+            return false;
+        }
+        rule.mode = static_cast<Decimation>(name - std::begin(DECIMATION_NAMES));
+        if (rule.mode == Decimation::AGGREGATE && !hasReading(rule.dataType)) {
+            return false;
+        }
+
+        rule.interval = std::chrono::milliseconds(0);
+        if (rule.mode == Decimation::ALL) {
+            if (!interval.empty()) {
+                return false;
+            }
+        } else {
+            long millis = std::strtol(interval.c_str(), &end, 10);
+            if (interval.empty() || *end != '\0' || millis <= 0) {
+                return false;
+            }
+            rule.interval = std::chrono::milliseconds(millis);
+        }
+        parsed.push_back(rule);
+    }
+    rules = parsed;
+    return true;
+}
+
+/**
+ * @return the rules in the format parseDecimationRules reads
+ */
+std::string toString(const std::vector<DecimationRule> &rules) {
+    std::ostringstream out;
+    for (size_t i = 0; i < rules.size(); i++) {
+        out << (i > 0 ? ";" : "") << rules[i].dataType << ":" << DECIMATION_NAMES[static_cast<int>(rules[i].mode)];
+        if (rules[i].mode != Decimation::ALL) {
+            out << ":" << rules[i].interval.count();
+        }
+    }
+    return out.str();
+}
+
+/**
+ * Constructor for the decimator.
+ *
+ * @param rules - a rule per message type, a later rule for the same type replaces an earlier one
+ * @param sink - called with every message relayed
+ */
+Decimator::Decimator(const std::vector<DecimationRule> &rules, Sink sink) :
+    sink(std::move(sink)), flushing(false), decimatedCount(0) {
+    for (const DecimationRule &rule : rules) {
+        Stream stream = {};
+        stream.rule = rule;
+        // A type without a reading is held back the same way, just without the aggregate.
+        if (rule.mode == Decimation::AGGREGATE && !hasReading(rule.dataType)) {
+            stream.rule.mode = Decimation::LATEST;
+        }
+        streams[rule.dataType] = stream;
+        flushing = flushing || stream.rule.mode == Decimation::LATEST || stream.rule.mode == Decimation::AGGREGATE;
+    }
+}
+
+/**
+ * Takes in a message, relaying it to the sink, holding it back or dropping it as the rule for its type says.
+ *
+ * @param envelope - the message
+ * @param now - current monotonic time
+ */
+void Decimator::offer(cluon::data::Envelope &&envelope, time_point now) {
+    auto found = streams.find(envelope.dataType());
+    if (found == streams.end() || found->second.rule.mode == Decimation::ALL) {
+        sink(std::move(envelope));
+        return;
+    }
+    Stream &stream = found->second;
+    bool due = !stream.sentBefore || now - stream.lastSent >= stream.rule.interval;
+
+    switch (stream.rule.mode) {
+        case Decimation::MIN_INTERVAL: {
+            if (!due) {
+                decimatedCount++;
+                return;
+            }
+            stream.held = std::move(envelope);
+            stream.holding = true;
+            send(stream, now);
+            break;
+        }
+        case Decimation::LATEST: {
+            if (stream.holding) {
+                decimatedCount++;
+            }
+            stream.held = std::move(envelope);
+            stream.holding = true;
+            if (due) {
+                send(stream, now);
+            }
+            break;
+        }
+        case Decimation::AGGREGATE: {
+            float value = 0.0f;
+            readingOf(envelope, &value);
+            if (stream.count == 0) {
+                stream.windowStart = now;
+                stream.minimum = value;
+                stream.maximum = value;
+                stream.sum = 0.0;
+            }
+            stream.count++;
+            stream.minimum = std::min(stream.minimum, value);
+            stream.maximum = std::max(stream.maximum, value);
+            stream.sum += value;
+
+            if (stream.holding) {
+                decimatedCount++;
+            }
+            stream.held = std::move(envelope);
+            stream.holding = true;
+            if (now - stream.windowStart >= stream.rule.interval) {
+                send(stream, now);
+            }
+            break;
+        }
+        case Decimation::ALL:
+            break;
+    }
+}
+
+/**
+ * Relays the messages held back that are due.
+ *
+ * @param now - current monotonic time
+ */
+void Decimator::flush(time_point now) {
+    for (auto &entry : streams) {
+        Stream &stream = entry.second;
+        if (!stream.holding) {
+            continue;
+        }
+        time_point since = stream.rule.mode == Decimation::AGGREGATE ? stream.windowStart : stream.lastSent;
+        if (now - since >= stream.rule.interval) {
+            send(stream, now);
+        }
+    }
+}
+
+/**
+ * @return true if messages are ever held back, so flush has to be called
+ */
+bool Decimator::needsFlushing() const {
+    return flushing;
+}
+
+/**
+ * @return number of messages not relayed, dropped or replaced by a later one while held back
+ */
+uint64_t Decimator::decimated() const {
+    return decimatedCount;
+}
+
+/**
+ * Relays the message held for a stream, followed by the aggregate of its window for AGGREGATE.
+ */
+void Decimator::send(Stream &stream, time_point now) {
+    sink(std::move(stream.held));
+    stream.holding = false;
+    stream.sentBefore = true;
+    stream.lastSent = now;
+    if (stream.rule.mode != Decimation::AGGREGATE) {
+        return;
+    }
+
+    VisualisationAggregate aggregate;
+    aggregate.dataType(stream.rule.dataType);
+    aggregate.count(stream.count);
+    aggregate.minimum(stream.minimum);
+    aggregate.maximum(stream.maximum);
+    aggregate.mean(static_cast<float>(stream.sum / stream.count));
+    aggregate.windowMillis(static_cast<uint32_t>(stream.rule.interval.count()));
+    stream.count = 0;
+
+    cluon::ToProtoVisitor visitor;
+    aggregate.accept(visitor);
+    int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    cluon::data::TimeStamp stamp;
+    stamp.seconds(static_cast<int32_t>(micros / 1000000));
+    stamp.microseconds(static_cast<int32_t>(micros % 1000000));
+    cluon::data::Envelope envelope;
+    envelope.dataType(VisualisationAggregate::ID());
+    envelope.serializedData(visitor.encodedData());
+    envelope.sent(stamp);
+    envelope.sampleTimeStamp(stamp);
+    sink(std::move(envelope));
+}
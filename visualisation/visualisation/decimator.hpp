@@ -0,0 +1,86 @@
+#ifndef VISUALISATION_DECIMATOR
+#define VISUALISATION_DECIMATOR
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cluon/Envelope.hpp"
+
+// How often held messages are checked for being due.
+static const std::chrono::milliseconds DECIMATION_TICK(10);
+
+/*
+ * ALL relays every message. MIN_INTERVAL relays a message if the one relayed before is at least the interval old and
+ * drops it otherwise. LATEST holds it back instead, replacing what was held, and relays the one held once the interval
+ * passed, so the last value always gets through. AGGREGATE also relays the latest message once per interval, followed
+ * by a VisualisationAggregate with the minimum, maximum and mean of the reading over the messages held back. Only the
+ * motor readings and LeaderStatus have a reading to aggregate.
+ */
+enum class Decimation {
+    ALL,
+    MIN_INTERVAL,
+    LATEST,
+    AGGREGATE
+};
+
+/**
+ * How to decimate the messages of one type.
+ */
+struct DecimationRule {
+    int32_t dataType;
+    Decimation mode;
+    std::chrono::milliseconds interval;
+};
+
+bool parseDecimationRules(const std::string &spec, std::vector<DecimationRule> &rules);
+std::string toString(const std::vector<DecimationRule> &rules);
+
+/**
+ * Bounds the rate the messages of each type are relayed at, following a rule per type. Types without a rule are
+ * relayed as they come. Whatever is relayed goes to the sink, messages held back are relayed from flush, which has to
+ * be called every DECIMATION_TICK for as long as needsFlushing returns true.
+ *
+ * Not thread safe, apart from reading the counters.
+ */
+class Decimator {
+public:
+    typedef std::chrono::steady_clock::time_point time_point;
+    typedef std::function<void(cluon::data::Envelope &&envelope)> Sink;
+
+    Decimator(const std::vector<DecimationRule> &rules, Sink sink);
+
+    void offer(cluon::data::Envelope &&envelope, time_point now);
+    void flush(time_point now);
+    bool needsFlushing() const;
+
+    uint64_t decimated() const;
+
+private:
+    struct Stream {
+        DecimationRule rule;
+        bool sentBefore;
+        time_point lastSent;
+        bool holding;
+        cluon::data::Envelope held;
+        // Window of AGGREGATE, from the first reading held back.
+        time_point windowStart;
+        uint32_t count;
+        float minimum;
+        float maximum;
+        double sum;
+    };
+
+    void send(Stream &stream, time_point now);
+
+    const Sink sink;
+    std::map<int32_t, Stream> streams;
+    bool flushing;
+    std::atomic<uint64_t> decimatedCount;
+};
+
+#endif // VISUALISATION_DECIMATOR
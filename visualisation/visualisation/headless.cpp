@@ -0,0 +1,153 @@
+#include "headless.hpp"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * Implementation of the headless run of the VIZService as declared in headless.hpp
+ */
+
+static int64_t microsNow() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static double percentileMillis(const std::vector<int64_t> &sorted, size_t percent) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    return (double) sorted[std::min(sorted.size() - 1, sorted.size() * percent / 100)] / 1000.0;
+}
+
+/**
+ * A message of every type the relay sees on a car, with the channel it comes in on. Mostly motor readings, the way the
+ * motor channel dominates the traffic of a car.
+ *
+ * @return the messages, to be sent over and over in order
+ */
+std::vector<std::pair<uint16_t, cluon::data::Envelope>> syntheticTraffic() {
+    using namespace opendlv::proxy;
+    std::vector<std::pair<uint16_t, cluon::data::Envelope>> traffic;
+
+    PedalPositionReading pedal;
+    pedal.percent(0.17f);
+    GroundSteeringReading steering;
+    steering.steeringAngle(-0.12f);
+    DistanceReading distance;
+    distance.distance(0.83f);
+    LeaderStatus leaderStatus;
+    leaderStatus.timestamp(1525000000125);
+    leaderStatus.speed(0.17f);
+    leaderStatus.steeringAngle(-0.12f);
+    leaderStatus.distanceTraveled(13);
+    leaderStatus.timestampMicros(1525000000125000);
+    leaderStatus.sequence(4242);
+    FollowerStatus followerStatus;
+    followerStatus.sentMicros(1525000000250000);
+    AnnouncePresence announcePresence;
+    announcePresence.vehicleIp("192.168.43.212");
+    announcePresence.groupId("7");
+
+    for (int i = 0; i < 3; i++) {
+        traffic.emplace_back(MOTOR_BROADCAST_CHANNEL, envelopeOf(pedal));
+        traffic.emplace_back(MOTOR_BROADCAST_CHANNEL, envelopeOf(steering));
+        traffic.emplace_back(MOTOR_BROADCAST_CHANNEL, envelopeOf(distance));
+    }
+    traffic.emplace_back(INTERNAL_BROADCAST_CHANNEL, envelopeOf(leaderStatus));
+    traffic.emplace_back(INTERNAL_BROADCAST_CHANNEL, envelopeOf(followerStatus));
+    traffic.emplace_back(BROADCAST_CHANNEL, envelopeOf(announcePresence));
+    return traffic;
+}
+
+/**
+ * Runs a VIZService against synthetic traffic for a fixed time, listening on the visualisation channel the way the
+ * viewer would. Only the traffic on channels in the relay table is sent. The messages go out over the channels for
+ * real, so nothing else should be using them meanwhile.
+ *
+ * @param table - the messages to relay, per channel
+ * @param rules - how often to relay them, per message type
+ * @param visualisationChannel - channel to relay to
+ * @param rate - messages sent per second
+ * @param duration - how long to send for
+ * @return what was measured
+ */
+HeadlessReport runHeadless(const RelayTable &table, const std::vector<DecimationRule> &rules,
+                           uint16_t visualisationChannel, int rate, std::chrono::seconds duration) {
+    using namespace std::chrono;
+    std::vector<uint16_t> channels = table.channels();
+    std::vector<std::pair<uint16_t, cluon::data::Envelope>> traffic;
+    for (const auto &message : syntheticTraffic()) {
+        if (std::find(channels.begin(), channels.end(), message.first) != channels.end()) {
+            traffic.push_back(message);
+        }
+    }
+    HeadlessReport report = {};
+    if (traffic.empty()) {
+        return report;
+    }
+
+    std::mutex latencyMutex;
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<size_t>(rate * duration.count()));
+    std::atomic<uint64_t> aggregates(0);
+    cluon::OD4Session viewer(visualisationChannel, [&](cluon::data::Envelope &&envelope) noexcept {
+        if (envelope.dataType() == VisualisationAggregate::ID()) {
+            aggregates++;
+            return;
+        }
+        cluon::data::TimeStamp stamp = envelope.sampleTimeStamp();
+        int64_t latency = microsNow() - (stamp.seconds() * 1000000LL + stamp.microseconds());
+        std::lock_guard<std::mutex> lock(latencyMutex);
+        latencies.push_back(latency);
+    });
+
+    {
+        VIZService vizService(table, rules, visualisationChannel);
+        std::map<uint16_t, std::shared_ptr<cluon::OD4Session>> senders;
+        for (const auto &message : traffic) {
+            if (senders.count(message.first) == 0) {
+                senders[message.first] = std::make_shared<cluon::OD4Session>(message.first);
+            }
+        }
+
+        nanoseconds interval(1000000000LL / rate);
+        steady_clock::time_point start = steady_clock::now();
+        steady_clock::time_point next = start;
+        for (int64_t i = 0; i < rate * duration.count(); i++) {
+            next += interval;
+            std::this_thread::sleep_until(next);
+
+            const std::pair<uint16_t, cluon::data::Envelope> &message = traffic[static_cast<size_t>(i) % traffic.size()];
+            cluon::data::Envelope envelope = message.second;
+            int64_t micros = microsNow();
+            cluon::data::TimeStamp stamp;
+            stamp.seconds(static_cast<int32_t>(micros / 1000000));
+            stamp.microseconds(static_cast<int32_t>(micros % 1000000));
+            envelope.sampleTimeStamp(stamp);
+            senders[message.first]->send(std::move(envelope));
+            report.sent++;
+        }
+        report.seconds = std::chrono::duration<double>(steady_clock::now() - start).count();
+
+        milliseconds longest(0);
+        for (const DecimationRule &rule : rules) {
+            longest = std::max(longest, rule.interval);
+        }
+        std::this_thread::sleep_for(longest + HEADLESS_GRACE);
+        report.filtered = vizService.getFiltered();
+        report.decimated = vizService.getDecimated();
+    }
+
+    std::lock_guard<std::mutex> lock(latencyMutex);
+    std::sort(latencies.begin(), latencies.end());
+    report.delivered = latencies.size();
+    report.aggregates = aggregates;
+    uint64_t accounted = report.filtered + report.decimated + report.delivered;
+    report.dropped = report.sent > accounted ? report.sent - accounted : 0;
+    report.p50Millis = percentileMillis(latencies, 50);
+    report.p99Millis = percentileMillis(latencies, 99);
+    return report;
+}
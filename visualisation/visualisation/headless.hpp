@@ -0,0 +1,49 @@
+#ifndef VISUALISATION_HEADLESS
+#define VISUALISATION_HEADLESS
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "cluon/Envelope.hpp"
+#include "cluon/ToProtoVisitor.hpp"
+
+#include "visualisation.hpp"
+
+// How long a headless run waits after the last message for what is held back or still under way.
+static const std::chrono::milliseconds HEADLESS_GRACE(500);
+
+/**
+ * What a headless run measured. Messages sent end up filtered by the relay table, decimated or delivered to the
+ * visualisation channel, whatever is left was dropped on the way. The latency is from sending a message on its channel
+ * to receiving it on the visualisation channel, so it includes the time it is held back by the decimator.
+ */
+struct HeadlessReport {
+    double seconds;
+    uint64_t sent;
+    uint64_t filtered;
+    uint64_t decimated;
+    uint64_t delivered;
+    uint64_t aggregates;
+    uint64_t dropped;
+    double p50Millis;
+    double p99Millis;
+};
+
+template <class T>
+cluon::data::Envelope envelopeOf(T &msg) {
+    cluon::ToProtoVisitor visitor;
+    msg.accept(visitor);
+    cluon::data::Envelope envelope;
+    envelope.dataType(T::ID());
+    envelope.serializedData(visitor.encodedData());
+    return envelope;
+}
+
+std::vector<std::pair<uint16_t, cluon::data::Envelope>> syntheticTraffic();
+
+HeadlessReport runHeadless(const RelayTable &table, const std::vector<DecimationRule> &rules,
+                           uint16_t visualisationChannel, int rate, std::chrono::seconds duration);
+
+#endif // VISUALISATION_HEADLESS
@@ -0,0 +1,134 @@
+#include "relay_table.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+/**
+ * Implementation of the RelayTable class as declared in relay_table.hpp
+ */
+
+/**
+ * Constructor for an empty relay table, relaying nothing.
+ */
+RelayTable::RelayTable() {}
+
+/**
+ * Reads a table from a list of channels separated by ';', each with the message types to relay from it after a ':',
+ * separated by ','. A '*' relays every type, for example "250:1001;181:2001,3001;180:*".
+ *
+ * @param spec - the list
+ * @param table - receives the table, left as it was if the list is malformed
+ * @return false if the list is malformed
+ */
+bool RelayTable::parse(const std::string &spec, RelayTable &table) {
+    RelayTable parsed;
+    std::istringstream channels(spec);
+    std::string entry;
+    while (std::getline(channels, entry, ';')) {
+        if (entry.empty()) {
+            continue;
+        }
+        size_t colon = entry.find(':');
+        if (colon == std::string::npos || colon == 0) {
+            return false;
+        }
+        char *end;
+        long channel = std::strtol(entry.c_str(), &end, 10);
+        if (end != entry.c_str() + colon || channel <= 0 || channel > UINT16_MAX) {
+            return false;
+        }
+        // Reading the types stops quietly at a trailing ',', which is a type left out all the same.
+        if (entry.back() == ',') {
+            return false;
+        }
+
+        std::istringstream types(entry.substr(colon + 1));
+        std::string type;
+        bool any = false;
+        while (std::getline(types, type, ',')) {
+            if (type == "*") {
+                parsed.allow(static_cast<uint16_t>(channel), ANY_DATA_TYPE);
+                any = true;
+                continue;
+            }
+            long dataType = std::strtol(type.c_str(), &end, 10);
+            if (type.empty() || *end != '\0' || dataType < 0 || dataType > INT32_MAX) {
+                return false;
+            }
+            parsed.allow(static_cast<uint16_t>(channel), static_cast<int32_t>(dataType));
+            any = true;
+        }
+        if (!any) {
+            return false;
+        }
+    }
+    table = parsed;
+    return true;
+}
+
+/**
+ * Relays a message type from a channel.
+ *
+ * @param channel - channel the messages are received on
+ * @param dataType - id of the message type, ANY_DATA_TYPE for all of them
+ */
+void RelayTable::allow(uint16_t channel, int32_t dataType) {
+    auto found = std::find_if(entries.begin(), entries.end(), [channel](const Channel &entry) {
+        return entry.channel == channel;
+    });
+    if (found == entries.end()) {
+        entries.push_back(Channel{channel, false, {}});
+        found = entries.end() - 1;
+    }
+    if (dataType == ANY_DATA_TYPE) {
+        found->any = true;
+        return;
+    }
+    auto position = std::lower_bound(found->dataTypes.begin(), found->dataTypes.end(), dataType);
+    if (position == found->dataTypes.end() || *position != dataType) {
+        found->dataTypes.insert(position, dataType);
+    }
+}
+
+/**
+ * @param channel - channel a message was received on
+ * @param dataType - id of its type
+ * @return true if the message is relayed
+ */
+bool RelayTable::relays(uint16_t channel, int32_t dataType) const {
+    for (const Channel &entry : entries) {
+        if (entry.channel == channel) {
+            return entry.any || std::binary_search(entry.dataTypes.begin(), entry.dataTypes.end(), dataType);
+        }
+    }
+    return false;
+}
+
+/**
+ * @return the channels anything is relayed from, in the order they were added
+ */
+std::vector<uint16_t> RelayTable::channels() const {
+    std::vector<uint16_t> result;
+    for (const Channel &entry : entries) {
+        result.push_back(entry.channel);
+    }
+    return result;
+}
+
+/**
+ * @return the table in the format parse reads
+ */
+std::string RelayTable::toString() const {
+    std::ostringstream out;
+    for (size_t i = 0; i < entries.size(); i++) {
+        out << (i > 0 ? ";" : "") << entries[i].channel << ":";
+        if (entries[i].any) {
+            out << "*";
+        }
+        for (size_t j = 0; j < entries[i].dataTypes.size(); j++) {
+            out << (j > 0 || entries[i].any ? "," : "") << entries[i].dataTypes[j];
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,53 @@
+#ifndef VISUALISATION_RELAY_TABLE
+#define VISUALISATION_RELAY_TABLE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A message type on a channel that is relayed to the visualisation channel.
+ */
+struct RelayRoute {
+    uint16_t channel;
+    int32_t dataType;
+};
+
+// Matches every message type on the channel.
+static const int32_t ANY_DATA_TYPE = -1;
+
+/**
+ * The message types to relay per channel. Looked up for every envelope received, so a channel keeps its types sorted
+ * and there are only ever a handful of channels to go through.
+ */
+class RelayTable {
+public:
+    RelayTable();
+
+    template <size_t N>
+    explicit RelayTable(const RelayRoute (&routes)[N]) {
+        for (const RelayRoute &route : routes) {
+            allow(route.channel, route.dataType);
+        }
+    }
+
+    static bool parse(const std::string &spec, RelayTable &table);
+
+    void allow(uint16_t channel, int32_t dataType);
+    bool relays(uint16_t channel, int32_t dataType) const;
+
+    std::vector<uint16_t> channels() const;
+    std::string toString() const;
+
+private:
+    struct Channel {
+        uint16_t channel;
+        bool any;
+        std::vector<int32_t> dataTypes;
+    };
+
+    std::vector<Channel> entries;
+};
+
+#endif // VISUALISATION_RELAY_TABLE
@@ -6,153 +6,102 @@
 */
 
 /**
- * Implementation of the V2VService class as declared in v2v.hpp
+ * Implementation of the VIZService class as declared in visualisation.hpp
  */
-VIZService::VIZService(std::string ip, std::string groupId) {
-    followerIp = "";
-    leaderIp = "";
-    myIp = ip;
-    myGroupId = groupId;
-    
+
+/**
+ * Constructor for the VIZService, starts relaying right away.
+ *
+ * @param table - the messages to relay, per channel
+ * @param rules - how often to relay them, per message type
+ * @param visualisationChannel - channel to relay to, the one the viewer listens to
+ */
+VIZService::VIZService(const RelayTable &table, const std::vector<DecimationRule> &rules,
+                       uint16_t visualisationChannel) :
+    relayTable(table), relayed(0), filtered(0),
+    decimator(rules, [this](cluon::data::Envelope &&envelope) {
+        visualisation->send(std::move(envelope));
+        relayed++;
+    }),
+    flushing(false) {
 
 //visualisation OD4Session
 // This channel listens to the motor channel, the internal channel and the broadcast channel
 // This channel is used for the visualisation microservice 
    visualisation = std::make_shared<cluon::OD4Session>(
-        VISUALIZATION_CHANNEL,
+        visualisationChannel,
         [](cluon::data::Envelope &&) noexcept {}
     ); // end visualisation declaration
 
-
+    // Messages held back by the decimator go out from a thread of its own, whether more come in or not.
+    if (decimator.needsFlushing()) {
+        flushing = true;
+        flusher = std::thread([this]() {
+            while (flushing) {
+                std::this_thread::sleep_for(DECIMATION_TICK);
+                std::lock_guard<std::mutex> lock(decimationMutex);
+                decimator.flush(std::chrono::steady_clock::now());
+            }
+        });
+    }
 
     /*
-     * The broadcast field contains a reference to the broadcast channel which is an OD4Session. This is where
-     * AnnouncePresence messages will be received.
+     * Every channel in the relay table gets a session of its own, an OD4Session only ever listens to one. They all
+     * hand what they receive to relay, which decides from the table alone, without decoding anything.
      */
-    broadcast = std::make_shared<cluon::OD4Session>(
-            BROADCAST_CHANNEL,
-            [this](cluon::data::Envelope &&envelope) noexcept {
-                std::cout << "[OD4] ";
-                switch (envelope.dataType()) {
-                    case ANNOUNCE_PRESENCE: {
-                        AnnouncePresence ap = cluon::extractMessage<AnnouncePresence>(std::move(envelope));
-						visualisation->send(ap);
-                        
-                        break;
-                    }
-                    default: 
-                        std::cout << "¯\\_(ツ)_/¯" << std::endl;
-                        break;
-                }
-            });
-    
-            
-    //internal communication
-    internalBroadCast = std::make_shared<cluon::OD4Session>(
-        INTERNAL_BROADCAST_CHANNEL,
-        [this](cluon::data::Envelope &&envelope) noexcept {
-            std::cout <<"[INTERNAL BR] ";
-            
-            
-            switch (envelope.dataType()) {
-
-		     // Directed communication
-		     case FOLLOW_REQUEST: {
-			FollowRequest msg = cluon::extractMessage<FollowRequest>(std::move(envelope));
-			visualisation->send(msg);
-                             
-                         break;
-                     }
-                     case FOLLOW_RESPONSE: {
-			FollowResponse msg = cluon::extractMessage<FollowResponse>(std::move(envelope));
-			visualisation->send(msg);
-
-                         break;
-                     }
-                     case STOP_FOLLOW: {
-			StopFollow msg = cluon::extractMessage<StopFollow>(std::move(envelope));
-			visualisation->send(msg);
-
-                         break;
-                     }
-                     case FOLLOWER_STATUS: {
-			FollowerStatus msg = cluon::extractMessage<FollowerStatus>(std::move(envelope));
-			visualisation->send(msg);
-
-                        break;
-                    }
-                    case LEADER_STATUS: {
-			LeaderStatus msg = cluon::extractMessage<LeaderStatus>(std::move(envelope));	
-			visualisation->send(msg);			
-
-                         break;
-                     }
-
-		// Internal communication
-                case INTERNAL_ANNOUNCE_PRESENCE: {
-                    std::cout << "Announcing presence!" << std::endl;
-
-                    InternalAnnouncePresence msg = cluon::extractMessage<InternalAnnouncePresence>(std::move(envelope));
-			visualisation->send(msg);
-                    break;
-                }
-                case INTERNAL_FOLLOW_REQUEST: {
-                    InternalFollowRequest msg = cluon::extractMessage<InternalFollowRequest>(std::move(envelope));
-			visualisation->send(msg);
+    for (uint16_t channel : relayTable.channels()) {
+        sources.push_back(std::make_shared<cluon::OD4Session>(
+            channel,
+            [this, channel](cluon::data::Envelope &&envelope) noexcept {
+                relay(channel, std::move(envelope));
+            }));
+    }
+}
 
-                    break;
-                 }
-                 case INTERNAL_STOP_FOLLOW_REQUEST: {
-                     InternalStopFollow msg = cluon::extractMessage<InternalStopFollow>(std::move(envelope));
-			visualisation->send(msg);
+/**
+ * Destructor for the VIZService, stops the flusher thread. The sessions stop before anything they relay to goes away.
+ */
+VIZService::~VIZService() {
+    flushing = false;
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+}
 
-                     break;
-                 }
-                 case INTERNAL_GET_ALL_GROUPS_REQUEST: {
-                     InternalGetAllGroupsRequest msg = cluon::extractMessage<InternalGetAllGroupsRequest>(std::move(envelope));
-			visualisation->send(msg);
+/**
+ * Relays an envelope received on one of our channels to the visualisation channel if the relay table says so, at the
+ * rate the decimator allows for its type. The envelope goes out as it came in, its payload is never decoded and
+ * encoded again and its sender and time stamps are kept.
+ *
+ * @param channel - channel the envelope was received on
+ * @param envelope - the envelope
+ */
+void VIZService::relay(uint16_t channel, cluon::data::Envelope &&envelope) {
+    if (!relayTable.relays(channel, envelope.dataType())) {
+        filtered++;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(decimationMutex);
+    decimator.offer(std::move(envelope), std::chrono::steady_clock::now());
+}
 
-                break;
-                }
-                case INTERNAL_EMERGENCY_BRAKE: {
-                    InternalEmergencyBrake msg = cluon::extractMessage<InternalEmergencyBrake>(std::move(envelope));
-		visualisation->send(msg);
+/**
+ * @return number of envelopes relayed
+ */
+uint64_t VIZService::getRelayed() const {
+    return relayed;
+}
 
-                    break;
-                }
-                default: 
-                    std::cout << "¯\\_(ツ)_/¯" << std::endl;
-                    break;
-            }
-         }
-    );
-    
-    motorBroadcast = std::make_shared<cluon::OD4Session>(
-        MOTOR_BROADCAST_CHANNEL,
-        [this](cluon::data::Envelope &&envelope) noexcept {
-            
-            using namespace opendlv::proxy;
-            switch (envelope.dataType()) {
+/**
+ * @return number of envelopes not relayed because of their type
+ */
+uint64_t VIZService::getFiltered() const {
+    return filtered;
+}
 
-		 case DISTANCE_READING: {
-                    DistanceReading msg = cluon::extractMessage<DistanceReading>(std::move(envelope));
-					visualisation->send(msg);
-                    break;
-		}
-                case PEDAL_POSITION_READING: {
-                    PedalPositionReading msg = cluon::extractMessage<PedalPositionReading>(std::move(envelope));
-					visualisation->send(msg);
-                    break;
-                }
-                case GROUND_STEERING_READING: {
-                    GroundSteeringReading msg = cluon::extractMessage<GroundSteeringReading>(std::move(envelope));
-					visualisation->send(msg);
-                    break;
-                }
-                default:
-                    std::cout << "Received a message that was not understood" << std::endl;
-                    break;
-            }
-        }
-    );
+/**
+ * @return number of envelopes not relayed to keep to the rate of their type
+ */
+uint64_t VIZService::getDecimated() const {
+    return decimator.decimated();
 }
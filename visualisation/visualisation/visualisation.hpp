@@ -4,8 +4,13 @@
 #include <iomanip>
 #include <cstdint>
 #include <sys/time.h>
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include <pthread.h>
 
 #include "cluon/OD4Session.hpp"
@@ -14,6 +19,9 @@
 #include "cluon/Envelope.hpp"
 #include "messages.hpp"
 
+#include "relay_table.hpp"
+#include "decimator.hpp"
+
 // V2V external
 static const int BROADCAST_CHANNEL = 250;
 static const int VISUALIZATION_CHANNEL = 182;
@@ -47,6 +55,40 @@ static const int PEDAL_POSITION_READING = 1041;
 static const int GROUND_STEERING_READING = 1045;
 
 
+// What VIZService relays unless told otherwise: the V2V messages, the internal requests and the motor readings.
+static const RelayRoute DEFAULT_RELAY_ROUTES[] = {
+    {BROADCAST_CHANNEL, ANNOUNCE_PRESENCE},
+    {INTERNAL_BROADCAST_CHANNEL, FOLLOW_REQUEST},
+    {INTERNAL_BROADCAST_CHANNEL, FOLLOW_RESPONSE},
+    {INTERNAL_BROADCAST_CHANNEL, STOP_FOLLOW},
+    {INTERNAL_BROADCAST_CHANNEL, LEADER_STATUS},
+    {INTERNAL_BROADCAST_CHANNEL, FOLLOWER_STATUS},
+    {INTERNAL_BROADCAST_CHANNEL, INTERNAL_FOLLOW_REQUEST},
+    {INTERNAL_BROADCAST_CHANNEL, INTERNAL_STOP_FOLLOW_REQUEST},
+    {INTERNAL_BROADCAST_CHANNEL, INTERNAL_GET_ALL_GROUPS_REQUEST},
+    {INTERNAL_BROADCAST_CHANNEL, INTERNAL_EMERGENCY_BRAKE},
+    {INTERNAL_BROADCAST_CHANNEL, INTERNAL_ANNOUNCE_PRESENCE},
+    {MOTOR_BROADCAST_CHANNEL, DISTANCE_READING},
+    {MOTOR_BROADCAST_CHANNEL, PEDAL_POSITION_READING},
+    {MOTOR_BROADCAST_CHANNEL, GROUND_STEERING_READING},
+};
+
+/*
+ * What VIZService holds back unless told otherwise. The viewer redraws four times a second, the readings and statuses
+ * that come in at up to the rate of the motor channel are kept to ten a second.
+ */
+static const DecimationRule DEFAULT_DECIMATION_RULES[] = {
+    {PEDAL_POSITION_READING, Decimation::LATEST, std::chrono::milliseconds(100)},
+    {GROUND_STEERING_READING, Decimation::LATEST, std::chrono::milliseconds(100)},
+    {DISTANCE_READING, Decimation::AGGREGATE, std::chrono::milliseconds(250)},
+    {LEADER_STATUS, Decimation::LATEST, std::chrono::milliseconds(100)},
+    {FOLLOWER_STATUS, Decimation::LATEST, std::chrono::milliseconds(100)},
+};
+
+inline std::vector<DecimationRule> defaultDecimationRules() {
+    return std::vector<DecimationRule>(std::begin(DEFAULT_DECIMATION_RULES), std::end(DEFAULT_DECIMATION_RULES));
+}
+
 struct CarStatus {
     float speed;
     float steeringAngle;
@@ -57,21 +99,32 @@ struct CarStatus {
 
 class VIZService {
 public:
-    VIZService(std::string ip, std::string groupId);
+    VIZService(const RelayTable &table = RelayTable(DEFAULT_RELAY_ROUTES),
+               const std::vector<DecimationRule> &rules = defaultDecimationRules(),
+               uint16_t visualisationChannel = VISUALIZATION_CHANNEL);
+    ~VIZService();
 
+    void relay(uint16_t channel, cluon::data::Envelope &&envelope);
 
-    std::string leaderIp;
-    std::string followerIp;
+    uint64_t getRelayed() const;
+    uint64_t getFiltered() const;
+    uint64_t getDecimated() const;
 
 private:
+    const RelayTable relayTable;
+    std::atomic<uint64_t> relayed;
+    std::atomic<uint64_t> filtered;
 
-    std::string myIp;
-    std::string myGroupId;
-    
-    std::shared_ptr<cluon::OD4Session>  motorBroadcast;
     std::shared_ptr<cluon::OD4Session>  visualisation;
-    std::shared_ptr<cluon::OD4Session>  internalBroadCast;
-    std::shared_ptr<cluon::OD4Session>  broadcast;
+
+    // Relays from every channel and the flusher thread take turns, guarded by decimationMutex.
+    std::mutex decimationMutex;
+    Decimator decimator;
+    std::atomic<bool> flushing;
+    std::thread flusher;
+
+    // One session per channel in the relay table, declared last so they stop before what they relay to goes away.
+    std::vector<std::shared_ptr<cluon::OD4Session>> sources;
 };
 
 #endif // VISUALISATION